@@ -0,0 +1,93 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(DEBUG) || defined(_DEBUG)
+
+static std::atomic<long long> allocationCount(0);
+static std::atomic<long long> liveBytes(0);
+static std::atomic<long long> peakBytes(0);
+
+// Each block starts with its size, padded so the memory after it keeps
+// malloc's alignment
+static const size_t sizeHeader = 16;
+
+long long AllocationCounter::GetCount()
+{
+	return allocationCount.load(std::memory_order_relaxed);
+}
+
+long long AllocationCounter::GetLiveBytes()
+{
+	return liveBytes.load(std::memory_order_relaxed);
+}
+
+long long AllocationCounter::GetPeakBytes()
+{
+	return peakBytes.load(std::memory_order_relaxed);
+}
+
+void AllocationCounter::ResetPeakBytes()
+{
+	peakBytes.store(liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+// Replacements for the global allocation functions - the array and
+// nothrow versions forward to these by default
+void* operator new(size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+	unsigned char* memory = (unsigned char*)malloc(sizeHeader + size);
+	if (!memory)
+		throw std::bad_alloc();
+	*(size_t*)memory = size;
+
+	long long live = liveBytes.fetch_add((long long)size, std::memory_order_relaxed) + (long long)size;
+	long long peak = peakBytes.load(std::memory_order_relaxed);
+	while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+	{
+	}
+	return memory + sizeHeader;
+}
+
+void operator delete(void* memory) noexcept
+{
+	if (!memory)
+		return;
+
+	unsigned char* block = (unsigned char*)memory - sizeHeader;
+	liveBytes.fetch_sub((long long)*(size_t*)block, std::memory_order_relaxed);
+	free(block);
+}
+
+// Sized delete - the header already records the size, so this just
+// forwards to the unsized version
+void operator delete(void* memory, size_t) noexcept
+{
+	operator delete(memory);
+}
+
+#else
+
+long long AllocationCounter::GetCount()
+{
+	return 0;
+}
+
+long long AllocationCounter::GetLiveBytes()
+{
+	return 0;
+}
+
+long long AllocationCounter::GetPeakBytes()
+{
+	return 0;
+}
+
+void AllocationCounter::ResetPeakBytes()
+{
+}
+
+#endif
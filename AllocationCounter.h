@@ -0,0 +1,19 @@
+#pragma once
+
+// --------------------------------------------------------
+// Counts every call to the global operator new in debug
+// builds, so a frame can be checked for heap allocations,
+// along with the bytes they hold.
+// Release builds use the default allocator and report 0.
+// --------------------------------------------------------
+namespace AllocationCounter
+{
+	long long GetCount();
+
+	// Bytes allocated through operator new and not deleted yet
+	long long GetLiveBytes();
+
+	// Highest GetLiveBytes since the last ResetPeakBytes
+	long long GetPeakBytes();
+	void ResetPeakBytes();
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// Local-space bounds of a mesh, computed once when it loads
+// and shared by every collider that uses that mesh
+// --------------------------------------------------------
+struct MeshBounds
+{
+	DirectX::XMFLOAT3 Min;		// AABB min corner
+	DirectX::XMFLOAT3 Max;		// AABB max corner
+	DirectX::XMFLOAT3 Center;	// Bounding sphere center (AABB center)
+	float Radius;				// Bounding sphere radius
+};
@@ -0,0 +1,209 @@
+#include "Broadphase.h"
+#include <emmintrin.h>
+#include <cfloat>
+
+Broadphase::Broadphase()
+{
+	// Nothing to set up, everything grows on demand
+}
+
+Broadphase::~Broadphase()
+{
+	// Nothing to delete
+}
+
+int Broadphase::CreateProxy(unsigned int layer, unsigned int mask, void* userData)
+{
+	int proxy;
+
+	// reuse a destroyed slot if we have one
+	if (!freeProxies.empty())
+	{
+		proxy = freeProxies.back();
+		freeProxies.pop_back();
+	}
+	else
+	{
+		proxy = (int)proxyMin.size();
+		proxyMin.push_back(DirectX::XMFLOAT3(0, 0, 0));
+		proxyMax.push_back(DirectX::XMFLOAT3(0, 0, 0));
+		proxyLayer.push_back(0);
+		proxyMask.push_back(0);
+		proxyUserData.push_back(0);
+		proxyAlive.push_back(false);
+	}
+
+	proxyMin[proxy] = DirectX::XMFLOAT3(0, 0, 0);
+	proxyMax[proxy] = DirectX::XMFLOAT3(0, 0, 0);
+	proxyLayer[proxy] = layer;
+	proxyMask[proxy] = mask;
+	proxyUserData[proxy] = userData;
+	proxyAlive[proxy] = true;
+
+	// new proxies go on the end, the next sort moves them into place
+	order.push_back(proxy);
+
+	return proxy;
+}
+
+void Broadphase::DestroyProxy(int proxy)
+{
+	if (proxy < 0 || proxy >= (int)proxyAlive.size() || !proxyAlive[proxy])
+		return;
+
+	proxyAlive[proxy] = false;
+	proxyUserData[proxy] = 0;
+
+	// the order list gets compacted lazily before the next sweep
+	pendingFree.push_back(proxy);
+}
+
+void Broadphase::SetExtents(int proxy, DirectX::XMFLOAT3 minCoord, DirectX::XMFLOAT3 maxCoord)
+{
+	proxyMin[proxy] = minCoord;
+	proxyMax[proxy] = maxCoord;
+}
+
+void* Broadphase::GetUserData(int proxy)
+{
+	return proxyUserData[proxy];
+}
+
+unsigned int Broadphase::GetLayer(int proxy)
+{
+	return proxyLayer[proxy];
+}
+
+int Broadphase::GetProxyCount()
+{
+	return (int)(order.size() - pendingFree.size());
+}
+
+void Broadphase::SortOrder()
+{
+	// drop destroyed proxies while keeping the relative order of the rest
+	if (!pendingFree.empty())
+	{
+		size_t live = 0;
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			if (proxyAlive[order[i]])
+			{
+				order[live++] = order[i];
+			}
+		}
+		order.resize(live);
+
+		// only now that they're out of the order list can the slots be reused
+		freeProxies.insert(freeProxies.end(), pendingFree.begin(), pendingFree.end());
+		pendingFree.clear();
+	}
+
+	// insertion sort on min x - almost linear since the order barely changes between frames
+	for (size_t i = 1; i < order.size(); i++)
+	{
+		int id = order[i];
+		float key = proxyMin[id].x;
+		size_t j = i;
+		while (j > 0 && proxyMin[order[j - 1]].x > key)
+		{
+			order[j] = order[j - 1];
+			j--;
+		}
+		order[j] = id;
+	}
+}
+
+void Broadphase::GatherSorted()
+{
+	size_t count = order.size();
+
+	// pad so a four-wide load starting at any live proxy stays in bounds
+	size_t padded = count + 4;
+	sortedMinX.resize(padded);
+	sortedMaxX.resize(padded);
+	sortedMinZ.resize(padded);
+	sortedMaxZ.resize(padded);
+	sortedLayer.resize(padded);
+	sortedMask.resize(padded);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		int id = order[i];
+		sortedMinX[i] = proxyMin[id].x;
+		sortedMaxX[i] = proxyMax[id].x;
+		sortedMinZ[i] = proxyMin[id].z;
+		sortedMaxZ[i] = proxyMax[id].z;
+		sortedLayer[i] = proxyLayer[id];
+		sortedMask[i] = proxyMask[id];
+	}
+
+	// padding never overlaps anything and never passes the layer filter
+	for (size_t i = count; i < padded; i++)
+	{
+		sortedMinX[i] = FLT_MAX;
+		sortedMaxX[i] = -FLT_MAX;
+		sortedMinZ[i] = FLT_MAX;
+		sortedMaxZ[i] = -FLT_MAX;
+		sortedLayer[i] = 0;
+		sortedMask[i] = 0;
+	}
+}
+
+const std::vector<BroadphasePair>& Broadphase::FindPairs()
+{
+	pairs.clear();
+
+	SortOrder();
+	GatherSorted();
+
+	int count = (int)order.size();
+	const __m128i zero = _mm_setzero_si128();
+
+	for (int i = 0; i < count; i++)
+	{
+		__m128 maxXi = _mm_set1_ps(sortedMaxX[i]);
+		__m128 minZi = _mm_set1_ps(sortedMinZ[i]);
+		__m128 maxZi = _mm_set1_ps(sortedMaxZ[i]);
+		__m128i layerI = _mm_set1_epi32((int)sortedLayer[i]);
+		__m128i maskI = _mm_set1_epi32((int)sortedMask[i]);
+
+		// everything after i starts at or after i's min x, so only
+		// the start of each candidate needs checking along x
+		for (int j = i + 1; j < count; j += 4)
+		{
+			__m128 overlapX = _mm_cmple_ps(_mm_loadu_ps(&sortedMinX[j]), maxXi);
+
+			// sorted along x, so once a whole group starts past us nothing later can overlap
+			int xBits = _mm_movemask_ps(overlapX);
+			if (xBits == 0)
+				break;
+
+			__m128 overlapZ = _mm_and_ps(
+				_mm_cmple_ps(_mm_loadu_ps(&sortedMinZ[j]), maxZi),
+				_mm_cmpge_ps(_mm_loadu_ps(&sortedMaxZ[j]), minZi));
+
+			// (layerJ & maskI) | (layerI & maskJ) must be non-zero
+			__m128i layerJ = _mm_loadu_si128((const __m128i*)&sortedLayer[j]);
+			__m128i maskJ = _mm_loadu_si128((const __m128i*)&sortedMask[j]);
+			__m128i filter = _mm_or_si128(_mm_and_si128(layerJ, maskI), _mm_and_si128(layerI, maskJ));
+			__m128 passes = _mm_castsi128_ps(_mm_xor_si128(_mm_cmpeq_epi32(filter, zero), _mm_set1_epi32(-1)));
+
+			int bits = _mm_movemask_ps(_mm_and_ps(_mm_and_ps(overlapX, overlapZ), passes));
+			while (bits)
+			{
+				int lane = 0;
+				while (!(bits & (1 << lane)))
+					lane++;
+				bits &= ~(1 << lane);
+
+				BroadphasePair pair;
+				pair.proxyA = order[i];
+				pair.proxyB = order[j + lane];
+				pairs.push_back(pair);
+			}
+		}
+	}
+
+	return pairs;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+// Collision layers used to filter which proxies are allowed to pair up.
+// A pair is reported when either proxy's layer is in the other's mask.
+enum CollisionLayer
+{
+	LAYER_PLAYER = 1 << 0,
+	LAYER_PLAYER_LASER = 1 << 1,
+	LAYER_ENEMY = 1 << 2,
+	LAYER_ENEMY_LASER = 1 << 3
+};
+
+// A potentially overlapping pair of proxies (a always sorts before b along X)
+struct BroadphasePair
+{
+	int proxyA;
+	int proxyB;
+};
+
+// --------------------------------------------------------
+// Sweep-and-prune broadphase on the XZ plane
+//
+// Extents are kept in structure-of-arrays form and the sweep
+// order along X is reused between frames, so an insertion sort
+// is nearly linear when things only move a little each frame.
+// Overlap is tested against four candidates at once with SSE.
+// --------------------------------------------------------
+class Broadphase
+{
+	// per-proxy data, indexed by proxy id
+	std::vector<DirectX::XMFLOAT3> proxyMin;
+	std::vector<DirectX::XMFLOAT3> proxyMax;
+	std::vector<unsigned int> proxyLayer;
+	std::vector<unsigned int> proxyMask;
+	std::vector<void*> proxyUserData;
+	std::vector<bool> proxyAlive;
+	std::vector<int> freeProxies;
+	std::vector<int> pendingFree;
+
+	// proxy ids in sweep order (persists between frames)
+	std::vector<int> order;
+
+	// sorted SoA extents, padded to a multiple of four
+	std::vector<float> sortedMinX;
+	std::vector<float> sortedMaxX;
+	std::vector<float> sortedMinZ;
+	std::vector<float> sortedMaxZ;
+	std::vector<unsigned int> sortedLayer;
+	std::vector<unsigned int> sortedMask;
+
+	std::vector<BroadphasePair> pairs;
+
+	void SortOrder();
+	void GatherSorted();
+public:
+	Broadphase();
+	~Broadphase();
+
+	// proxies are created once per collider and live until destroyed
+	int CreateProxy(unsigned int layer, unsigned int mask, void* userData);
+	void DestroyProxy(int proxy);
+	void SetExtents(int proxy, DirectX::XMFLOAT3 minCoord, DirectX::XMFLOAT3 maxCoord);
+
+	void* GetUserData(int proxy);
+	unsigned int GetLayer(int proxy);
+	int GetProxyCount();
+
+	// sorts and sweeps, returning every overlapping pair that passes the layer filter
+	const std::vector<BroadphasePair>& FindPairs();
+};
@@ -1,91 +1,69 @@
 #include "Collision.h"
-Collision::Collision(std::vector<Vertex> vertices)
+Collision::Collision(const MeshBounds& bounds)
 {
-	minCoord = DirectX::XMFLOAT3();
-	maxCoord = DirectX::XMFLOAT3();
-	this->vertices = vertices;
+	this->bounds = &bounds;
+	position = DirectX::XMFLOAT3(0, 0, 0);
+	scale = DirectX::XMFLOAT3(1, 1, 1);
+	broadphase = 0;
+	proxy = -1;
+	UpdateBox();
 }
 
 Collision::~Collision()
 {
-	vertices.clear();
+	if (broadphase)
+	{
+		broadphase->DestroyProxy(proxy);
+	}
 }
 
-void Collision::SetPosition(DirectX::XMFLOAT3 pos)
+void Collision::AttachToBroadphase(Broadphase* broadphase, unsigned int layer, unsigned int mask, void* userData)
 {
-	float halfWidthX = (maxCoord.x - minCoord.x) / 2;
-	float halfWidthY = (maxCoord.y - minCoord.y) / 2;
-	float halfWidthZ = (maxCoord.z - minCoord.z) / 2;
-
-	minCoord.x = pos.x - halfWidthX;
-	minCoord.y = pos.y - halfWidthY;
-	minCoord.z = pos.z - halfWidthZ;
-	maxCoord.x = pos.x + halfWidthX;
-	maxCoord.y = pos.y + halfWidthY;
-	maxCoord.z = pos.z + halfWidthZ;
+	this->broadphase = broadphase;
+	proxy = broadphase->CreateProxy(layer, mask, userData);
+	UpdateProxy();
 }
 
-//will be done for next milestone
-void Collision::SetScale(DirectX::XMFLOAT3 scale)
+int Collision::GetProxy()
 {
-	float halfWidthX = (maxCoord.x - minCoord.x) / 2;
-	float halfWidthY = (maxCoord.y - minCoord.y) / 2;
-	float halfWidthZ = (maxCoord.z - minCoord.z) / 2;
-
-	DirectX::XMFLOAT3 center = {maxCoord.x - halfWidthX, maxCoord.y - halfWidthY, maxCoord.z = halfWidthZ};
-
-	halfWidthX *= scale.x;
-	halfWidthY *= scale.y;
-	halfWidthZ *= scale.z;
-
-	maxCoord = { center.x + halfWidthX, center.y + halfWidthY, center.z + halfWidthZ };
-	minCoord = { center.x - halfWidthX, center.y - halfWidthY, center.z - halfWidthZ };
-	//minCoord.x 
-	
+	return proxy;
 }
 
-void Collision::GenAABB(std::vector<Vertex> vertices)
+void Collision::UpdateProxy()
 {
-	DirectX::XMFLOAT3 minX = { (float)INT_MAX, 0, 0 };
-	DirectX::XMFLOAT3 minY = { 0, (float)INT_MAX, 0 };
-	DirectX::XMFLOAT3 minZ = { 0, 0, (float)INT_MAX };
-
-	DirectX::XMFLOAT3 maxX = { (float)INT_MIN, 0, 0 };
-	DirectX::XMFLOAT3 maxY = { 0, (float)INT_MIN, 0 };
-	DirectX::XMFLOAT3 maxZ = { 0, 0, (float)INT_MIN };
-
-	for (int i = 0; i < vertices.size(); i++)
+	if (broadphase)
 	{
-		if (vertices[i].Position.x < minX.x)
-		{
-			minX = vertices[i].Position;
-		}
-		if (vertices[i].Position.y < minY.y)
-		{
-			minY = vertices[i].Position;
-		}
-		if (vertices[i].Position.z < minZ.z)
-		{
-			minZ = vertices[i].Position;
-		}
-
-		if (vertices[i].Position.x > maxX.x)
-		{
-			maxX = vertices[i].Position;
-		}
-		if (vertices[i].Position.y > maxY.y)
-		{
-			maxY = vertices[i].Position;
-		}
-		if (vertices[i].Position.z > maxZ.z)
-		{
-			maxZ = vertices[i].Position;
-		}
+		broadphase->SetExtents(proxy, minCoord, maxCoord);
 	}
+}
 
-	//this gives us the bottom left and top right corners.
-	minCoord = { minX.x, minY.y, minZ.z };
-	maxCoord = { maxX.x, maxY.y, maxZ.z };
+void Collision::UpdateBox()
+{
+	//the box is centered on the entity's position, sized by the scaled local extents
+	float halfWidthX = (bounds->Max.x - bounds->Min.x) / 2 * scale.x;
+	float halfWidthY = (bounds->Max.y - bounds->Min.y) / 2 * scale.y;
+	float halfWidthZ = (bounds->Max.z - bounds->Min.z) / 2 * scale.z;
+
+	minCoord.x = position.x - halfWidthX;
+	minCoord.y = position.y - halfWidthY;
+	minCoord.z = position.z - halfWidthZ;
+	maxCoord.x = position.x + halfWidthX;
+	maxCoord.y = position.y + halfWidthY;
+	maxCoord.z = position.z + halfWidthZ;
+
+	UpdateProxy();
+}
+
+void Collision::SetPosition(DirectX::XMFLOAT3 pos)
+{
+	position = pos;
+	UpdateBox();
+}
+
+void Collision::SetScale(DirectX::XMFLOAT3 scale)
+{
+	this->scale = scale;
+	UpdateBox();
 }
 
 bool Collision::CheckCollision(Collision* other)
@@ -135,4 +113,9 @@ DirectX::XMFLOAT3 Collision::GetMinCoord()
 DirectX::XMFLOAT3 Collision::GetMaxCoord()
 {
 	return this->maxCoord;
+}
+
+const MeshBounds& Collision::GetLocalBounds()
+{
+	return *bounds;
 }
\ No newline at end of file
@@ -1,31 +1,46 @@
 #pragma once
 #include "Vertex.h"
-#include <climits>
-#include <vector>
+#include "Bounds.h"
 #include <iostream>
+#include "Broadphase.h"
 class Collision
 {
-	//store the vertices locally
-	std::vector<Vertex> vertices;
+	//local bounds are owned by the mesh, so spawning a collider copies nothing
+	const MeshBounds* bounds;
 
+	//transform applied to the local bounds
+	DirectX::XMFLOAT3 position;
+	DirectX::XMFLOAT3 scale;
+
+	//world space box
 	DirectX::XMFLOAT3 minCoord;
 	DirectX::XMFLOAT3 maxCoord;
+
+	//broadphase this collider is registered with (if any)
+	Broadphase* broadphase;
+	int proxy;
+
+	//rebuilds the world box from the local bounds and transform
+	void UpdateBox();
+	void UpdateProxy();
 public:
-	//Collision constructors -- you can either pass in the entire vertex array from the model, or pass in the mesh (and it will grab the vertices from there)
-	Collision(std::vector<Vertex> vertices);
+	//Collision constructor -- takes the local bounds of the mesh this collider wraps
+	Collision(const MeshBounds& bounds);
 	~Collision();
 	//check for collisions using this collider's AABB and another collider's AABB
 	bool CheckCollision(Collision* other);
 
-	//generates an AABB collision box based on the vertices given
-	void GenAABB(std::vector<Vertex> vertices);
-
 	//helper methods to get the coordinates of a min/max in space.
 
 	DirectX::XMFLOAT3 GetMinCoord();
 	DirectX::XMFLOAT3 GetMaxCoord();
+	const MeshBounds& GetLocalBounds();
 
 	void SetPosition(DirectX::XMFLOAT3 pos);
 	void SetScale(DirectX::XMFLOAT3 scale);
+
+	//registers this collider with a broadphase, which is kept up to date as the box moves
+	void AttachToBroadphase(Broadphase* broadphase, unsigned int layer, unsigned int mask, void* userData);
+	int GetProxy();
 };
 
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include "Bounds.h"
+
+class Mesh;
+class Material;
+
+// --------------------------------------------------------
+// Component types for the World.  Each has a bit in the
+// archetype mask; an archetype stores one dense array per
+// component in its mask.
+// --------------------------------------------------------
+enum ComponentMask
+{
+	COMPONENT_TRANSFORM = 1 << 0,
+	COMPONENT_VELOCITY = 1 << 1,
+	COMPONENT_COLLIDER = 1 << 2,
+	COMPONENT_RENDER = 1 << 3,
+	COMPONENT_TEAM = 1 << 4,
+	COMPONENT_LIFETIME = 1 << 5,
+	COMPONENT_CULL_BOUNDS = 1 << 6
+};
+
+// Which side an entity is on - drives scoring and who can hit whom
+enum Team
+{
+	TEAM_PLAYER_LASER,
+	TEAM_ENEMY_LEFT,	// Spawns on the left, flies right
+	TEAM_ENEMY_RIGHT,	// Spawns on the right, flies left
+	TEAM_ENEMY_LASER
+};
+
+struct TransformComponent
+{
+	DirectX::XMFLOAT4X4 World;		// Transposed, ready for the shader
+	DirectX::XMFLOAT3 Position;
+	DirectX::XMFLOAT3 Scale;
+	DirectX::XMFLOAT4 Rotation;		// Quaternion
+	bool Dirty;						// World needs rebuilding
+};
+
+struct VelocityComponent
+{
+	DirectX::XMFLOAT3 Velocity;
+};
+
+struct ColliderComponent
+{
+	const MeshBounds* Bounds;		// Owned by the mesh
+	DirectX::XMFLOAT3 Scale;		// Applied to the local bounds, independent of the render scale
+	int Proxy;						// Broadphase proxy
+};
+
+struct RenderComponent
+{
+	Mesh* RenderMesh;
+	Material* RenderMaterial;
+};
+
+struct TeamComponent
+{
+	Team Side;
+};
+
+struct LifetimeComponent
+{
+	float Remaining;				// Seconds until the entity is destroyed
+};
+
+struct CullBoundsComponent
+{
+	DirectX::XMFLOAT3 Min;			// Entity is destroyed once its position leaves this box
+	DirectX::XMFLOAT3 Max;
+};
@@ -1,408 +1,450 @@
 #include "Emitter.h"
 
-using namespace DirectX;
+#include <cmath>
 
-Emitter::Emitter(
-	int maxParticles,
-	int particlesPerSecond,
-	float lifetime,
-	float startSize,
-	float endSize,
-	DirectX::XMFLOAT4 startColor,
-	DirectX::XMFLOAT4 endColor,
-	DirectX::XMFLOAT3 startVelocity,
-	DirectX::XMFLOAT3 velocityRandomRange,
-	DirectX::XMFLOAT3 emitterPosition,
-	DirectX::XMFLOAT3 positionRandomRange,
-	DirectX::XMFLOAT4 rotationRandomRanges,
-	DirectX::XMFLOAT3 emitterAcceleration,
-	ID3D11Device* device,
-	SimpleVertexShader* vs,
-	SimplePixelShader* ps,
-	ID3D11ShaderResourceView* texture,
-	bool isSpriteSheet,
-	unsigned int spriteSheetWidth ,
-	unsigned int spriteSheetHeight 
-	)
-{
-	// Save params
-	this->vs = vs;
-	this->ps = ps;
-	this->texture = texture;
-
-	this->isSpriteSheet = isSpriteSheet;
-	this->spriteSheetWidth = max(spriteSheetWidth, 1);
-	this->spriteSheetHeight = max(spriteSheetHeight, 1);
-	this->spriteSheetFrameWidth = 1.0f / this->spriteSheetWidth;
-	this->spriteSheetFrameHeight = 1.0f / this->spriteSheetHeight;
-
-	this->maxParticles = maxParticles;
-	this->lifetime = lifetime;
-	this->startColor = startColor;
-	this->endColor = endColor;
-	this->startVelocity = startVelocity;
-	this->startSize = startSize;
-	this->endSize = endSize;
-	this->particlesPerSecond = particlesPerSecond;
-	this->secondsPerParticle = 1.0f / particlesPerSecond;
-
-	this->velocityRandomRange = velocityRandomRange;
-	this->positionRandomRange = positionRandomRange;
-	this->rotationRandomRanges = rotationRandomRanges;
+using namespace DirectX;
 
+Emitter::Emitter(const EmitterSettings* settings, XMFLOAT3 emitterPosition, int spanOffset, int spanSize, unsigned long long seed)
+	: random(seed)
+{
+	this->settings = settings;
 	this->emitterPosition = emitterPosition;
-	this->emitterAcceleration = emitterAcceleration;
+	this->spanOffset = spanOffset;
+	this->spanSize = spanSize;
 
+	totalDuration = settings->Duration;
 	timeSinceEmit = 0;
+	nextBurst = 0;
+
+	// Full budget until told otherwise
+	particleLimit = settings->MaxParticles;
+	emissionScale = 1.0f;
+	visibility = 0.0f;
+	boundingRadius = CalculateBoundingRadius(settings);
+	features = CalculateFeatures(settings);
+	CalculateBounds();
+	culled = false;
+	stale = false;
+
+	// Everything a spawned particle starts with, other than its random numbers
+	spawnParams.Position = emitterPosition;
+	spawnParams.PositionRange = settings->PositionRandomRange;
+	spawnParams.Velocity = settings->StartVelocity;
+	spawnParams.VelocityRange = settings->VelocityRandomRange;
+	spawnParams.RotationRanges = settings->RotationRandomRanges;
+	spawnParams.Size = settings->Curves.Size[0];
+	spawnParams.Color = XMFLOAT4(settings->Curves.R[0], settings->Curves.G[0], settings->Curves.B[0], settings->Curves.A[0]);
+	spawnParams.Age = 0.0f;
+
 	livingParticleCount = 0;
 	firstAliveIndex = 0;
 	firstDeadIndex = 0;
 
-	// Make the particle array
-	particles = new Particle[maxParticles];
-	ZeroMemory(particles, sizeof(Particle) * maxParticles);
-
-	// Create local particle vertices
+	// Nothing in the span needs clearing - only the living range is ever read,
+	// and every particle is fully reset when it spawns
+}
 
-	DefaultUVs[0] = XMFLOAT2(0, 0);
-	DefaultUVs[1] = XMFLOAT2(1, 0);
-	DefaultUVs[2] = XMFLOAT2(1, 1);
-	DefaultUVs[3] = XMFLOAT2(0, 1);
+void Emitter::Start(const ParticleArrays& particles)
+{
+	SpawnParticles(DueBurstParticles(0.0f), particles);
+}
 
-	// Create UV's here, as those will usually stay the same
-	localParticleVertices = new ParticleVertex[4 * maxParticles];
-	for (int i = 0; i < maxParticles * 4; i += 4)
+void Emitter::FastForward(float time, const ParticleArrays& particles)
+{
+	if (!settings->Analytic)
 	{
-		localParticleVertices[i + 0].UV = DefaultUVs[0];
-		localParticleVertices[i + 1].UV = DefaultUVs[1];
-		localParticleVertices[i + 2].UV = DefaultUVs[2];
-		localParticleVertices[i + 3].UV = DefaultUVs[3];
+		const float step = 1.0f / 60.0f;
+		for (; time > 0.0f && totalDuration > 0.0f; time -= step)
+			Update(time < step ? time : step, particles);
+		return;
 	}
 
-	for (int i = 0; i < maxParticles; i++) {
-		particles[i].StartPosition = emitterPosition;
-	}
+	// Jump from one spawn to the next - nothing in between needs doing
+	float end = GetTime() + time;
+	if (end > settings->Duration)
+		end = settings->Duration;
+	bool continuous = emissionScale > 0.0f && settings->ParticlesPerSecond > 0;
+	float secondsPerParticle = continuous ? 1.0f / (settings->ParticlesPerSecond * emissionScale) : 0.0f;
+	while (true)
+	{
+		// Whichever comes first - a burst, a continuous particle or the end
+		float now = GetTime();
+		float next = end;
+		bool spawnOne = false;
+		if (nextBurst < settings->BurstCount && settings->Bursts[nextBurst].Time < next)
+			next = settings->Bursts[nextBurst].Time;
+		if (continuous && now + secondsPerParticle - timeSinceEmit < next)
+		{
+			next = now + secondsPerParticle - timeSinceEmit;
+			spawnOne = true;
+		}
+
+		totalDuration = settings->Duration - next;
+		timeSinceEmit = spawnOne ? 0.0f : timeSinceEmit + (next - now);
 
+		int deaths = CountExpired(particles);
+		firstAliveIndex = (firstAliveIndex + deaths) % settings->MaxParticles;
+		livingParticleCount -= deaths;
 
-	// Create buffers for drawing particles
+		spawnParams.Age = next;
+		SpawnParticles(DueBurstParticles(next) + (spawnOne ? 1 : 0), particles);
 
-	// DYNAMIC vertex buffer (no initial data necessary)
-	D3D11_BUFFER_DESC vbDesc = {};
-	vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	vbDesc.Usage = D3D11_USAGE_DYNAMIC;
-	vbDesc.ByteWidth = sizeof(ParticleVertex) * 4 * maxParticles;
-	device->CreateBuffer(&vbDesc, 0, &vertexBuffer);
+		if (next >= end)
+			break;
+	}
+}
+
+void Emitter::Update(float dt, const ParticleArrays& particles)
+{
+	if (!BeginUpdate(dt))
+		return;
 
-	// Index buffer data
-	unsigned int* indices = new unsigned int[maxParticles * 6];
-	int indexCount = 0;
-	for (int i = 0; i < maxParticles * 4; i += 4)
+	int deaths = 0;
+	if (!settings->Analytic)
 	{
-		indices[indexCount++] = i;
-		indices[indexCount++] = i + 1;
-		indices[indexCount++] = i + 2;
-		indices[indexCount++] = i;
-		indices[indexCount++] = i + 2;
-		indices[indexCount++] = i + 3;
+		ParticleUpdateParams params = GetUpdateParams(dt);
+		int firsts[2], counts[2];
+		int rangeCount = GetLivingRanges(firsts, counts);
+		for (int r = 0; r < rangeCount; r++)
+			deaths += ParticleKernels::Update(params, particles, firsts[r], counts[r]);
 	}
-	D3D11_SUBRESOURCE_DATA indexData = {};
-	indexData.pSysMem = indices;
 
-	// Regular (static) index buffer
-	D3D11_BUFFER_DESC ibDesc = {};
-	ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	ibDesc.CPUAccessFlags = 0;
-	ibDesc.Usage = D3D11_USAGE_DEFAULT;
-	ibDesc.ByteWidth = sizeof(unsigned int) * maxParticles * 6;
-	device->CreateBuffer(&ibDesc, &indexData, &indexBuffer);
+	FinishUpdate(dt, deaths, particles);
+}
 
-	delete[] indices;
+bool Emitter::BeginUpdate(float dt)
+{
+	totalDuration -= dt;
+	return totalDuration > 0.0f;
 }
 
+ParticleUpdateParams Emitter::GetUpdateParams(float dt)
+{
+	ParticleUpdateParams params;
+	params.DeltaTime = dt;
+	params.Lifetime = settings->Lifetime;
+	params.Curves = &settings->Curves;
+	params.Acceleration = settings->Acceleration;
+	params.Features = features;
+	return params;
+}
 
-Emitter::~Emitter()
+int Emitter::GetLivingRanges(int* firsts, int* counts)
 {
-	delete[] particles;
-	delete[] localParticleVertices;
-	vertexBuffer->Release();
-	indexBuffer->Release();
+	// Living particles may wrap around the end of the buffer
+	//
+	// 0 -------- FIRST ALIVE ----------- FIRST DEAD -------- MAX
+	// |    dead    |            alive       |         dead    |
+	//
+	// 0 -------- FIRST DEAD ----------- FIRST ALIVE -------- MAX
+	// |    alive    |            dead       |         alive   |
+	int maxParticles = settings->MaxParticles;
+	int firstHalf = livingParticleCount < maxParticles - firstAliveIndex ? livingParticleCount : maxParticles - firstAliveIndex;
+	int secondHalf = livingParticleCount - firstHalf;
+
+	int rangeCount = 0;
+	if (firstHalf > 0)
+	{
+		firsts[rangeCount] = spanOffset + firstAliveIndex;
+		counts[rangeCount++] = firstHalf;
+	}
+	if (secondHalf > 0)
+	{
+		firsts[rangeCount] = spanOffset;
+		counts[rangeCount++] = secondHalf;
+	}
+	return rangeCount;
 }
 
-void Emitter::Update(float dt)
+void Emitter::FinishUpdate(float dt, int deaths, const ParticleArrays& particles)
 {
-	totalDuration -= dt;
+	// Analytic particles haven't been touched, check their ages here
+	if (settings->Analytic)
+	{
+		deaths = CountExpired(particles);
+		spawnParams.Age = GetTime();
+	}
 
-	if (totalDuration > 0.0f) {
-		// Update all particles - Check cyclic buffer first
-		if (firstAliveIndex < firstDeadIndex)
-		{
-			// First alive is BEFORE first dead, so the "living" particles are contiguous
-			// 
-			// 0 -------- FIRST ALIVE ----------- FIRST DEAD -------- MAX
-			// |    dead    |            alive       |         dead    |
-
-			// First alive is before first dead, so no wrapping
-			for (int i = firstAliveIndex; i < firstDeadIndex; i++)
-				UpdateSingleParticle(dt, i);
-		}
-		else
-		{
-			// First alive is AFTER first dead, so the "living" particles wrap around
-			// 
-			// 0 -------- FIRST DEAD ----------- FIRST ALIVE -------- MAX
-			// |    alive    |            dead       |         alive   |
-
-			// Update first half (from firstAlive to max particles)
-			for (int i = firstAliveIndex; i < maxParticles; i++)
-				UpdateSingleParticle(dt, i);
-
-			// Update second half (from 0 to first dead)
-			for (int i = 0; i < firstDeadIndex; i++)
-				UpdateSingleParticle(dt, i);
-		}
+	// Every particle has the same lifetime, so they die in the order they
+	// were spawned - retire them by moving the first alive index
+	firstAliveIndex = (firstAliveIndex + deaths) % settings->MaxParticles;
+	livingParticleCount -= deaths;
 
-		// Add to the time
-		timeSinceEmit += dt;
+	// Bursts that are due, all spawned together with the continuous particles below
+	int spawnCount = DueBurstParticles(GetTime());
 
+	// Add to the time
+	timeSinceEmit += dt;
+
+	// A throttled-off (or burst-only) emitter doesn't save up particles for later
+	if (emissionScale <= 0.0f || settings->ParticlesPerSecond <= 0)
+		timeSinceEmit = 0;
+	else
+	{
 		// Enough time to emit?
+		float secondsPerParticle = 1.0f / (settings->ParticlesPerSecond * emissionScale);
 		while (timeSinceEmit > secondsPerParticle)
 		{
-			SpawnParticle();
+			spawnCount++;
 			timeSinceEmit -= secondsPerParticle;
 		}
 	}
-	//printf(std::to_string(livingParticleCount).c_str());
 
-	
+	SpawnParticles(spawnCount, particles);
 }
 
-void Emitter::UpdateSingleParticle(float dt, int index)
+// --------------------------------------------------------
+// Analytic particles die in birth order too, so only the ones
+// at the front of the ring need checking
+// --------------------------------------------------------
+int Emitter::CountExpired(const ParticleArrays& particles)
 {
-	// Check for valid particle age before doing anything
-	if (particles[index].Age >= lifetime)
-		return;
-
-	// Update and check for death
-	particles[index].Age += dt;
-	if (particles[index].Age >= lifetime)
+	float now = GetTime();
+	int expired = 0;
+	int index = firstAliveIndex;
+	while (expired < livingParticleCount && now - particles.Age[spanOffset + index] >= settings->Lifetime)
 	{
-		// Recent death, so retire by moving alive count
-		firstAliveIndex++;
-		firstAliveIndex %= maxParticles;
-		livingParticleCount--;
-		return;
+		expired++;
+		index = index + 1 == settings->MaxParticles ? 0 : index + 1;
 	}
-
-	// Calculate age percentage for lerp
-	float agePercent = particles[index].Age / lifetime;
-
-	// Interpolate the color
-	XMStoreFloat4(
-		&particles[index].Color,
-		XMVectorLerp(
-			XMLoadFloat4(&startColor),
-			XMLoadFloat4(&endColor),
-			agePercent));
-
-	// Interpolate the rotation
-	float rotStart = particles[index].RotationStart;
-	float rotEnd = particles[index].RotationEnd;
-	particles[index].Rotation = rotStart + agePercent * (rotEnd - rotStart);
-
-	// Interpolate the size
-	particles[index].Size = startSize + agePercent * (endSize - startSize);
-
-	// Adjust the position
-	XMVECTOR startPos = XMLoadFloat3(&particles[index].StartPosition);
-	XMVECTOR startVel = XMLoadFloat3(&particles[index].StartVelocity);
-	XMVECTOR accel = XMLoadFloat3(&emitterAcceleration);
-	float t = particles[index].Age;
-
-	// Use constant acceleration function
-	XMStoreFloat3(
-		&particles[index].Position,
-		accel * t * t / 2.0f + startVel * t + startPos);
+	return expired;
 }
 
-void Emitter::SpawnParticle()
+// --------------------------------------------------------
+// Total size of every burst scheduled up to the given time
+// since the emitter started, scaled by the budget
+// --------------------------------------------------------
+int Emitter::DueBurstParticles(float time)
 {
-	// Any left to spawn?
-	if (livingParticleCount == maxParticles)
-		return;
-
-	// Reset the first dead particle
-	particles[firstDeadIndex].Age = 0;
-	particles[firstDeadIndex].Size = startSize;
-	particles[firstDeadIndex].Color = startColor;
+	int count = 0;
+	while (nextBurst < settings->BurstCount && settings->Bursts[nextBurst].Time <= time)
+	{
+		count += (int)(settings->Bursts[nextBurst].Count * emissionScale + 0.5f);
+		nextBurst++;
+	}
+	return count;
+}
 
-	particles[firstDeadIndex].StartPosition = emitterPosition;
-	particles[firstDeadIndex].StartPosition.x += (((float)rand() / RAND_MAX) * 2 - 1) * positionRandomRange.x;
-	particles[firstDeadIndex].StartPosition.y += (((float)rand() / RAND_MAX) * 2 - 1) * positionRandomRange.y;
-	particles[firstDeadIndex].StartPosition.z += (((float)rand() / RAND_MAX) * 2 - 1) * positionRandomRange.z;
+void Emitter::SpawnParticles(int count, const ParticleArrays& particles)
+{
+	// Any left to spawn?  (The budget may have lowered the limit below what's alive)
+	int freeCount = particleLimit - livingParticleCount;
+	if (count > freeCount)
+		count = freeCount;
 
-	particles[firstDeadIndex].Position = particles[firstDeadIndex].StartPosition;
+	while (count > 0)
+	{
+		// Spawn in chunks that don't cross the end of the ring, so the
+		// kernel always writes contiguous particles
+		int chunk = settings->MaxParticles - firstDeadIndex;
+		if (chunk > count) chunk = count;
+		if (chunk > maxSpawnChunk) chunk = maxSpawnChunk;
+
+		// One batch of random numbers for the whole chunk, then one kernel call
+		float randoms[particleSpawnRandoms * maxSpawnChunk];
+		random.FillFloats(randoms, particleSpawnRandoms * chunk);
+		ParticleKernels::Spawn(spawnParams, particles, spanOffset + firstDeadIndex, chunk, randoms);
+
+		// Increment and wrap
+		firstDeadIndex = (firstDeadIndex + chunk) % settings->MaxParticles;
+		livingParticleCount += chunk;
+		count -= chunk;
+	}
+}
 
-	particles[firstDeadIndex].StartVelocity = startVelocity;
-	particles[firstDeadIndex].StartVelocity.x += (((float)rand() / RAND_MAX) * 2 - 1) * velocityRandomRange.x;
-	particles[firstDeadIndex].StartVelocity.y += (((float)rand() / RAND_MAX) * 2 - 1) * velocityRandomRange.y;
-	particles[firstDeadIndex].StartVelocity.z += (((float)rand() / RAND_MAX) * 2 - 1) * velocityRandomRange.z;
+void Emitter::SetBudget(int particleLimit, float emissionScale)
+{
+	this->particleLimit = particleLimit < settings->MaxParticles ? particleLimit : settings->MaxParticles;
+	this->emissionScale = emissionScale;
+}
 
-	float rotStartMin = rotationRandomRanges.x;
-	float rotStartMax = rotationRandomRanges.y;
-	particles[firstDeadIndex].RotationStart = ((float)rand() / RAND_MAX) * (rotStartMax - rotStartMin) + rotStartMin;
+int Emitter::GetParticleLimit()
+{
+	return particleLimit;
+}
 
-	float rotEndMin = rotationRandomRanges.z;
-	float rotEndMax = rotationRandomRanges.w;
-	particles[firstDeadIndex].RotationEnd = ((float)rand() / RAND_MAX) * (rotEndMax - rotEndMin) + rotEndMin;
+void Emitter::SetVisibility(float visibility)
+{
+	this->visibility = visibility;
+}
 
-	// Increment and wrap
-	firstDeadIndex++;
-	firstDeadIndex %= maxParticles;
+float Emitter::GetVisibility()
+{
+	return visibility;
+}
 
-	livingParticleCount++;
+float Emitter::GetBoundingRadius()
+{
+	return boundingRadius;
 }
 
-void Emitter::CopyParticlesToGPU(ID3D11DeviceContext* context, Camera* camera)
+// --------------------------------------------------------
+// Range of p + v * t + a * t^2 / 2 along one axis, for any
+// start offset, any velocity in range and any age.  Each end is
+// at t = 0, t = lifetime, or where the velocity hits zero.
+// --------------------------------------------------------
+static void DisplacementRange(float p, float pRange, float v, float vRange, float a, float lifetime, float* low, float* high)
 {
-	// Update local buffer (living particles only as a speed up)
+	float fastest = v + vRange;
+	float slowest = v - vRange;
 
-	// Check cyclic buffer status
-	if (firstAliveIndex < firstDeadIndex)
+	float highest = fastest * lifetime + 0.5f * a * lifetime * lifetime;
+	if (highest < 0.0f) highest = 0.0f;
+	if (a < 0.0f && -fastest / a > 0.0f && -fastest / a < lifetime)
 	{
-		for (int i = firstAliveIndex; i < firstDeadIndex; i++)
-			CopyOneParticle(i, camera);
+		float t = -fastest / a;
+		float turn = fastest * t + 0.5f * a * t * t;
+		if (turn > highest) highest = turn;
 	}
-	else
-	{
-		// Update first half (from firstAlive to max particles)
-		for (int i = firstAliveIndex; i < maxParticles; i++)
-			CopyOneParticle(i, camera);
 
-		// Update second half (from 0 to first dead)
-		for (int i = 0; i < firstDeadIndex; i++)
-			CopyOneParticle(i, camera);
+	float lowest = slowest * lifetime + 0.5f * a * lifetime * lifetime;
+	if (lowest > 0.0f) lowest = 0.0f;
+	if (a > 0.0f && -slowest / a > 0.0f && -slowest / a < lifetime)
+	{
+		float t = -slowest / a;
+		float turn = slowest * t + 0.5f * a * t * t;
+		if (turn < lowest) lowest = turn;
 	}
 
-	// All particles copied locally - send whole buffer to GPU
-	D3D11_MAPPED_SUBRESOURCE mapped = {};
-	context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
-
-	memcpy(mapped.pData, localParticleVertices, sizeof(ParticleVertex) * 4 * maxParticles);
-
-	context->Unmap(vertexBuffer, 0);
+	*low = p - pRange + lowest;
+	*high = p + pRange + highest;
 }
 
-void Emitter::CopyOneParticle(int index, Camera* camera)
+void Emitter::CalculateBounds()
 {
-	int i = index * 4;
-
-	localParticleVertices[i + 0].Position = CalcParticleVertexPosition(index, 0, camera);
-	localParticleVertices[i + 1].Position = CalcParticleVertexPosition(index, 1, camera);
-	localParticleVertices[i + 2].Position = CalcParticleVertexPosition(index, 2, camera);
-	localParticleVertices[i + 3].Position = CalcParticleVertexPosition(index, 3, camera);
+	DisplacementRange(emitterPosition.x, settings->PositionRandomRange.x, settings->StartVelocity.x, settings->VelocityRandomRange.x, settings->Acceleration.x, settings->Lifetime, &boundsMin.x, &boundsMax.x);
+	DisplacementRange(emitterPosition.y, settings->PositionRandomRange.y, settings->StartVelocity.y, settings->VelocityRandomRange.y, settings->Acceleration.y, settings->Lifetime, &boundsMin.y, &boundsMax.y);
+	DisplacementRange(emitterPosition.z, settings->PositionRandomRange.z, settings->StartVelocity.z, settings->VelocityRandomRange.z, settings->Acceleration.z, settings->Lifetime, &boundsMin.z, &boundsMax.z);
+
+	// Quad corners are up to size * sqrt(2) from the particle in any direction
+	float size = 0.0f;
+	for (int i = 0; i < particleCurveResolution; i++)
+		size = settings->Curves.Size[i] > size ? settings->Curves.Size[i] : size;
+	float corner = size * 1.41421356f;
+	boundsMin = XMFLOAT3(boundsMin.x - corner, boundsMin.y - corner, boundsMin.z - corner);
+	boundsMax = XMFLOAT3(boundsMax.x + corner, boundsMax.y + corner, boundsMax.z + corner);
+}
 
-	localParticleVertices[i + 0].Color = particles[index].Color;
-	localParticleVertices[i + 1].Color = particles[index].Color;
-	localParticleVertices[i + 2].Color = particles[index].Color;
-	localParticleVertices[i + 3].Color = particles[index].Color;
+void Emitter::GetBounds(XMFLOAT3* min, XMFLOAT3* max)
+{
+	*min = boundsMin;
+	*max = boundsMax;
+}
 
-	// If it's a spritesheet, we need to update UV coords as the particle ages
-	if (isSpriteSheet)
-	{
-		// How old is this particle as a percentage
-		float agePercent = particles[index].Age / lifetime;
+void Emitter::SetCulled(bool culled)
+{
+	this->culled = culled;
+}
 
-		// Which overall index?
-		int ssIndex = (int)floor(agePercent * (spriteSheetWidth * spriteSheetHeight));
+bool Emitter::IsCulled()
+{
+	return culled;
+}
 
-		// Get the U/V indices (basically column & row index across the sprite sheet)
-		int uIndex = ssIndex % spriteSheetWidth;
-		int vIndex = ssIndex / spriteSheetHeight; // Integer division is important here!
+void Emitter::SetStale(bool stale)
+{
+	this->stale = stale;
+}
 
-		// Convert to a top-left corner in uv space (0-1)
-		float u = uIndex / (float)spriteSheetWidth;
-		float v = vIndex / (float)spriteSheetHeight;
+bool Emitter::IsStale()
+{
+	return stale;
+}
 
-		localParticleVertices[i + 0].UV = XMFLOAT2(u, v);
-		localParticleVertices[i + 1].UV = XMFLOAT2(u + spriteSheetFrameWidth, v);
-		localParticleVertices[i + 2].UV = XMFLOAT2(u + spriteSheetFrameWidth, v + spriteSheetFrameHeight);
-		localParticleVertices[i + 3].UV = XMFLOAT2(u, v + spriteSheetFrameHeight);
-	}
+float Emitter::CalculateBoundingRadius(const EmitterSettings* settings)
+{
+	// Spawn offset, plus the farthest a particle can travel in its lifetime, plus its size
+	XMFLOAT3 p = settings->PositionRandomRange;
+	XMFLOAT3 v = settings->StartVelocity;
+	XMFLOAT3 vr = settings->VelocityRandomRange;
+	XMFLOAT3 a = settings->Acceleration;
+	float t = settings->Lifetime;
+	float speed = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z) + sqrtf(vr.x * vr.x + vr.y * vr.y + vr.z * vr.z);
+	float accel = sqrtf(a.x * a.x + a.y * a.y + a.z * a.z);
+	float size = 0.0f;
+	for (int i = 0; i < particleCurveResolution; i++)
+		size = settings->Curves.Size[i] > size ? settings->Curves.Size[i] : size;
+	return sqrtf(p.x * p.x + p.y * p.y + p.z * p.z) + speed * t + 0.5f * accel * t * t + size;
 }
 
+unsigned int Emitter::GetFeatures()
+{
+	return features;
+}
 
-XMFLOAT3 Emitter::CalcParticleVertexPosition(int particleIndex, int quadCornerIndex, Camera* camera)
+// --------------------------------------------------------
+// A feature is only dropped when the kernels would compute
+// exactly what the particle already spawned with
+// --------------------------------------------------------
+unsigned int Emitter::CalculateFeatures(const EmitterSettings* settings)
 {
-	// Get the right and up vectors out of the view matrix
-	// (Remember that it is probably already transposed)
-	XMFLOAT4X4 view = camera->GetViewMatrix();
-	XMVECTOR camRight = XMVectorSet(view._11, view._12, view._13, 0);
-	XMVECTOR camUp = XMVectorSet(view._21, view._22, view._23, 0);
+	unsigned int features = 0;
 
-	// Determine the offset of this corner of the quad
-	// Since the UV's are already set when the emitter is created, 
-	// we can alter that data to determine the general offset of this corner
-	XMFLOAT2 offset = DefaultUVs[quadCornerIndex];
-	offset.x = offset.x * 2 - 1;	// Convert from [0,1] to [-1,1]
-	offset.y = (offset.y * -2 + 1);	// Same, but flip the Y
+	// Every particle starts and ends at the same rotation, so the rotation curve has nothing to scale
+	XMFLOAT4 rotations = settings->RotationRandomRanges;
+	if (rotations.x != rotations.y || rotations.x != rotations.z || rotations.x != rotations.w)
+		features |= particleFeatureRotation;
 
-	// Load into a vector, which we'll assume is float3 with a Z of 0
-	// Create a Z rotation matrix and apply it to the offset
-	XMVECTOR offsetVec = XMLoadFloat2(&offset);
-	XMMATRIX rotMatrix = XMMatrixRotationZ(particles[particleIndex].Rotation);
-	offsetVec = XMVector3Transform(offsetVec, rotMatrix);
+	XMFLOAT3 a = settings->Acceleration;
+	if (a.x != 0.0f || a.y != 0.0f || a.z != 0.0f)
+		features |= particleFeatureAcceleration;
 
-	// Add and scale the camera up/right vectors to the position as necessary
-	XMVECTOR posVec = XMLoadFloat3(&particles[particleIndex].Position);
-	posVec += camRight * XMVectorGetX(offsetVec) * particles[particleIndex].Size;
-	posVec += camUp * XMVectorGetY(offsetVec) * particles[particleIndex].Size;
+	// Particles spawn with the first entry of each color curve
+	const ParticleCurves& curves = settings->Curves;
+	for (int i = 1; i < particleCurveResolution; i++)
+	{
+		if (curves.R[i] != curves.R[0] || curves.G[i] != curves.G[0] ||
+			curves.B[i] != curves.B[0] || curves.A[i] != curves.A[0])
+		{
+			features |= particleFeatureColorOverLife;
+			break;
+		}
+	}
 
-	// This position is all set
-	XMFLOAT3 pos;
-	XMStoreFloat3(&pos, posVec);
-	return pos;
+	return features;
 }
 
-
-
-void Emitter::Draw(ID3D11DeviceContext* context, Camera* camera)
+bool Emitter::IsAnalytic()
 {
-	// Copy to dynamic buffer
-	CopyParticlesToGPU(context, camera);
+	return settings->Analytic;
+}
 
-	// Set up buffers
-	UINT stride = sizeof(ParticleVertex);
-	UINT offset = 0;
-	context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-	context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+float Emitter::GetTime()
+{
+	return settings->Duration - totalDuration;
+}
 
-	vs->SetMatrix4x4("view", camera->GetViewMatrix());
-	vs->SetMatrix4x4("projection", camera->GetProjectionMatrix());
-	vs->SetShader();
-	vs->CopyAllBufferData();
+const EmitterSettings* Emitter::GetSettings()
+{
+	return settings;
+}
 
-	ps->SetShaderResourceView("particle", texture);
+XMFLOAT3 Emitter::GetPosition()
+{
+	return emitterPosition;
+}
 
-	ps->SetShader();
+float Emitter::GetTotalTime()
+{
+	return totalDuration;
+}
 
-	// Draw the correct parts of the buffer
-	if (firstAliveIndex < firstDeadIndex)
-	{
-		context->DrawIndexed(livingParticleCount * 6, firstAliveIndex * 6, 0);
-	}
-	else
-	{
-		// Draw first half (0 -> dead)
-		context->DrawIndexed(firstDeadIndex * 6, 0, 0);
+float Emitter::GetLifetime()
+{
+	return settings->Lifetime;
+}
 
-		// Draw second half (alive -> max)
-		context->DrawIndexed((maxParticles - firstAliveIndex) * 6, firstAliveIndex * 6, 0);
-	}
+int Emitter::GetLivingCount()
+{
+	return livingParticleCount;
+}
 
+int Emitter::GetSpanOffset()
+{
+	return spanOffset;
 }
 
-float Emitter::GetTotalTime()
+int Emitter::GetSpanSize()
 {
-	return totalDuration;
+	return spanSize;
 }
@@ -1,117 +1,157 @@
 #pragma once
 
-#include <d3d11.h>
 #include <DirectXMath.h>
 
-#include "Camera.h"
-#include "SimpleShader.h"
+#include "ParticleKernels.h"
+#include "Random.h"
 
-struct Particle
+// A number of particles spawned all at once, some time after the emitter starts
+struct ParticleBurst
 {
-	DirectX::XMFLOAT4 Color;
-	DirectX::XMFLOAT3 StartPosition;
-	DirectX::XMFLOAT3 Position;
-	DirectX::XMFLOAT3 StartVelocity;
-	float Size;
-	float Age;
-	float RotationStart;
-	float RotationEnd;
-	float Rotation;
+	float Time;
+	int Count;
 };
 
-struct ParticleVertex
+static const int maxParticleBursts = 8;
+
+// --------------------------------------------------------
+// Everything that describes a kind of effect.  Emitters only
+// keep a pointer to their settings, so one set of settings is
+// shared by every explosion.  Usually loaded from a file with
+// LoadEmitterSettings (see ParticleEffect.h).
+// --------------------------------------------------------
+struct EmitterSettings
 {
-	DirectX::XMFLOAT3 Position;
-	DirectX::XMFLOAT2 UV;
-	DirectX::XMFLOAT4 Color;
+	int MaxParticles;
+	int ParticlesPerSecond;			// Continuous emission, can be 0 for burst-only effects
+	ParticleBurst Bursts[maxParticleBursts];	// In time order
+	int BurstCount;
+	float Lifetime;					// Of each particle
+	float Duration;					// How long the emitter lives
+	DirectX::XMFLOAT3 StartVelocity;
+	DirectX::XMFLOAT3 VelocityRandomRange;
+	DirectX::XMFLOAT3 PositionRandomRange;
+	DirectX::XMFLOAT4 RotationRandomRanges; // Min start, max start, min end, max end
+	DirectX::XMFLOAT3 Acceleration;
+	float Importance;				// Weights the emitter against others when the particle budget is tight
+	bool Analytic;					// Particles are never updated, just evaluated when drawn (see ParticleKernels::Evaluate)
+	ParticleCurves Curves;			// Color, alpha, size and rotation over each particle's life
 };
 
+// --------------------------------------------------------
+// A single running effect
+//
+// The particles themselves live in a span of the ParticleSystem's
+// shared store - the emitter just tracks which part of its span
+// is alive, as a ring buffer.
+//
+// Each emitter has its own random stream, so spawning doesn't
+// touch any shared state and an effect plays out the same way
+// every time it's given the same seed.
+// --------------------------------------------------------
 class Emitter
 {
 public:
-	Emitter(
-		int maxParticles,
-		int particlesPerSecond,
-		float lifetime,
-		float startSize,
-		float endSize,
-		DirectX::XMFLOAT4 startColor,
-		DirectX::XMFLOAT4 endColor,
-		DirectX::XMFLOAT3 startVelocity,
-		DirectX::XMFLOAT3 velocityRandomRange,
-		DirectX::XMFLOAT3 emitterPosition,
-		DirectX::XMFLOAT3 positionRandomRange,
-		DirectX::XMFLOAT4 rotationRandomRanges,
-		DirectX::XMFLOAT3 emitterAcceleration,
-		ID3D11Device* device,
-		SimpleVertexShader* vs,
-		SimplePixelShader* ps,
-		ID3D11ShaderResourceView* texture,
-		bool isSpriteSheet = false,
-		unsigned int spriteSheetWidth = 1,
-		unsigned int spriteSheetHeight = 1
-		);
-	~Emitter();
-
-	void Update(float dt);
-	void Draw(ID3D11DeviceContext* context, Camera* camera);
+	Emitter(const EmitterSettings* settings, DirectX::XMFLOAT3 emitterPosition, int spanOffset, int spanSize, unsigned long long seed);
+
+	// Fires any bursts scheduled at time 0, so they're there from the very first frame
+	void Start(const ParticleArrays& particles);
+
+	// Jumps the emitter ahead, spawning and retiring as it goes.  Analytic
+	// emitters just spawn particles with the right birth times, others are
+	// stepped through ordinary updates.
+	void FastForward(float time, const ParticleArrays& particles);
+
+	// Runs all three update steps below on the calling thread
+	void Update(float dt, const ParticleArrays& particles);
+
+	// Update is split up so the particle kernels can run on other threads:
+	//  - BeginUpdate counts down the duration, returns false once the emitter has stopped
+	//  - the kernels run over GetLivingRanges with GetUpdateParams (skipped
+	//    for analytic emitters, FinishUpdate retires their particles by age)
+	//  - FinishUpdate retires the particles that died, fires any bursts that are due
+	//    and spawns new ones
+	bool BeginUpdate(float dt);
+	ParticleUpdateParams GetUpdateParams(float dt);
+	void FinishUpdate(float dt, int deaths, const ParticleArrays& particles);
+
+	// Living particles as ranges of the shared store (two when the ring wraps), returns the range count
+	int GetLivingRanges(int* firsts, int* counts);
+
+	// Set by the particle budget - how many particles this emitter may have
+	// alive, and how much of its spawn rate (and bursts) it gets
+	void SetBudget(int particleLimit, float emissionScale);
+	int GetParticleLimit();
+
+	// How visible the emitter was when the budget last looked at it
+	void SetVisibility(float visibility);
+	float GetVisibility();
+
+	// Farthest any particle can get from the emitter's position (including its size)
+	float GetBoundingRadius();
+
+	// World space box every particle (quad corners included) stays inside, for its whole life
+	void GetBounds(DirectX::XMFLOAT3* min, DirectX::XMFLOAT3* max);
+
+	// Culled emitters only have their particles aged (see ParticleKernels::UpdateAges),
+	// which leaves the rest of their particles stale until refreshed
+	void SetCulled(bool culled);
+	bool IsCulled();
+	void SetStale(bool stale);
+	bool IsStale();
+	static float CalculateBoundingRadius(const EmitterSettings* settings);
+
+	// Which parts of the particle math the settings actually use (the
+	// particleFeature bits, minus the sprite sheet which isn't up to the emitter)
+	unsigned int GetFeatures();
+	static unsigned int CalculateFeatures(const EmitterSettings* settings);
+
+	bool IsAnalytic();
+	float GetTime();				// Since the emitter started
+
+	const EmitterSettings* GetSettings();
+	DirectX::XMFLOAT3 GetPosition();
 	float GetTotalTime();
+	float GetLifetime();
+	int GetLivingCount();
+	int GetSpanOffset();
+	int GetSpanSize();
 
 private:
-	float totalDuration = 1.0f;
-
-
-	// Emission properties
-	int particlesPerSecond;
-	float secondsPerParticle;
+	const EmitterSettings* settings;
+	DirectX::XMFLOAT3 emitterPosition;
+	float totalDuration;
 	float timeSinceEmit;
-
-	bool isSpriteSheet;
-	int spriteSheetWidth;
-	int spriteSheetHeight;
-	float spriteSheetFrameWidth;
-	float spriteSheetFrameHeight;
-
+	int nextBurst;
+	float boundingRadius;
+	unsigned int features;
+	DirectX::XMFLOAT3 boundsMin;
+	DirectX::XMFLOAT3 boundsMax;
+	bool culled;
+	bool stale;
+
+	void CalculateBounds();
+
+	// Budget
+	int particleLimit;
+	float emissionScale;
+	float visibility;
+
+	// Where this emitter's particles are in the shared store
+	int spanOffset;
+	int spanSize;
+
+	// Ring buffer within the span
 	int livingParticleCount;
-	float lifetime;
-
-	DirectX::XMFLOAT2 DefaultUVs[4];
-
-	DirectX::XMFLOAT3 emitterAcceleration;
-	DirectX::XMFLOAT3 emitterPosition;
-	DirectX::XMFLOAT3 startVelocity;
-
-	DirectX::XMFLOAT3 positionRandomRange;
-	DirectX::XMFLOAT3 velocityRandomRange;
-	DirectX::XMFLOAT4 rotationRandomRanges; // Min start, max start, min end, max end
-
-	DirectX::XMFLOAT4 startColor; 
-	DirectX::XMFLOAT4 endColor;
-	float startSize;
-	float endSize;
-
-	// Particle array
-	Particle* particles;
-	int maxParticles;
 	int firstDeadIndex;
 	int firstAliveIndex;
 
-	// Rendering
-	ParticleVertex* localParticleVertices;
-	ID3D11Buffer* vertexBuffer;
-	ID3D11Buffer* indexBuffer;
-
-	ID3D11ShaderResourceView* texture;
-	SimpleVertexShader* vs;
-	SimplePixelShader* ps;
+	// Spawning pulls its random numbers from here in batches
+	static const int maxSpawnChunk = 64;
+	Random random;
+	ParticleSpawnParams spawnParams;
 
-	// Update Methods
-	void UpdateSingleParticle(float dt, int index);
-	void SpawnParticle();
-
-	// Copy methods
-	void CopyParticlesToGPU(ID3D11DeviceContext* context, Camera* camera);
-	void CopyOneParticle(int index, Camera* camera);
-	DirectX::XMFLOAT3 CalcParticleVertexPosition(int particleIndex, int quadCornerIndex, Camera* camera);
+	int DueBurstParticles(float time);
+	int CountExpired(const ParticleArrays& particles);
+	void SpawnParticles(int count, const ParticleArrays& particles);
 };
-
@@ -3,19 +3,18 @@
 
 void Entity::CalculateWorldMatrix()
 {
-	//get the world matrix and convert it to a matrix
-	DirectX::XMMATRIX tempWorldMat = DirectX::XMLoadFloat4x4(&worldMat);
-
 	// Apply Transformations
 	DirectX::XMMATRIX tempScaleMat = DirectX::XMMatrixScalingFromVector(XMLoadFloat3(&scaleVec));
-	DirectX::XMMATRIX tempRotationMat = DirectX::XMMatrixRotationRollPitchYawFromVector(XMLoadFloat4(&rotationQuat));
+	DirectX::XMMATRIX tempRotationMat = DirectX::XMMatrixRotationQuaternion(XMLoadFloat4(&rotationQuat));
 	DirectX::XMMATRIX tempTranslationMat = DirectX::XMMatrixTranslationFromVector(XMLoadFloat3(&positionVec));
 
 	//Calculate World Matrix
-	tempWorldMat = tempScaleMat * tempRotationMat * tempTranslationMat;
+	DirectX::XMMATRIX tempWorldMat = tempScaleMat * tempRotationMat * tempTranslationMat;
 
 	//Store world matrix as float4x4
 	XMStoreFloat4x4(&worldMat, XMMatrixTranspose(tempWorldMat));
+
+	worldDirty = false;
 }
 
 Entity::Entity(Mesh* mesh, Material* material)
@@ -29,13 +28,13 @@ Entity::Entity(Mesh* mesh, Material* material)
 		0,0,0,1);
 	positionVec = DirectX::XMFLOAT3(0,0,0);
 	scaleVec = DirectX::XMFLOAT3(1,1,1);
-	rotationQuat = DirectX::XMFLOAT4(0,0,0,0);
+	rotationQuat = DirectX::XMFLOAT4(0,0,0,1);
 	coll = 0;
+	worldDirty = true;
 }
 
 Entity::~Entity()
 {
-	// Nothing to delete
 	delete coll;
 }
 
@@ -47,17 +46,21 @@ Mesh* Entity::GetMesh()
 void Entity::SetWorldMatrix(DirectX::XMFLOAT4X4 value)
 {
 	worldMat = value;
+	worldDirty = false;
 }
 
 DirectX::XMFLOAT4X4 Entity::GetWorldMatrix()
 {
-	CalculateWorldMatrix();
+	// Only rebuild if something changed since the last time
+	if (worldDirty)
+		CalculateWorldMatrix();
 	return worldMat;
 }
 
 void Entity::SetPosition(DirectX::XMFLOAT3 value)
 {
 	positionVec = value;
+	worldDirty = true;
 }
 
 DirectX::XMFLOAT3 Entity::GetPosition()
@@ -68,6 +71,7 @@ DirectX::XMFLOAT3 Entity::GetPosition()
 void Entity::SetScale(DirectX::XMFLOAT3 value)
 {
 	scaleVec = value;
+	worldDirty = true;
 }
 
 DirectX::XMFLOAT3 Entity::GetScale()
@@ -78,6 +82,7 @@ DirectX::XMFLOAT3 Entity::GetScale()
 void Entity::SetRotation(DirectX::XMFLOAT4 value)
 {
 	rotationQuat = value;
+	worldDirty = true;
 }
 
 DirectX::XMFLOAT4 Entity::GetRotation()
@@ -92,22 +97,8 @@ Material* Entity::GetMaterial()
 
 void Entity::PrepareMaterial(DirectX::XMFLOAT4X4 viewMatrix, DirectX::XMFLOAT4X4 projectionMatrix)
 {
-	// Set vertex shader data for materials
 	// Call GetWorldMatrix so that calculation is also performed
-	material->GetVertexShader()->SetMatrix4x4("world", GetWorldMatrix());
-	material->GetVertexShader()->SetMatrix4x4("view", viewMatrix);
-	material->GetVertexShader()->SetMatrix4x4("projection", projectionMatrix);
-
-	// Set pixel shader data for textures
-	material->GetPixelShader()->SetShaderResourceView("diffuseTexture", material->GetTextureSRV());
-	if (material->GetSpecularSRV()) {
-		material->GetPixelShader()->SetShaderResourceView("specularTexture", material->GetSpecularSRV());
-	}
-	if (material->GetNormalMapSRV()) {
-		material->GetPixelShader()->SetShaderResourceView("normalMap", material->GetNormalMapSRV());
-	}
-
-	material->GetPixelShader()->SetSamplerState("basicSampler", material->GetSamplerState());
+	material->PrepareMaterial(GetWorldMatrix(), viewMatrix, projectionMatrix);
 }
 
 void Entity::Translate(DirectX::XMVECTOR position)
@@ -120,6 +111,7 @@ void Entity::Translate(DirectX::XMVECTOR position)
 
 	//convert the XMVECTOR then store it
 	DirectX::XMStoreFloat3(&positionVec, tempTranslationVector);
+	worldDirty = true;
 }
 
 void Entity::Scale(DirectX::XMVECTOR scale)
@@ -132,6 +124,7 @@ void Entity::Scale(DirectX::XMVECTOR scale)
 
 	//convert the XMVECTOR then store it
 	DirectX::XMStoreFloat3(&scaleVec, tempScaleVector);
+	worldDirty = true;
 }
 
 void Entity::Rotate(DirectX::XMVECTOR rotation)
@@ -139,23 +132,26 @@ void Entity::Rotate(DirectX::XMVECTOR rotation)
 	//create an XMVECTOR from float4 for math
 	DirectX::XMVECTOR tempRotationQuat = DirectX::XMLoadFloat4(&rotationQuat);
 
-	//do the math
-	//tempRotationQuat = DirectX::XMQuaternionMultiply(tempRotationQuat, rotation);
-	tempRotationQuat = DirectX::XMVectorAdd(tempRotationQuat, rotation);
+	//do the math (renormalize so repeated small rotations don't drift)
+	tempRotationQuat = DirectX::XMQuaternionNormalize(DirectX::XMQuaternionMultiply(tempRotationQuat, rotation));
 
 	//convert the XMVECTOR then store it
 	DirectX::XMStoreFloat4(&rotationQuat, tempRotationQuat);
+	worldDirty = true;
 }
 
 void Entity::AttachCollider()
 {
-	std::vector<Vertex> verts = mesh->GetVertsFromMesh();
-
-	coll = new Collision(verts);
-	coll->GenAABB(verts);
+	// Bounds are computed once per mesh, the collider just points at them
+	coll = new Collision(mesh->GetBounds());
 }
 
 Collision* Entity::GetCollision()
 {
 	return coll;
 }
+
+bool Entity::IsWorldMatrixStale()
+{
+	return worldDirty;
+}
@@ -14,6 +14,10 @@ class Entity
 	Material* material;
 	Collision* coll;
 
+	// Set whenever position, scale or rotation change so the
+	// world matrix is only rebuilt when it is actually stale
+	bool worldDirty;
+
 	void CalculateWorldMatrix();
 public:
 	Entity(Mesh* mesh, Material* material);
@@ -33,6 +37,7 @@ public:
 	void SetScale(DirectX::XMFLOAT3 value);
 	DirectX::XMFLOAT3 GetScale();
 
+	// Rotation is a quaternion (x, y, z, w)
 	void SetRotation(DirectX::XMFLOAT4 value);
 	DirectX::XMFLOAT4 GetRotation();
 
@@ -44,6 +49,9 @@ public:
 	// Transformations
 	void Translate(DirectX::XMVECTOR position);
 	void Scale(DirectX::XMVECTOR scale);
-	void Rotate(DirectX::XMVECTOR rotation);
+	void Rotate(DirectX::XMVECTOR rotation);	// Quaternion, applied after the current rotation
+
+	// True when the next GetWorldMatrix has to rebuild the matrix
+	bool IsWorldMatrixStale();
 };
 
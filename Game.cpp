@@ -2,6 +2,8 @@
 #include "Vertex.h"
 
 #include <MMSystem.h>
+#include "AllocationCounter.h"
+#include <ctime>
 
 // For the DirectX Math library
 using namespace DirectX;
@@ -32,6 +34,8 @@ Game::Game(HINSTANCE hInstance)
 	vertexShaderSpecularMap = 0;
 	pixelShaderSpecularMap = 0;
 
+	vertexShaderQuantized = 0;
+
 	prevMousePos = { 0,0 };
 
 	sphereMesh = 0;
@@ -62,6 +66,23 @@ Game::Game(HINSTANCE hInstance)
 
 	camera = new Camera();
 	camera->CalculateProjectionMatrix(width, height);
+	broadphase = new Broadphase();
+	world = new World(broadphase, maxWorldEntities);
+
+	// Everything random in a session comes from this one seed - print it
+	// and hard code it here to replay a session
+	sessionSeed = (unsigned long long)time(0);
+	spawnRandom.Seed(sessionSeed, 0);
+	fireRandom.Seed(sessionSeed, 1);
+	particleSystem = new ParticleSystem(maxParticles, maxEmitters, sessionSeed);
+	particleSystem->SetParticleBudget(particleBudget);
+	particleSystem->SetPacked(true);	// Draws with ParticleVS
+
+	// One worker per core, minus the one this thread runs on
+	unsigned int cores = std::thread::hardware_concurrency();
+	workerPool = new WorkerPool(cores > 1 ? cores - 1 : 0);
+	particleSystem->SetWorkerPool(workerPool);
+	updateAllocations = 0;
 	score = 0;
 	hiScore = 0;
 
@@ -69,6 +90,7 @@ Game::Game(HINSTANCE hInstance)
 	// Do we want a console window?  Probably only in debug mode
 	CreateConsoleWindow(500, 120, 32, 120);
 	printf("Console window created successfully.  Feel free to printf() here.\n");
+	printf("Session seed: %llu\n", sessionSeed);
 #endif
 
 }
@@ -94,10 +116,13 @@ Game::~Game()
 	delete vertexShaderSpecularMap;
 	delete pixelShaderSpecularMap;
 
+	delete vertexShaderQuantized;
 
-	for (int i = 0; i < entities.size(); i++) {
-		delete entities[i];
-	}
+
+	// World entities unregister their colliders from the broadphase
+	delete world;
+	if (isAlive)
+		delete player;
 
 	delete sphereMesh;
 	delete playerMesh;
@@ -131,19 +156,22 @@ Game::~Game()
 	// particle stuff
 	particleTexture->Release();
 	particleBlendState->Release();
+	particleAlphaBlendState->Release();
 	particleDepthState->Release();
 	delete particleVS;
 	delete particlePS;
 
-	for (int i = 0; i < emitters.size(); i++) {
-		delete emitters[i];
-	}
+	delete particleSystem;
+	delete workerPool;
 	delete skyVS;
 	delete skyPS;
 	delete cubeMesh;
 	skyDepthState->Release();
 	skyRastState->Release();
 	skySRV->Release();
+
+	// colliders unregister themselves, so this goes after the entities
+	delete broadphase;
 }
 
 // --------------------------------------------------------
@@ -209,6 +237,17 @@ void Game::Init()
 	blend.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
 	device->CreateBlendState(&blend, &particleBlendState);
 
+	// Regular alpha blending, for when the particles are drawn sorted
+	blend.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+	blend.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+	device->CreateBlendState(&blend, &particleAlphaBlendState);
+
+	// Shared particle buffers, created once for every effect
+	particleSystem->CreateBuffers(device, particleVS, particlePS, particleTexture);
+
+	// Enemy explosion
+	LoadEmitterSettings("../../assets/Effects/explosion.txt", &explosionSettings);
+
 	D3D11_RASTERIZER_DESC rd = {};
 	rd.FillMode = D3D11_FILL_SOLID;
 	rd.CullMode = D3D11_CULL_FRONT;
@@ -248,6 +287,12 @@ void Game::LoadShaders()
 	pixelShaderSpecularMap = new SimplePixelShader(device, context);
 	pixelShaderSpecularMap->LoadShaderFile(L"PixelShaderSpecularMap.cso");
 
+	// Reflection would read the packed inputs as full floats
+	unsigned int quantizedElementCount = 0;
+	const D3D11_INPUT_ELEMENT_DESC* quantizedElements = Mesh::GetQuantizedInputElements(&quantizedElementCount);
+	vertexShaderQuantized = new SimpleVertexShader(device, context, quantizedElements, quantizedElementCount);
+	vertexShaderQuantized->LoadShaderFile(L"VertexShaderQuantized.cso");
+
 	particleVS = new SimpleVertexShader(device, context);
 	particleVS->LoadShaderFile(L"ParticleVS.cso");
 
@@ -396,14 +441,35 @@ void Game::CreateBasicGeometry()
 
 	unsigned int blueIndices[] = { 0, 1, 2, 0, 2, 3 };
 
-	enemyMesh = new Mesh("../../assets/models/enemy.obj", device);
-	sphereMesh = new Mesh("../../assets/models/sphere.obj", device);
-	playerMesh = new Mesh("../../assets/models/f.obj", device);
+	enemyMesh = new Mesh("../../assets/models/enemy.obj", device, 0.0f, true);
+	sphereMesh = new Mesh("../../assets/models/sphere.obj", device, 0.0f, true);
+	playerMesh = new Mesh("../../assets/models/f.obj", device, 0.0f, true);
+
+#if defined(DEBUG) || defined(_DEBUG)
+	// Vertex cache behaviour of the OBJ order vs. the optimized one, what
+	// quantizing cost, and the memory each load took and kept
+	const char* meshNames[] = { "enemy", "sphere", "player" };
+	Mesh* loadedMeshes[] = { enemyMesh, sphereMesh, playerMesh };
+	for (int i = 0; i < 3; i++)
+	{
+		const VertexCacheStats& before = loadedMeshes[i]->GetOriginalCacheStats();
+		const VertexCacheStats& after = loadedMeshes[i]->GetCacheStats();
+		const QuantizationError& error = loadedMeshes[i]->GetQuantizationError();
+		const MeshLoadMemory& memory = loadedMeshes[i]->GetLoadMemory();
+		printf("%s mesh: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", meshNames[i], before.ACMR, after.ACMR, before.ATVR, after.ATVR);
+		printf("%s mesh quantization error: position %g, UV %g, normal %.2f deg, tangent %.2f deg\n",
+			meshNames[i], error.Position, error.UV, error.NormalDegrees, error.TangentDegrees);
+		printf("%s mesh load memory: heap peak %.1f KB, kept %.1f KB, working set peak +%.1f KB, kept %+.1f KB\n",
+			meshNames[i], memory.PeakHeapBytes / 1024.0, memory.RetainedHeapBytes / 1024.0,
+			memory.PeakWorkingSetBytes / 1024.0, memory.RetainedWorkingSetBytes / 1024.0);
+	}
+#endif
 	
 	//Change models later
 
 	player = new Entity(playerMesh, playerMaterial);
 	player->AttachCollider();
+	player->GetCollision()->AttachToBroadphase(broadphase, LAYER_PLAYER, LAYER_ENEMY_LASER, player);
 	player->SetPosition(XMFLOAT3(0, 0, -1));
 	//player->SetRotation(XMFLOAT4(0,-1.55,0,0));
 	player->SetScale(XMFLOAT3(0.2, 0.2, 0.2));
@@ -424,25 +490,102 @@ void Game::OnResize()
 	camera->CalculateProjectionMatrix(width, height);
 }
 
+// --------------------------------------------------------
+// Spawning helpers - enemies leave through the sides of the
+// play area, lasers run out of time once they've flown past it,
+// so each gets its own archetype
+// --------------------------------------------------------
+static const unsigned int shipComponents =
+	COMPONENT_TRANSFORM | COMPONENT_VELOCITY | COMPONENT_COLLIDER |
+	COMPONENT_RENDER | COMPONENT_TEAM | COMPONENT_CULL_BOUNDS;
+static const unsigned int laserComponents =
+	COMPONENT_TRANSFORM | COMPONENT_VELOCITY | COMPONENT_COLLIDER |
+	COMPONENT_RENDER | COMPONENT_TEAM | COMPONENT_LIFETIME;
+
+EntityHandle Game::SpawnLaser(XMFLOAT3 position)
+{
+	float laserSpeed = 7.5f;
+
+	EntityHandle laser = world->Create(laserComponents);
+	TransformComponent* transform = world->GetTransform(laser);
+	transform->Position = position;
+	transform->Scale = XMFLOAT3(0.4f, 0.4f, 0.4f);
+	world->GetVelocity(laser)->Velocity = XMFLOAT3(0, 0, laserSpeed);
+	world->GetRender(laser)->RenderMesh = sphereMesh;
+	world->GetRender(laser)->RenderMaterial = fabricMaterial;
+	world->GetTeam(laser)->Side = TEAM_PLAYER_LASER;
+
+	// Long enough to reach z = 30, well past the farthest enemies
+	world->GetLifetime(laser)->Remaining = (30.0f - position.z) / laserSpeed;
+	world->AttachCollider(laser, sphereMesh->GetBounds(), transform->Scale, LAYER_PLAYER_LASER, LAYER_ENEMY);
+	return laser;
+}
+
+EntityHandle Game::SpawnEnemy(Team side, XMFLOAT3 position)
+{
+	float enemySpeed = 3.0f;
+
+	EntityHandle enemy = world->Create(shipComponents);
+	TransformComponent* transform = world->GetTransform(enemy);
+	transform->Position = position;
+	transform->Scale = XMFLOAT3(0.02f, 0.02f, 0.02f);
+	world->GetRender(enemy)->RenderMesh = enemyMesh;
+	world->GetRender(enemy)->RenderMaterial = enemyMaterial;
+	world->GetTeam(enemy)->Side = side;
+
+	// Left enemies fly right a little faster, right enemies fly left
+	if (side == TEAM_ENEMY_LEFT)
+	{
+		world->GetVelocity(enemy)->Velocity = XMFLOAT3(enemySpeed * 1.2f, 0, 0);
+		world->GetCullBounds(enemy)->Max.x = 30.0f;
+	}
+	else
+	{
+		world->GetVelocity(enemy)->Velocity = XMFLOAT3(-enemySpeed, 0, 0);
+		world->GetCullBounds(enemy)->Min.x = -30.0f;
+	}
+
+	world->AttachCollider(enemy, enemyMesh->GetBounds(), transform->Scale, LAYER_ENEMY, LAYER_PLAYER_LASER);
+	return enemy;
+}
+
+EntityHandle Game::SpawnEnemyLaser(XMFLOAT3 position, XMFLOAT3 colliderScale)
+{
+	float enemySpeed = 3.0f;
+
+	EntityHandle laser = world->Create(laserComponents);
+	TransformComponent* transform = world->GetTransform(laser);
+	transform->Position = position;
+	transform->Scale = XMFLOAT3(0.5f, 0.5f, 0.5f);
+	world->GetVelocity(laser)->Velocity = XMFLOAT3(0, 0, -enemySpeed);
+	world->GetRender(laser)->RenderMesh = sphereMesh;
+	world->GetRender(laser)->RenderMaterial = enemyMaterial;
+	world->GetTeam(laser)->Side = TEAM_ENEMY_LASER;
+
+	// Long enough to reach z = -3, just behind the player's limit
+	world->GetLifetime(laser)->Remaining = (position.z + 3.0f) / enemySpeed;
+
+	// The collider takes the firing enemy's scale, not the laser's
+	world->AttachCollider(laser, sphereMesh->GetBounds(), colliderScale, LAYER_ENEMY_LASER, LAYER_PLAYER);
+	return laser;
+}
+
+void Game::SpawnExplosion(XMFLOAT3 position)
+{
+	// No device calls here - the effect just claims a span of the shared store
+	particleSystem->SpawnEmitter(&explosionSettings, position);
+}
+
 // --------------------------------------------------------
 // Update your game here - user input, move objects, AI, etc.
 // --------------------------------------------------------
 void Game::Update(float deltaTime, float totalTime)
 {
-	entities.clear();
-
-	// Update emitters
-	for (int i = 0; i < emitters.size(); i++) {
-		emitters[i]->Update(deltaTime);
-
-		// remove expired emitters
-		if (emitters[i]->GetTotalTime() < 0.0f) {
-			delete emitters[i];
-			emitters.erase(emitters.begin() + i);
-			--i;
-			continue;
-		}
-	}
+	long long allocationsAtStart = AllocationCounter::GetCount();
+
+	// Update emitters (expired ones are retired by the system)
+	particleSystem->ApplyBudget(camera);
+	particleSystem->Update(deltaTime);
 
 	camera->Update(deltaTime);
 	if (isAlive)
@@ -494,270 +637,128 @@ void Game::Update(float deltaTime, float totalTime)
 			//SoundStuff
 			PlaySound(TEXT("../../assets/Sounds/playershot.wav"), NULL, SND_ASYNC);
 
-			playerL = new Entity(sphereMesh, fabricMaterial);
-			playerL->SetScale(XMFLOAT3(0.4, 0.4, 0.4));
-			playerL->SetPosition(player->GetPosition());
-			playerL->AttachCollider();
-			playerL->GetCollision()->SetPosition(player->GetPosition());
-			playerL->GetCollision()->SetScale(playerL->GetScale());
-			lasers.push_back(playerL);
-		}
-
-		float laserSpeed = 7.5f;
-		int i = 0;
-		for (int i = 0; i < lasers.size(); i++)
-		{
-			lasers[i]->SetPosition(XMFLOAT3(lasers[i]->GetPosition().x, lasers[i]->GetPosition().y, lasers[i]->GetPosition().z + (laserSpeed * deltaTime)));
-			lasers[i]->GetCollision()->SetPosition(lasers[i]->GetPosition());
-			if (lasers[i]->GetPosition().z >= 30.0f && i < lasers.size())
-			{
-				delete lasers[i];
-				lasers.erase(lasers.begin() + i);
-				i--;
-				continue;
-			}
-		}
-		for (int i = 0; i < lasers.size(); i++) {
-			bool markContinue = false;
-			for (int j = 0; j < enemies.size(); j++)
-			{
-				// laser hits enemy
-				if (enemies[j]->GetCollision()->CheckCollision(lasers[i]->GetCollision()) && i < lasers.size() && j < enemies.size())
-				{
-					// create particle effect
-					emitters.push_back(new Emitter(
-						110,							// Max particles
-						20,								// Particles per second
-						1,								// Particle lifetime
-						1.25f,							// Start size
-						0.75f,							// End size
-						XMFLOAT4(1, 0.1f, 0.1f, 0.7f),	// Start color
-						XMFLOAT4(1, 0.6f, 0.1f, 0.0f),		// End color
-						XMFLOAT3(0, 0, 0),				// Start velocity
-						XMFLOAT3(0.2f, 0.2f, 0.2f),		// Velocity randomness range
-						XMFLOAT3(
-							enemies[j]->GetPosition().x, 
-							enemies[j]->GetPosition().y, 
-							enemies[j]->GetPosition().z),				// Emitter position
-						XMFLOAT3(0.1f, 0.1f, 0.1f),		// Position randomness range
-						XMFLOAT4(-2, 2, -2, 2),			// Random rotation ranges (startMin, startMax, endMin, endMax)
-						XMFLOAT3(0, 0, 0),				// Constant acceleration
-						device,
-						particleVS,
-						particlePS,
-						particleTexture));
-
-
-					delete enemies[j];
-					enemies.erase(enemies.begin() + j);
-					--j;
-					score+=10;
-
-					PlaySound(TEXT("../../assets/Sounds/explosion.wav"), NULL, SND_ASYNC);
-					if (score >= hiScore)
-					{
-						hiScore = score;
-					}
-					markContinue = true;
-					continue;
-				}
-			}
-			if (markContinue) {
-				delete lasers[i];
-				lasers.erase(lasers.begin() + i);
-				--i;
-				continue;
-			}
-		}
-		for (int i = 0; i < lasers.size(); i++) {
-			bool markContinue = false;
-			for (int j = 0; j < enemies2.size(); j++)
-			{
-				if (enemies2[j]->GetCollision()->CheckCollision(lasers[i]->GetCollision()) && i < lasers.size() && j < enemies2.size())
-				{
-					// create particle effect
-					emitters.push_back(new Emitter(
-						110,							// Max particles
-						20,								// Particles per second
-						1,								// Particle lifetime
-						1.25f,							// Start size
-						0.75f,							// End size
-						XMFLOAT4(1, 0.1f, 0.1f, 0.7f),	// Start color
-						XMFLOAT4(1, 0.6f, 0.1f, 0.0f),		// End color
-						XMFLOAT3(0, 0, 0),				// Start velocity
-						XMFLOAT3(0.2f, 0.2f, 0.2f),		// Velocity randomness range
-						XMFLOAT3(
-							enemies2[j]->GetPosition().x,
-							enemies2[j]->GetPosition().y,
-							enemies2[j]->GetPosition().z),				// Emitter position
-						XMFLOAT3(0.1f, 0.1f, 0.1f),		// Position randomness range
-						XMFLOAT4(-2, 2, -2, 2),			// Random rotation ranges (startMin, startMax, endMin, endMax)
-						XMFLOAT3(0, 0, 0),				// Constant acceleration
-						device,
-						particleVS,
-						particlePS,
-						particleTexture));
-					delete enemies2[j];
-					enemies2.erase(enemies2.begin() + j);
-					j--;
-					score += 20;
-					PlaySound(TEXT("../../assets/Sounds/explosion.wav"), NULL, SND_ASYNC);
-					if (score >= hiScore)
-					{
-						hiScore = score;
-					}
-					markContinue = true;
-					continue;
-				}
-			}
-
-			if (markContinue) {
-				delete lasers[i];
-				lasers.erase(lasers.begin() + i);
-				i--;
-				continue;
-			}
+			SpawnLaser(player->GetPosition());
 		}
 
 		timer -= 1.0f * deltaTime;
 
-
-		
-
 		if (timer <= 0.0f)
 		{
-
-			enemy = new Entity(enemyMesh, enemyMaterial);
-			enemy->SetPosition(XMFLOAT3(-20, 0, 10));
-			enemy->SetScale(XMFLOAT3(0.02, 0.02, 0.02));
-			enemy->AttachCollider();
-			enemy->GetCollision()->SetPosition(enemy->GetPosition());
-			enemy->GetCollision()->SetScale(enemy->GetScale());
-			enemies.push_back(enemy);
+			SpawnEnemy(TEAM_ENEMY_LEFT, XMFLOAT3(-20, 0, 10));
 
 			//SoundStuff
 			PlaySound(TEXT("../../assets/Sounds/enemyshot.wav"), NULL, SND_ASYNC);
 
 
-			float r3 = 1.0f + static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / (3.0f - 1.0f)));
+			float r3 = spawnRandom.Range(1.0f, 3.0f);
 
 			timer = r3;
 		}
 
-			for (int i = 0; i < enemies.size(); i++)
-			{
-				float shoot1 = 0.1f + static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / (200.0f - 0.1f)));
-
-				if (shoot1 >= 1.0f && shoot1 <= 1.5f)
-				{
-					if (enemies[i]->GetPosition().x >= -7.0f || enemies[i]->GetPosition().x <= 7.0f)
-					{
-						enemyL = new Entity(sphereMesh, enemyMaterial);
-						enemyL->SetScale(XMFLOAT3(0.5, 0.5, 0.5));
-						enemyL->SetPosition(enemies[i]->GetPosition());
-						enemyL->AttachCollider();
-						enemyL->GetCollision()->SetPosition(enemies[i]->GetPosition());
-						enemyL->GetCollision()->SetScale(enemies[i]->GetScale());
-						enemyLasers.push_back(enemyL);
-					}
-				}
-			}
-
-
 		timer2 -= 2.0f * deltaTime;
 
 		if (timer2 <= 0.0f)
 		{
-			enemy = new Entity(enemyMesh, enemyMaterial);
-			enemy->SetPosition(XMFLOAT3(20, 0, 15));
-			enemy->SetScale(XMFLOAT3(0.02, 0.02, 0.02));
-			enemy->AttachCollider();
-			enemy->GetCollision()->SetPosition(enemy->GetPosition());
-			enemy->GetCollision()->SetScale(enemy->GetScale());
-			enemies2.push_back(enemy);
+			SpawnEnemy(TEAM_ENEMY_RIGHT, XMFLOAT3(20, 0, 15));
 
 			//SoundStuff
 			PlaySound(TEXT("../../assets/Sounds/enemyshot.wav"), NULL, SND_ASYNC);
 
-			float r3 = 2.5f + static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / (4.8f - 2.5f)));
+			float r3 = spawnRandom.Range(2.5f, 4.8f);
 			timer2 = r3;
 		}
-	
 
-		for (int i = 0; i < enemies2.size(); i++)
+		// Enemies fire at random
+		for (int a = 0; a < world->GetArchetypeCount(); a++)
 		{
-			float shoot2 = 0.1f + static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / (300.0f - 0.1f)));
+			Archetype* archetype = world->GetArchetype(a);
+			if (!archetype->Has(COMPONENT_TRANSFORM | COMPONENT_TEAM))
+				continue;
 
-			if (shoot2 >= 0.1f && shoot2 <= 1.2f)
+			// Spawning can add rows and archetypes, so only look at the rows that were here first
+			int count = archetype->Count();
+			for (int i = 0; i < count; i++)
 			{
-				if (enemies2[i]->GetPosition().x >= -7.0f || enemies2[i]->GetPosition().x <= 7.0f)
+				bool shoot = false;
+				if (archetype->Teams[i].Side == TEAM_ENEMY_LEFT)
+				{
+					float shoot1 = fireRandom.Range(0.1f, 200.0f);
+					shoot = shoot1 >= 1.0f && shoot1 <= 1.5f;
+				}
+				else if (archetype->Teams[i].Side == TEAM_ENEMY_RIGHT)
+				{
+					float shoot2 = fireRandom.Range(0.1f, 300.0f);
+					shoot = shoot2 >= 0.1f && shoot2 <= 1.2f;
+				}
+
+				if (shoot)
 				{
-					enemyL = new Entity(sphereMesh, enemyMaterial);
-					enemyL->SetScale(XMFLOAT3(0.5, 0.5, 0.5));
-					enemyL->SetPosition(enemies2[i]->GetPosition());
-					enemyL->AttachCollider();
-					enemyL->GetCollision()->SetPosition(enemies2[i]->GetPosition());
-					enemyL->GetCollision()->SetScale(enemies2[i]->GetScale());
-					enemyLasers.push_back(enemyL);
+					// Copy out first, spawning can move the arrays
+					TransformComponent enemyTransform = archetype->Transforms[i];
+					if (enemyTransform.Position.x >= -7.0f || enemyTransform.Position.x <= 7.0f)
+						SpawnEnemyLaser(enemyTransform.Position, enemyTransform.Scale);
 				}
 			}
 		}
 
-
-
-		float enemySpeed = 3.0f;
-		for (int i = 0; i < enemies.size(); i++)
+		// Systems - move everything, then drop whatever left the play area
+		world->UpdateMovement(deltaTime);
+		world->UpdateLifetimes(deltaTime);
+		world->CullOutOfBounds();
+		world->UpdateColliders();
+
+		// Collision ======================
+		// One sweep-and-prune pass finds every laser/enemy and enemy laser/player
+		// overlap instead of testing every laser against every enemy
+		bool playerHit = false;
+		int playerProxy = player->GetCollision()->GetProxy();
+		const std::vector<BroadphasePair>& pairs = broadphase->FindPairs();
+		for (size_t p = 0; p < pairs.size(); p++)
 		{
-			enemies[i]->SetPosition(XMFLOAT3(enemies[i]->GetPosition().x + (enemySpeed * 1.2f * deltaTime), enemies[i]->GetPosition().y, enemies[i]->GetPosition().z));
-			enemies[i]->GetCollision()->SetPosition(enemies[i]->GetPosition());
-			if (enemies[i]->GetPosition().x >= 30.0f && i < enemies.size())
+			// enemy laser hits the player, and the laser goes away
+			if (pairs[p].proxyA == playerProxy || pairs[p].proxyB == playerProxy)
 			{
-				delete enemies[i];
-				enemies.erase(enemies.begin() + i);
-				i--;
+				EntityHandle enemyLaser = world->GetProxyOwner(pairs[p].proxyA == playerProxy ? pairs[p].proxyB : pairs[p].proxyA);
+				if (world->IsAlive(enemyLaser))
+					world->Destroy(enemyLaser);
+				playerHit = true;
 				continue;
 			}
-		}
 
-		for (int i = 0; i < enemies2.size(); i++)
-		{
-			enemies2[i]->SetPosition(XMFLOAT3(enemies2[i]->GetPosition().x - (enemySpeed * deltaTime), enemies2[i]->GetPosition().y, enemies2[i]->GetPosition().z));
-			enemies2[i]->GetCollision()->SetPosition(enemies2[i]->GetPosition());
-			if (enemies2[i]->GetPosition().x <= -30.0f && i < enemies2.size())
-			{
-				delete enemies2[i];
-				enemies2.erase(enemies2.begin() + i);
-				i--;
+			// otherwise it's a laser hitting an enemy, and both go away
+			EntityHandle a = world->GetProxyOwner(pairs[p].proxyA);
+			EntityHandle b = world->GetProxyOwner(pairs[p].proxyB);
+			TeamComponent* teamA = world->GetTeam(a);
+			TeamComponent* teamB = world->GetTeam(b);
+
+			// one of them was already destroyed by an earlier pair this frame
+			if (!teamA || !teamB)
 				continue;
-			}
-		}
 
-		for (int i = 0; i < enemyLasers.size(); i++)
-		{
-			enemyLasers[i]->SetPosition(XMFLOAT3(enemyLasers[i]->GetPosition().x, enemyLasers[i]->GetPosition().y, enemyLasers[i]->GetPosition().z - (enemySpeed * deltaTime)));
-			enemyLasers[i]->GetCollision()->SetPosition(enemyLasers[i]->GetPosition());
-			if (enemyLasers[i]->GetPosition().z <= -3.0f && i < enemyLasers.size())
+			EntityHandle enemy = teamA->Side == TEAM_PLAYER_LASER ? b : a;
+			EntityHandle laser = teamA->Side == TEAM_PLAYER_LASER ? a : b;
+			Team enemySide = world->GetTeam(enemy)->Side;
+
+			// create particle effect
+			SpawnExplosion(world->GetTransform(enemy)->Position);
+
+			world->Destroy(enemy);
+			world->Destroy(laser);
+			score += enemySide == TEAM_ENEMY_LEFT ? 10 : 20;
+
+			PlaySound(TEXT("../../assets/Sounds/explosion.wav"), NULL, SND_ASYNC);
+			if (score >= hiScore)
 			{
-				delete enemyLasers[i];
-				enemyLasers.erase(enemyLasers.begin() + i);
-				i--;
-				continue;
+				hiScore = score;
 			}
 		}
-		for (int i = 0; i < enemyLasers.size(); i++)
+
+		if (playerHit)
 		{
-			if (player->GetCollision()->CheckCollision(enemyLasers[i]->GetCollision()) && i < enemyLasers.size())
-			{
-				delete enemyLasers[i];
-				delete player;
-				enemyLasers.erase(enemyLasers.begin() + i);
-				i = enemyLasers.size();
-				isAlive = false;
-				break;
-			}
+			delete player;
+			isAlive = false;
 		}
 
-
 		timerMusic -= 1.0 * deltaTime;
 		if (timerMusic <= 0.0f)
 		{
@@ -768,25 +769,71 @@ void Game::Update(float deltaTime, float totalTime)
 
 
 		greenPointLight.position.x += cos(totalTime) * deltaTime;
-
-
-		
-
-		// add all entities to entities for drawing
-		entities.push_back(player);
-		entities.insert(entities.end(), enemies.begin(), enemies.end());
-		entities.insert(entities.end(), enemies2.begin(), enemies2.end());
-		entities.insert(entities.end(), lasers.begin(), lasers.end());
-		entities.insert(entities.end(), enemyLasers.begin(), enemyLasers.end());
 	}
+	// A steady-state wave shouldn't touch the heap at all
+	updateAllocations = AllocationCounter::GetCount() - allocationsAtStart;
+
 	// Quit if the escape key is pressed
 	if (GetAsyncKeyState(VK_ESCAPE))
 		Quit();
 	if (!isAlive)
-	{
-		entities.clear();
 		Quit();
+}
+
+// --------------------------------------------------------
+// Sets up a material's shaders and lights, then draws a mesh
+// --------------------------------------------------------
+void Game::DrawMesh(Mesh* mesh, Material* material, XMFLOAT4X4 worldMatrix)
+{
+	// Quantized meshes need their own vertex shader, which also puts their
+	// positions back together
+	SimpleVertexShader* vertexShader = material->GetVertexShader();
+	if (mesh->IsQuantized())
+	{
+		vertexShader = vertexShaderQuantized;
+		vertexShader->SetFloat3("positionScale", mesh->GetQuantization().Scale);
+		vertexShader->SetFloat3("positionBias", mesh->GetQuantization().Bias);
 	}
+
+	// Setup Vertex and Pixel Shaders
+	material->PrepareMaterial(worldMatrix, camera->GetViewMatrix(), camera->GetProjectionMatrix(), vertexShader);
+
+	// Once you've set all of the data you care to change for
+	// the next draw call, you need to actually send it to the GPU
+	//  - If you skip this, the "SetMatrix" calls above won't make it to the GPU!
+	vertexShader->CopyAllBufferData();
+
+
+	// Set the vertex and pixel shaders to use for the next Draw() command
+	//  - These don't technically need to be set every frame...YET
+	//  - Once you start applying different shaders to different objects,
+	//    you'll need to swap the current shaders before each draw
+	vertexShader->SetShader();
+
+	// Send data to pixel shader
+	material->GetPixelShader()->SetData("light", //name of variable in shader
+		&light, sizeof(DirectionalLight));
+	material->GetPixelShader()->SetData("secondLight", //name of variable in shader
+		&redDirLight, sizeof(DirectionalLight));
+	material->GetPixelShader()->SetData("pointLight", //name of variable in shader
+		&greenPointLight, sizeof(PointLight));
+	material->GetPixelShader()->SetData("secondPointLight", //name of variable in shader
+		&whitePointLight, sizeof(PointLight));
+	material->GetPixelShader()->SetFloat3("cameraPosition", //name of variable in shader
+		camera->GetPosition());
+
+	material->GetPixelShader()->CopyAllBufferData();
+	material->GetPixelShader()->SetShader();
+
+	// Set buffers in the input assembler
+	//  - Do this ONCE PER OBJECT you're drawing, since each object might
+	//    have different geometry.
+	UINT stride = mesh->GetVertexStride();
+	UINT offset = 0;
+	ID3D11Buffer* vertexBuffer = mesh->GetVertexBuffer();
+	context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+	context->IASetIndexBuffer(mesh->GetIndexBuffer(), mesh->GetIndexFormat(), 0);
+	context->DrawIndexed(mesh->GetIndexCount(), 0, 0);
 }
 
 // --------------------------------------------------------
@@ -809,51 +856,30 @@ void Game::Draw(float deltaTime, float totalTime)
 			1.0f,
 			0);
 
+		// Rebuild only the world matrices that went stale this frame
+		int playerMatricesRebuilt = player->IsWorldMatrixStale() ? 1 : 0;
+		world->UpdateTransforms();
+
 		// Send data to shader variables
 		//  - This is actually a complex process of copying data to a local buffer
 		//    and then copying that entire buffer to the GPU.  
 		//  - The "SimpleShader" class handles all of that for you.
-		for (int i = 0; i < entities.size(); i++) {
-
-			// Setup Vertex and Pixel Shaders
-			entities[i]->PrepareMaterial(camera->GetViewMatrix(), camera->GetProjectionMatrix());
-
-			// Once you've set all of the data you care to change for
-			// the next draw call, you need to actually send it to the GPU
-			//  - If you skip this, the "SetMatrix" calls above won't make it to the GPU!
-			entities[i]->GetMaterial()->GetVertexShader()->CopyAllBufferData();
-
-
-			// Set the vertex and pixel shaders to use for the next Draw() command
-			//  - These don't technically need to be set every frame...YET
-			//  - Once you start applying different shaders to different objects,
-			//    you'll need to swap the current shaders before each draw
-			entities[i]->GetMaterial()->GetVertexShader()->SetShader();
-
-			// Send data to pixel shader
-			entities[i]->GetMaterial()->GetPixelShader()->SetData("light", //name of variable in shader
-				&light, sizeof(DirectionalLight));
-			entities[i]->GetMaterial()->GetPixelShader()->SetData("secondLight", //name of variable in shader
-				&redDirLight, sizeof(DirectionalLight));
-			entities[i]->GetMaterial()->GetPixelShader()->SetData("pointLight", //name of variable in shader
-				&greenPointLight, sizeof(PointLight));
-			entities[i]->GetMaterial()->GetPixelShader()->SetData("secondPointLight", //name of variable in shader
-				&whitePointLight, sizeof(PointLight));
-			entities[i]->GetMaterial()->GetPixelShader()->SetFloat3("cameraPosition", //name of variable in shader
-				camera->GetPosition());
-
-			entities[i]->GetMaterial()->GetPixelShader()->CopyAllBufferData();
-			entities[i]->GetMaterial()->GetPixelShader()->SetShader();
-
-			// Set buffers in the input assembler
-			//  - Do this ONCE PER OBJECT you're drawing, since each object might
-			//    have different geometry.
-			UINT stride = sizeof(Vertex);
-			UINT offset = 0;
-			ID3D11Buffer* vertexBuffer = entities[i]->GetMesh()->GetVertexBuffer();
-			context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-			context->IASetIndexBuffer(entities[i]->GetMesh()->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
-			context->DrawIndexed(entities[i]->GetMesh()->GetIndexCount(), 0, 0);
+		DrawMesh(player->GetMesh(), player->GetMaterial(), player->GetWorldMatrix());
+
+		// Everything else is drawn straight out of the World's arrays
+		for (int a = 0; a < world->GetArchetypeCount(); a++)
+		{
+			Archetype* archetype = world->GetArchetype(a);
+			if (!archetype->Has(COMPONENT_TRANSFORM | COMPONENT_RENDER))
+				continue;
+
+			for (int i = 0; i < archetype->Count(); i++)
+			{
+				DrawMesh(
+					archetype->Renders[i].RenderMesh,
+					archetype->Renders[i].RenderMaterial,
+					archetype->Transforms[i].World);
+			}
 		}
 
 		//// Skybox drawing ===============
@@ -869,7 +895,7 @@ void Game::Draw(float deltaTime, float totalTime)
 
 		// Set buffers in the input assembler
 		context->IASetVertexBuffers(0, 1, &skyVB, &stride, &offset);
-		context->IASetIndexBuffer(skyIB, DXGI_FORMAT_R32_UINT, 0);
+		context->IASetIndexBuffer(skyIB, cubeMesh->GetIndexFormat(), 0);
 
 		// Set up the new sky shaders
 		skyVS->SetMatrix4x4("view", camera->GetViewMatrix());
@@ -895,17 +921,19 @@ void Game::Draw(float deltaTime, float totalTime)
 
 			// Particle states
 			float blend[4] = { 1,1,1,1 };
-			context->OMSetBlendState(particleBlendState, blend, 0xffffffff);	// Additive blending
+			// Additive blending doesn't care about order, alpha blending needs the particles sorted
+			if (particleSystem->IsSorted())
+				context->OMSetBlendState(particleAlphaBlendState, blend, 0xffffffff);
+			else
+				context->OMSetBlendState(particleBlendState, blend, 0xffffffff);
 			context->OMSetDepthStencilState(particleDepthState, 0);				// No depth WRITING
 
 			// No wireframe debug
 			particlePS->SetInt("debugWireframe", 0);
 			particlePS->CopyAllBufferData();
 
-			// Draw the emitters
-			for (int i = 0; i < emitters.size(); i++) {
-				emitters[i]->Draw(context, camera);
-			}
+			// Draw every emitter at once
+			particleSystem->Draw(context, camera);
 
 			// Reset to default states for next frame
 			context->OMSetBlendState(0, blend, 0xffffffff);
@@ -938,6 +966,25 @@ void Game::Draw(float deltaTime, float totalTime)
 			dynamicText.c_str(),
 			XMFLOAT2(10, 40));
 
+#if defined(DEBUG) || defined(_DEBUG)
+		// Per-frame stats
+		const ParticleBudgetStats& budgetStats = particleSystem->GetBudgetStats();
+		std::wstring statsText =
+			L"World matrices rebuilt: " + std::to_wstring(world->GetMatricesRebuilt() + playerMatricesRebuilt) + L" / " + std::to_wstring(world->GetEntityCount() + 1) +
+			L"\nHeap allocations in Update: " + std::to_wstring(updateAllocations) +
+			L"\nWorld entities: " + std::to_wstring(world->GetEntityCount()) +
+			L"\nParticles: " + std::to_wstring(particleSystem->GetLivingParticleCount()) + L" alive, " +
+				std::to_wstring(budgetStats.Granted) + L" / " + std::to_wstring(budgetStats.Requested) + L" granted, budget " + std::to_wstring(budgetStats.Budget) +
+			L"\nEmitters: " + std::to_wstring(particleSystem->GetEmitterCount()) + L" (" + std::to_wstring(particleSystem->GetCulledEmitterCount()) + L" culled, " +
+				std::to_wstring(budgetStats.ThrottledEmitters) + L" throttled, " + std::to_wstring(budgetStats.DroppedEmitters) + L" dropped, " +
+				std::to_wstring(budgetStats.EvictedEmitters) + L" evicted, " + std::to_wstring(budgetStats.RejectedSpawns) + L" rejected)" +
+			L"\nParticle upload: " + std::to_wstring(particleSystem->GetUploadedBytes() / 1024) + L" KB";
+		spriteFont->DrawString(
+			spriteBatch,
+			statsText.c_str(),
+			XMFLOAT2(10, 120));
+#endif
+
 		spriteBatch->End();
 
 		fontSheet->Release();
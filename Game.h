@@ -9,7 +9,11 @@
 #include "Camera.h"
 #include "Material.h"
 #include "Lights.h"
-#include "Emitter.h"
+#include "ParticleSystem.h"
+#include "ParticleEffect.h"
+#include "Broadphase.h"
+#include "World.h"
+#include "Random.h"
 #include "WICTextureLoader.h"
 #include "DDSTextureLoader.h"
 #include "SpriteBatch.h"
@@ -56,6 +60,9 @@ private:
 	SimpleVertexShader* vertexShaderSpecularMap;
 	SimplePixelShader* pixelShaderSpecularMap;
 
+	// Stands in for a material's vertex shader when drawing a quantized mesh
+	SimpleVertexShader* vertexShaderQuantized;
+
 	// Matrices handled by Camera and Entities
 
 	// Keeps track of the old mouse position.  Useful for 
@@ -67,21 +74,34 @@ private:
 	Mesh* playerMesh;
 
 	Entity* player;
-	Entity* enemy;
-	Entity* playerL;
-	Entity* enemyL;
 
-	std::vector<Entity*> entities;
-	std::vector<Entity*> enemies;
-	std::vector<Entity*> enemies2;
-	std::vector<Entity*> lasers;
-	std::vector<Entity*> enemyLasers;
+	// Lasers and enemies live in the World's component arrays
+	static const int maxWorldEntities = 512;
+	World* world;
+	EntityHandle SpawnLaser(DirectX::XMFLOAT3 position);
+	EntityHandle SpawnEnemy(Team side, DirectX::XMFLOAT3 position);
+	EntityHandle SpawnEnemyLaser(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 colliderScale);
+	void SpawnExplosion(DirectX::XMFLOAT3 position);
+
+	// Shared per-draw setup for anything drawn with a Material
+	void DrawMesh(Mesh* mesh, Material* material, DirectX::XMFLOAT4X4 worldMatrix);
+
+	// Collision
+	Broadphase* broadphase;
+
+	// Heap allocations made during the last Update (debug builds only)
+	long long updateAllocations;
 
 	float timer = 3.0f;
 	float timer2 = 4.0f;
 
 	float timerMusic = 483.0f;
 
+	// Gameplay randomness - enemy spawn timing and enemy fire get their own streams
+	unsigned long long sessionSeed;
+	Random spawnRandom;
+	Random fireRandom;
+
 	Camera* camera;
 
 	Material* fabricMaterial;
@@ -116,7 +136,15 @@ private:
 	SimplePixelShader* particlePS;
 	ID3D11DepthStencilState* particleDepthState;
 	ID3D11BlendState* particleBlendState;
-	std::vector<Emitter*> emitters;
+	ID3D11BlendState* particleAlphaBlendState;
+
+	// Every explosion shares the system's particle store and buffers
+	static const int maxParticles = 8192;
+	static const int maxEmitters = 64;
+	static const int particleBudget = 4096;	// Most particles alive at once, emitters are throttled to fit
+	ParticleSystem* particleSystem;
+	WorkerPool* workerPool;	// Spreads particle simulation across the other cores
+	EmitterSettings explosionSettings;
 
 
 	ID3D11SamplerState* samplerState;
@@ -0,0 +1,104 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	data = 0;
+	size = 0;
+#if defined(_WIN32)
+	file = INVALID_HANDLE_VALUE;
+	mapping = 0;
+#else
+	file = -1;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const char* path)
+{
+	Close();
+
+#if defined(_WIN32)
+	file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+	if (!mapping)
+	{
+		Close();
+		return false;
+	}
+
+	data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	size = (size_t)fileSize.QuadPart;
+#else
+	file = open(path, O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+
+	void* view = mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	data = view == MAP_FAILED ? 0 : (const unsigned char*)view;
+	size = (size_t)info.st_size;
+#endif
+
+	if (!data)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+	if (data) UnmapViewOfFile(data);
+	if (mapping) CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+	mapping = 0;
+	file = INVALID_HANDLE_VALUE;
+#else
+	if (data) munmap((void*)data, size);
+	if (file >= 0) close(file);
+	file = -1;
+#endif
+	data = 0;
+	size = 0;
+}
+
+const unsigned char* MappedFile::GetData()
+{
+	return data;
+}
+
+size_t MappedFile::GetSize()
+{
+	return size;
+}
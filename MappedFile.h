@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+// --------------------------------------------------------
+// A whole file mapped read only into memory
+//
+// The OS pages the contents in as they're touched, so nothing
+// is copied into a buffer of our own.  Unmapped on Close or
+// when the object goes away.
+// --------------------------------------------------------
+class MappedFile
+{
+	const unsigned char* data;
+	size_t size;
+
+#if defined(_WIN32)
+	void* file;
+	void* mapping;
+#else
+	int file;
+#endif
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// False if the file can't be opened or is empty
+	bool Open(const char* path);
+	void Close();
+
+	const unsigned char* GetData();
+	size_t GetSize();
+};
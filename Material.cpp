@@ -46,3 +46,25 @@ ID3D11SamplerState* Material::GetSamplerState()
 {
 	return samplerState;
 }
+
+void Material::PrepareMaterial(DirectX::XMFLOAT4X4 worldMatrix, DirectX::XMFLOAT4X4 viewMatrix, DirectX::XMFLOAT4X4 projectionMatrix,
+	SimpleVertexShader* drawVertexShader)
+{
+	// Set vertex shader data for materials
+	if (!drawVertexShader)
+		drawVertexShader = vertexShader;
+	drawVertexShader->SetMatrix4x4("world", worldMatrix);
+	drawVertexShader->SetMatrix4x4("view", viewMatrix);
+	drawVertexShader->SetMatrix4x4("projection", projectionMatrix);
+
+	// Set pixel shader data for textures
+	pixelShader->SetShaderResourceView("diffuseTexture", textureSRV);
+	if (specularSRV) {
+		pixelShader->SetShaderResourceView("specularTexture", specularSRV);
+	}
+	if (normalMapSRV) {
+		pixelShader->SetShaderResourceView("normalMap", normalMapSRV);
+	}
+
+	pixelShader->SetSamplerState("basicSampler", samplerState);
+}
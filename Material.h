@@ -15,6 +15,11 @@ public:
 	ID3D11ShaderResourceView* GetSpecularSRV();
 	ID3D11ShaderResourceView* GetNormalMapSRV();
 	ID3D11SamplerState* GetSamplerState();
+
+	// Sets the matrices, textures and sampler for the next draw.  The matrices
+	// go to drawVertexShader instead when the mesh needs a different one.
+	void PrepareMaterial(DirectX::XMFLOAT4X4 worldMatrix, DirectX::XMFLOAT4X4 viewMatrix, DirectX::XMFLOAT4X4 projectionMatrix,
+		SimpleVertexShader* drawVertexShader = 0);
 private:
 	SimpleVertexShader* vertexShader;
 	SimplePixelShader* pixelShader;
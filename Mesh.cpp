@@ -1,277 +1,186 @@
 #include "Mesh.h"
+#include "MeshStreaming.h"
+#include "MeshWelding.h"
+#include "MeshOptimizer.h"
+#include "AllocationCounter.h"
+
+#if defined(DEBUG) || defined(_DEBUG)
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#endif
 
 // For the DirectX Math library
 using namespace DirectX;
 // Vertices == vertices of mesh we want to draw
 // numVertices == number of vertices
-// indices == which vertices to use and in which order, not required if vertices are in buffer
+// indices == which vertices to use and in which order, three per triangle
+// numIndices == number of indices
 // device == object that creates buffers
-Mesh::Mesh(Vertex* vertices, int numVertices, unsigned int indices[], ID3D11Device* device)
+Mesh::Mesh(Vertex* vertices, int numVertices, unsigned int indices[], int numIndices, ID3D11Device* device)
 {
-	//vertsFromMesh = 0;
 	vertexBuffer = 0;
 	indexBuffer = 0;
 	indexCount = 0;
-	Init(vertices, numVertices, indices, device);
+	indexFormat = DXGI_FORMAT_R32_UINT;
+	bounds = MeshBounds();
+	quantized = false;
+	quantization = MeshQuantization();
+	quantizationError = QuantizationError();
+	loadMemory = MeshLoadMemory();
+	Init(vertices, numVertices, indices, numIndices, device);
+	originalCacheStats = cacheStats;
 }
 
 // Load files through this constructor
-Mesh::Mesh(const char* objFile, ID3D11Device* device)
+Mesh::Mesh(const char* objFile, ID3D11Device* device, float weldEpsilon, bool quantize)
 {
-	//vertsFromMesh = 0;
 	vertexBuffer = 0;
 	indexBuffer = 0;
 	indexCount = 0;
-	// File input object
-	std::ifstream obj(objFile);
+	indexFormat = DXGI_FORMAT_R32_UINT;
+	bounds = MeshBounds();
+	originalCacheStats = VertexCacheStats();
+	cacheStats = VertexCacheStats();
+	quantized = quantize;
+	quantization = MeshQuantization();
+	quantizationError = QuantizationError();
+	loadMemory = MeshLoadMemory();
+
+#if defined(DEBUG) || defined(_DEBUG)
+	// Everything Load allocates and doesn't free is what the mesh keeps
+	PROCESS_MEMORY_COUNTERS startCounters = {};
+	GetProcessMemoryInfo(GetCurrentProcess(), &startCounters, sizeof(startCounters));
+	AllocationCounter::ResetPeakBytes();
+	long long startHeap = AllocationCounter::GetLiveBytes();
+#endif
+
+	Load(objFile, device, weldEpsilon);
+
+#if defined(DEBUG) || defined(_DEBUG)
+	PROCESS_MEMORY_COUNTERS endCounters = {};
+	GetProcessMemoryInfo(GetCurrentProcess(), &endCounters, sizeof(endCounters));
+	loadMemory.PeakHeapBytes = AllocationCounter::GetPeakBytes() - startHeap;
+	loadMemory.RetainedHeapBytes = AllocationCounter::GetLiveBytes() - startHeap;
+	loadMemory.PeakWorkingSetBytes = (long long)endCounters.PeakWorkingSetSize - (long long)startCounters.PeakWorkingSetSize;
+	loadMemory.RetainedWorkingSetBytes = (long long)endCounters.WorkingSetSize - (long long)startCounters.WorkingSetSize;
+#endif
+}
 
-	// Check for successful open
-	if (!obj.is_open())
+void Mesh::Load(const char* objFile, ID3D11Device* device, float weldEpsilon)
+{
+	// Hash the OBJ's bytes - if a cache was built from exactly this
+	// file, the buffers come straight out of the cache's mapping.
+	// Otherwise the same mapping gets parsed below.
+	MappedFile obj;
+	if (!obj.Open(objFile))
 		return;
+	unsigned long long objHash = MeshCache::Hash(obj.GetData(), obj.GetSize());
 
-	// Variables used while reading the file
-	std::vector<XMFLOAT3> positions;     // Positions from the file
-	std::vector<XMFLOAT3> normals;       // Normals from the file
-	std::vector<XMFLOAT2> uvs;           // UVs from the file
-	std::vector<Vertex> verts;           // Verts we're assembling
-	std::vector<UINT> indices;           // Indices of these verts
-	unsigned int vertCounter = 0;        // Count of vertices/indices
-	char chars[100];                     // String for line reading
-
-
-
-
-	bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, objFile);
-	// Still have data left?
-
-	if (!warn.empty()) {
-		std::cout << warn << std::endl;
-	}
+	// A cache welded with a different epsilon holds different vertices
+	if (weldEpsilon > 0.0f)
+		objHash ^= MeshCache::Hash(&weldEpsilon, sizeof(weldEpsilon));
 
-	if (!err.empty()) {
-		std::cerr << err << std::endl;
+	std::string cachePath = std::string(objFile) + ".meshcache";
+	MeshCache cache;
+	if (cache.Open(cachePath.c_str(), objHash))
+	{
+		const MeshCacheHeader& header = cache.GetHeader();
+		const Vertex* cachedVerts = cache.GetVertices();
+		bounds = header.Bounds;
+		originalCacheStats = header.OriginalCacheStats;
+		cacheStats = header.CacheStats;
+		CreateBuffers(cachedVerts, header.VertexCount, cache.GetIndices(), header.IndexCount, header.IndexSize, device);
+		return;
 	}
 
+	std::vector<Vertex> verts;           // Verts we're assembling
+	std::vector<UINT> indices;           // Indices of these verts
 
-	// Loop over shapes
-	indexCount = 0;
-	for (size_t s = 0; s < shapes.size(); s++) {
-		// Loop over faces(polygon)
-		size_t index_offset = 0;
-		for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
-			int fv = shapes[s].mesh.num_face_vertices[f];
-
-			// Loop over vertices in the face.
-			for (size_t v = 0; v < fv; v++) {
-				// access to vertex
-				tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
-				tinyobj::real_t vx = attrib.vertices[3 * idx.vertex_index + 0];
-				tinyobj::real_t vy = attrib.vertices[3 * idx.vertex_index + 1];
-				tinyobj::real_t vz = attrib.vertices[3 * idx.vertex_index + 2];
-				tinyobj::real_t nx = attrib.normals[3 * idx.normal_index + 0];
-				tinyobj::real_t ny = attrib.normals[3 * idx.normal_index + 1];
-				tinyobj::real_t nz = attrib.normals[3 * idx.normal_index + 2];
-				tinyobj::real_t tx = attrib.texcoords[2 * idx.texcoord_index + 0];
-				tinyobj::real_t ty = attrib.texcoords[2 * idx.texcoord_index + 1];
-
-				Vertex temp = {};
-				temp.Position.x = vx;
-				temp.Position.y = vy;
-				temp.Position.z = vz;
-				temp.Normal.x = nx;
-				temp.Normal.y = ny;
-				temp.Normal.z = nz;
-				temp.UV.x = tx;
-				temp.UV.y = ty;
-				verts.push_back(temp);
-				indices.push_back(indexCount);
-				indexCount++;
-			}
-			index_offset += fv;
-
-			// per-face material
-			shapes[s].mesh.material_ids[f];
-		}
-	}
-
+	// One vertex per distinct corner, with real indices into them, built
+	// while the file is read - nothing else from the OBJ outlives this
+	bool ret = MeshStreaming::LoadObj(obj.GetData(), obj.GetSize(), &verts, &indices);
+	obj.Close();
+	if (!ret)
+		return;
 
+	MeshWelding::WeldByValue(weldEpsilon, &verts, &indices);
 
-	/*while (obj.good())
+	// Cache-friendly triangle order, then outward-facing clusters first,
+	// then vertices in the order they're used
+	if (!indices.empty())
 	{
-		// Get the line (100 characters should be more than enough)
-		obj.getline(chars, 100);
-
-		// Check the type of line
-		if (chars[0] == 'v' && chars[1] == 'n')
-		{
-			// Read the 3 numbers directly into an XMFLOAT3
-			XMFLOAT3 norm;
-			sscanf_s(
-				chars,
-				"vn %f %f %f",
-				&norm.x, &norm.y, &norm.z);
-
-			// Add to the list of normals
-			normals.push_back(norm);
-		}
-		else if (chars[0] == 'v' && chars[1] == 't')
-		{
-			// Read the 2 numbers directly into an XMFLOAT2
-			XMFLOAT2 uv;
-			sscanf_s(
-				chars,
-				"vt %f %f",
-				&uv.x, &uv.y);
-
-			// Add to the list of uv's
-			uvs.push_back(uv);
-		}
-		else if (chars[0] == 'v')
-		{
-			// Read the 3 numbers directly into an XMFLOAT3
-			XMFLOAT3 pos;
-			sscanf_s(
-				chars,
-				"v %f %f %f",
-				&pos.x, &pos.y, &pos.z);
-
-			// Add to the positions
-			positions.push_back(pos);
-		}
-		else if (chars[0] == 'f')
-		{
-			// Read the face indices into an array
-			unsigned int i[12];
-			int facesRead = sscanf_s(
-				chars,
-				"f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d",
-				&i[0], &i[1], &i[2],
-				&i[3], &i[4], &i[5],
-				&i[6], &i[7], &i[8],
-				&i[9], &i[10], &i[11]);
-
-			// - Create the verts by looking up
-			//    corresponding data from vectors
-			// - OBJ File indices are 1-based, so
-			//    they need to be adusted
-			Vertex v1;
-			v1.Position = positions[i[0] - 1];
-			v1.UV = uvs[i[1] - 1];
-			v1.Normal = normals[i[2] - 1];
-
-			Vertex v2;
-			v2.Position = positions[i[3] - 1];
-			v2.UV = uvs[i[4] - 1];
-			v2.Normal = normals[i[5] - 1];
-
-			Vertex v3;
-			v3.Position = positions[i[6] - 1];
-			v3.UV = uvs[i[7] - 1];
-			v3.Normal = normals[i[8] - 1];
-
-			// The model is most likely in a right-handed space,
-			// especially if it came from Maya.  We want to convert
-			// to a left-handed space for DirectX.  This means we 
-			// need to:
-			//  - Invert the Z position
-			//  - Invert the normal's Z
-			//  - Flip the winding order
-			// We also need to flip the UV coordinate since DirectX
-			// defines (0,0) as the top left of the texture, and many
-			// 3D modeling packages use the bottom left as (0,0)
-
-			// Flip the UV's since they're probably "upside down"
-			v1.UV.y = 1.0f - v1.UV.y;
-			v2.UV.y = 1.0f - v2.UV.y;
-			v3.UV.y = 1.0f - v3.UV.y;
-
-			// Flip Z (LH vs. RH)
-			v1.Position.z *= -1.0f;
-			v2.Position.z *= -1.0f;
-			v3.Position.z *= -1.0f;
-
-			// Flip normal Z
-			v1.Normal.z *= -1.0f;
-			v2.Normal.z *= -1.0f;
-			v3.Normal.z *= -1.0f;
-
-			// Add the verts to the vector (flipping the winding order)
-			verts.push_back(v1);
-			verts.push_back(v3);
-			verts.push_back(v2);
-
-			// Add three more indices
-			indices.push_back(vertCounter); vertCounter += 1;
-			indices.push_back(vertCounter); vertCounter += 1;
-			indices.push_back(vertCounter); vertCounter += 1;
-
-			// Was there a 4th face?
-			if (facesRead == 12)
-			{
-				// Make the last vertex
-				Vertex v4;
-				v4.Position = positions[i[9] - 1];
-				v4.UV = uvs[i[10] - 1];
-				v4.Normal = normals[i[11] - 1];
-
-				// Flip the UV, Z pos and normal
-				v4.UV.y = 1.0f - v4.UV.y;
-				v4.Position.z *= -1.0f;
-				v4.Normal.z *= -1.0f;
-
-				// Add a whole triangle (flipping the winding order)
-				verts.push_back(v1);
-				verts.push_back(v4);
-				verts.push_back(v3);
-
-				// Add three more indices
-				indices.push_back(vertCounter); vertCounter += 1;
-				indices.push_back(vertCounter); vertCounter += 1;
-				indices.push_back(vertCounter); vertCounter += 1;
-			}
-		}
-	}*/
-
-	// Close the file and create the actual buffers
-	obj.close();
-
+		originalCacheStats = MeshOptimizer::AnalyzeVertexCache(&indices[0], (int)indices.size(), (int)verts.size());
+		MeshOptimizer::OptimizeVertexCache(&indices[0], (int)indices.size(), (int)verts.size());
+		MeshOptimizer::OptimizeOverdraw(&verts[0], (int)verts.size(), &indices[0], (int)indices.size());
+		verts.resize(MeshOptimizer::OptimizeVertexFetch(&verts[0], (int)verts.size(), &indices[0], (int)indices.size()));
+	}
 
 	// - At this point, "verts" is a vector of Vertex structs, and can be used
 	//    directly to create a vertex buffer:  &verts[0] is the address of the first vert
 	//
 	// - The vector "indices" is similar. It's a vector of unsigned ints and
 	//    can be used directly for the index buffer: &indices[0] is the address of the first int
-	//
-	// - "vertCounter" is BOTH the number of vertices and the number of indices
-	// - Yes, the indices are a bit redundant here (one per vertex).  Could you skip using
-	//    an index buffer in this case?  Sure!  Though, if your mesh class assumes you have
-	//    one, you'll need to write some extra code to handle cases when you don't.
 
 
-	vertCounter=indexCount;
-	//vertsFromMesh = verts;
-	Init(&verts[0], vertCounter, &indices[0], device);
+	// Nothing usable in the file
+	if (verts.empty())
+		return;
+
+	// Finished vertices (with tangents) get cached for next time
+	Init(&verts[0], (int)verts.size(), &indices[0], (int)indices.size(), device, cachePath.c_str(), objHash);
 }
 
-void Mesh::Init(Vertex* vertices, int numVertices, unsigned int indices[], ID3D11Device* device)
+void Mesh::Init(Vertex* vertices, int numVertices, unsigned int indices[], int numIndices, ID3D11Device* device,
+	const char* cachePath, unsigned long long sourceHash)
 {
-	indexCount = numVertices;
-	
-	for (int i = 0; i < indexCount; i++)
+	CalculateTangents(vertices, numVertices, indices, numIndices);
+	CalculateBounds(vertices, numVertices);
+	cacheStats = MeshOptimizer::AnalyzeVertexCache(indices, numIndices, numVertices);
+
+	// Half the index memory and bandwidth whenever 16 bits can reach every vertex
+	std::vector<unsigned short> shortIndices;
+	const void* indexData = indices;
+	int indexSize = sizeof(unsigned int);
+	if (numVertices <= 65536 && numIndices > 0)
 	{
-		
-		vertsFromMesh.push_back(vertices[i]);
+		shortIndices.resize(numIndices);
+		for (int i = 0; i < numIndices; i++)
+			shortIndices[i] = (unsigned short)indices[i];
+		indexData = &shortIndices[0];
+		indexSize = sizeof(unsigned short);
 	}
 
-	CalculateTangents(vertices, numVertices, indices);
+	CreateBuffers(vertices, numVertices, indexData, numIndices, indexSize, device);
+
+	if (cachePath)
+		MeshCache::Write(cachePath, sourceHash, vertices, numVertices, indexData, numIndices, indexSize, bounds, originalCacheStats, cacheStats);
+}
+
+// Makes the GPU buffers from data that's already finished (tangents and all).
+// indexSize is 2 or 4 bytes.  Quantized meshes get encoded here, with the
+// bounds that are already calculated.
+void Mesh::CreateBuffers(const Vertex* vertices, int numVertices, const void* indices, int numIndices, int indexSize, ID3D11Device* device)
+{
+	indexCount = numIndices;
+	indexFormat = indexSize == sizeof(unsigned short) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 
+	std::vector<QuantizedVertex> quantizedVertices;
+	const void* vertexData = vertices;
+	if (quantized)
+	{
+		quantization = MeshQuantizer::Calculate(bounds);
+		quantizedVertices.resize(numVertices);
+		MeshQuantizer::Encode(quantization, vertices, numVertices, &quantizedVertices[0]);
+		quantizationError = MeshQuantizer::MeasureError(quantization, vertices, &quantizedVertices[0], numVertices);
+		vertexData = &quantizedVertices[0];
+	}
 
 	// Create the VERTEX BUFFER description -----------------------------------
 	// - The description is created on the stack because we only need
 	//    it to create the buffer.  The description is then useless.
 	D3D11_BUFFER_DESC vbd;
 	vbd.Usage = D3D11_USAGE_IMMUTABLE;
-	vbd.ByteWidth = sizeof(Vertex) * indexCount; // numVertices == number of vertices in the buffer
+	vbd.ByteWidth = GetVertexStride() * numVertices; // numVertices == number of vertices in the buffer
 	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER; // Tells DirectX this is a vertex buffer
 	vbd.CPUAccessFlags = 0;
 	vbd.MiscFlags = 0;
@@ -280,7 +189,7 @@ void Mesh::Init(Vertex* vertices, int numVertices, unsigned int indices[], ID3D1
 	// Create the proper struct to hold the initial vertex data
 	// - This is how we put the initial data into the buffer
 	D3D11_SUBRESOURCE_DATA initialVertexData;
-	initialVertexData.pSysMem = vertices;
+	initialVertexData.pSysMem = vertexData;
 
 	// Actually create the buffer with the initial data
 	// - Once we do this, we'll NEVER CHANGE THE BUFFER AGAIN
@@ -291,7 +200,7 @@ void Mesh::Init(Vertex* vertices, int numVertices, unsigned int indices[], ID3D1
 	//    it to create the buffer.  The description is then useless.
 	D3D11_BUFFER_DESC ibd;
 	ibd.Usage = D3D11_USAGE_IMMUTABLE;
-	ibd.ByteWidth = sizeof(int) * indexCount;         // 3 = number of indices in the buffer
+	ibd.ByteWidth = indexSize * indexCount;
 	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER; // Tells DirectX this is an index buffer
 	ibd.CPUAccessFlags = 0;
 	ibd.MiscFlags = 0;
@@ -309,7 +218,8 @@ void Mesh::Init(Vertex* vertices, int numVertices, unsigned int indices[], ID3D1
 
 // Calculates the tangents of the vertices in a mesh
 // Code adapted from: http://www.terathon.com/code/tangent.html
-void Mesh::CalculateTangents(Vertex* vertices, int numVertices, unsigned int* indices)
+// Shared vertices add up the tangents of every triangle using them
+void Mesh::CalculateTangents(Vertex* vertices, int numVertices, unsigned int* indices, int numIndices)
 {
 	// Reset tangents
 	for (int i = 0; i < numVertices; i++)
@@ -318,7 +228,7 @@ void Mesh::CalculateTangents(Vertex* vertices, int numVertices, unsigned int* in
 	}
 
 	// Calculate tangents one whole triangle at a time
-	for (int i = 0; i < numVertices;)
+	for (int i = 0; i + 2 < numIndices;)
 	{
 		// Grab indices and vertices of first triangle
 		unsigned int i1 = indices[i++];
@@ -344,8 +254,13 @@ void Mesh::CalculateTangents(Vertex* vertices, int numVertices, unsigned int* in
 		float s2 = v3->UV.x - v1->UV.x;
 		float t2 = v3->UV.y - v1->UV.y;
 
-		// Create vectors for tangent calculation
-		float r = 1.0f / (s1 * t2 - s2 * t1);
+		// Create vectors for tangent calculation - skipping triangles with no
+		// UV area, whose infinite tangent would spread to every triangle they
+		// share a vertex with
+		float uvArea = s1 * t2 - s2 * t1;
+		if (uvArea == 0.0f)
+			continue;
+		float r = 1.0f / uvArea;
 
 		float tx = (t2 * x1 - t1 * x2) * r;
 		float ty = (t2 * y1 - t1 * y2) * r;
@@ -387,65 +302,44 @@ void Mesh::CalculateTangents(Vertex* vertices, int numVertices, unsigned int* in
 
 
 
-void Mesh::CalculateObject(Vertex* vertices, int numVertices, unsigned int* indices,std::string object)
+// Calculates the local AABB and bounding sphere once so colliders
+// never need to look at the vertices themselves
+void Mesh::CalculateBounds(Vertex* vertices, int numVertices)
 {
-
-	inputfile = object;
-
-	bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, inputfile.c_str());
-
-	if (!warn.empty()) {
-		std::cout << warn << std::endl;
-	}
-
-	if (!err.empty()) {
-		std::cerr << err << std::endl;
+	if (numVertices <= 0)
+	{
+		bounds.Min = XMFLOAT3(0, 0, 0);
+		bounds.Max = XMFLOAT3(0, 0, 0);
+		bounds.Center = XMFLOAT3(0, 0, 0);
+		bounds.Radius = 0;
+		return;
 	}
 
-	if (!ret) {
-		exit(1);
+	// Min/max reduction, all three axes at once
+	XMVECTOR minVec = XMLoadFloat3(&vertices[0].Position);
+	XMVECTOR maxVec = minVec;
+	for (int i = 1; i < numVertices; i++)
+	{
+		XMVECTOR pos = XMLoadFloat3(&vertices[i].Position);
+		minVec = XMVectorMin(minVec, pos);
+		maxVec = XMVectorMax(maxVec, pos);
 	}
 
-	// Loop over shapes
-	for (size_t s = 0; s < shapes.size(); s++) {
-		// Loop over faces(polygon)
-		size_t index_offset = 0;
-		for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
-			int fv = shapes[s].mesh.num_face_vertices[f];
-
-			// Loop over vertices in the face.
-			for (size_t v = 0; v < fv; v++) {
-				// access to vertex
-				tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
-				tinyobj::real_t vx = attrib.vertices[3 * idx.vertex_index + 0];
-				tinyobj::real_t vy = attrib.vertices[3 * idx.vertex_index + 1];
-				tinyobj::real_t vz = attrib.vertices[3 * idx.vertex_index + 2];
-				tinyobj::real_t nx = attrib.normals[3 * idx.normal_index + 0];
-				tinyobj::real_t ny = attrib.normals[3 * idx.normal_index + 1];
-				tinyobj::real_t nz = attrib.normals[3 * idx.normal_index + 2];
-				tinyobj::real_t tx = attrib.texcoords[2 * idx.texcoord_index + 0];
-				tinyobj::real_t ty = attrib.texcoords[2 * idx.texcoord_index + 1];
-			}
-			index_offset += fv;
-
-			// per-face material
-			shapes[s].mesh.material_ids[f];
-		}
+	// Sphere around the box center, sized to the farthest vertex
+	XMVECTOR center = (minVec + maxVec) * 0.5f;
+	XMVECTOR maxDistSq = XMVectorZero();
+	for (int i = 0; i < numVertices; i++)
+	{
+		XMVECTOR offset = XMLoadFloat3(&vertices[i].Position) - center;
+		maxDistSq = XMVectorMax(maxDistSq, XMVector3LengthSq(offset));
 	}
 
-
-
+	XMStoreFloat3(&bounds.Min, minVec);
+	XMStoreFloat3(&bounds.Max, maxVec);
+	XMStoreFloat3(&bounds.Center, center);
+	bounds.Radius = sqrtf(XMVectorGetX(maxDistSq));
 }
 
-
-
-
-
-
-
-
-
-
 Mesh::~Mesh()
 {
 	if (vertexBuffer) { vertexBuffer->Release(); }
@@ -467,7 +361,59 @@ int Mesh::GetIndexCount()
 	return indexCount;
 }
 
-std::vector<Vertex> Mesh::GetVertsFromMesh()
+DXGI_FORMAT Mesh::GetIndexFormat()
+{
+	return indexFormat;
+}
+
+UINT Mesh::GetVertexStride()
+{
+	return quantized ? sizeof(QuantizedVertex) : sizeof(Vertex);
+}
+
+const MeshBounds& Mesh::GetBounds()
+{
+	return bounds;
+}
+
+const VertexCacheStats& Mesh::GetOriginalCacheStats()
 {
-	return vertsFromMesh;
+	return originalCacheStats;
+}
+
+const VertexCacheStats& Mesh::GetCacheStats()
+{
+	return cacheStats;
+}
+
+const MeshLoadMemory& Mesh::GetLoadMemory()
+{
+	return loadMemory;
+}
+
+bool Mesh::IsQuantized()
+{
+	return quantized;
+}
+
+const MeshQuantization& Mesh::GetQuantization()
+{
+	return quantization;
+}
+
+const QuantizationError& Mesh::GetQuantizationError()
+{
+	return quantizationError;
+}
+
+const D3D11_INPUT_ELEMENT_DESC* Mesh::GetQuantizedInputElements(unsigned int* count)
+{
+	static const D3D11_INPUT_ELEMENT_DESC elements[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R8G8B8A8_SNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	};
+	*count = sizeof(elements) / sizeof(elements[0]);
+	return elements;
 }
@@ -1,41 +1,89 @@
 #pragma once
 #include "d3d11.h"
 #include "Vertex.h"
-#include "tiny_obj_loader.h"
+#include "Bounds.h"
+#include "MeshCache.h"
+#include "MeshQuantization.h"
 #include <iostream>
 #include <vector>
 #include <fstream>
 
+// Memory a mesh took while loading and what it still holds afterwards.
+// Heap counts come from AllocationCounter, working set from the OS (which
+// also counts the OBJ's mapped pages).
+struct MeshLoadMemory
+{
+	long long PeakHeapBytes;			// Highest heap use above the start of the load
+	long long RetainedHeapBytes;		// Still allocated once the mesh is done
+	long long PeakWorkingSetBytes;		// How far the process's peak working set rose
+	long long RetainedWorkingSetBytes;	// Working set growth once the mesh is done
+};
+
 class Mesh
 {
 	ID3D11Buffer* vertexBuffer;
 	ID3D11Buffer* indexBuffer;
-	std::vector<Vertex> vertsFromMesh;
 	int indexCount;
+	DXGI_FORMAT indexFormat;
+	MeshBounds bounds;
+	VertexCacheStats originalCacheStats;
+	VertexCacheStats cacheStats;
 
-	std::string inputfile;
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-	std::string warn;
-	std::string err;
+	// Set when the vertex buffer holds QuantizedVertex instead of Vertex
+	bool quantized;
+	MeshQuantization quantization;
+	QuantizationError quantizationError;
 
+	MeshLoadMemory loadMemory;
 
+	// Everything the OBJ constructor does, measured by it in debug builds
+	void Load(const char* objFile, ID3D11Device* device, float weldEpsilon);
 
-	void Init(Vertex* vertices, int numVertices, unsigned int indices[], ID3D11Device* device);
+	// Finishes the vertices and makes the buffers, and writes a cache when
+	// given a path for one
+	void Init(Vertex* vertices, int numVertices, unsigned int indices[], int numIndices, ID3D11Device* device,
+		const char* cachePath = 0, unsigned long long sourceHash = 0);
+	void CreateBuffers(const Vertex* vertices, int numVertices, const void* indices, int numIndices, int indexSize, ID3D11Device* device);
+	void CalculateBounds(Vertex* vertices, int numVertices);
 
 public:
-	Mesh(Vertex* vertices, int numVertices, unsigned int indices[], ID3D11Device* device);
-	Mesh(const char* objFile, ID3D11Device* device);
+	Mesh(Vertex* vertices, int numVertices, unsigned int indices[], int numIndices, ID3D11Device* device);
+	// Loads through a .meshcache next to the OBJ when there's an up to date one,
+	// and writes one when there isn't (see MeshCache).  Face corners that share
+	// a position, normal and UV become one vertex; a weldEpsilon above zero
+	// also merges vertices whose values are only that close (see MeshWelding).
+	// Then the triangles and vertices get reordered (see MeshOptimizer).
+	// The OBJ is streamed straight into the final vertices (see
+	// MeshStreaming), and only the GPU buffers, bounds and stats are kept.
+	// Quantized meshes are drawn with VertexShaderQuantized (see MeshQuantization).
+	Mesh(const char* objFile, ID3D11Device* device, float weldEpsilon = 0.0f, bool quantize = false);
 	~Mesh();
 
-	void CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices);
-
-	void CalculateObject(Vertex* verts, int numVerts, unsigned int* indices,std::string object);
+	void CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices);
 
 	ID3D11Buffer* GetVertexBuffer();
 	ID3D11Buffer* GetIndexBuffer();
 	int GetIndexCount();
-	std::vector<Vertex> GetVertsFromMesh();
+	// R16 when every vertex fits in 16 bit indices, otherwise R32
+	DXGI_FORMAT GetIndexFormat();
+	// sizeof(QuantizedVertex) for quantized meshes, otherwise sizeof(Vertex)
+	UINT GetVertexStride();
+	const MeshBounds& GetBounds();
+	// Simulated post-transform cache behaviour before and after the OBJ's
+	// triangles were reordered (the same for meshes made from arrays)
+	const VertexCacheStats& GetOriginalCacheStats();
+	const VertexCacheStats& GetCacheStats();
+
+	// What loading from an OBJ cost (all zero in release builds and for
+	// meshes made from arrays)
+	const MeshLoadMemory& GetLoadMemory();
+
+	bool IsQuantized();
+	// Only meaningful for quantized meshes
+	const MeshQuantization& GetQuantization();
+	const QuantizationError& GetQuantizationError();
+
+	// Input layout for QuantizedVertex, for VertexShaderQuantized
+	static const D3D11_INPUT_ELEMENT_DESC* GetQuantizedInputElements(unsigned int* count);
 };
 
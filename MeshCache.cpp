@@ -0,0 +1,142 @@
+#include "MeshCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Next multiple of the alignment
+static unsigned int AlignOffset(unsigned int offset)
+{
+	return (offset + meshCacheAlignment - 1) & ~(meshCacheAlignment - 1);
+}
+
+MeshCache::MeshCache()
+{
+	header = 0;
+}
+
+bool MeshCache::Open(const char* path, unsigned long long sourceHash)
+{
+	Close();
+	if (!file.Open(path))
+		return false;
+
+	// Everything the header claims has to actually be in the file
+	size_t size = file.GetSize();
+	const MeshCacheHeader* candidate = (const MeshCacheHeader*)file.GetData();
+	if (size < sizeof(MeshCacheHeader) ||
+		candidate->Magic != meshCacheMagic ||
+		candidate->Version != meshCacheVersion ||
+		candidate->SourceHash != sourceHash ||
+		candidate->VertexStride != sizeof(Vertex) ||
+		(candidate->IndexSize != sizeof(unsigned short) && candidate->IndexSize != sizeof(unsigned int)) ||
+		(unsigned long long)candidate->VertexOffset + (unsigned long long)candidate->VertexCount * sizeof(Vertex) > size ||
+		(unsigned long long)candidate->IndexOffset + (unsigned long long)candidate->IndexCount * candidate->IndexSize > size)
+	{
+		file.Close();
+		return false;
+	}
+
+	header = candidate;
+	return true;
+}
+
+void MeshCache::Close()
+{
+	file.Close();
+	header = 0;
+}
+
+const MeshCacheHeader& MeshCache::GetHeader()
+{
+	return *header;
+}
+
+const Vertex* MeshCache::GetVertices()
+{
+	return (const Vertex*)(file.GetData() + header->VertexOffset);
+}
+
+const void* MeshCache::GetIndices()
+{
+	return file.GetData() + header->IndexOffset;
+}
+
+bool MeshCache::Write(const char* path, unsigned long long sourceHash,
+	const Vertex* vertices, int vertexCount,
+	const void* indices, int indexCount, int indexSize,
+	const MeshBounds& bounds, const VertexCacheStats& originalCacheStats, const VertexCacheStats& cacheStats)
+{
+	MeshCacheHeader header = {};
+	header.Magic = meshCacheMagic;
+	header.Version = meshCacheVersion;
+	header.SourceHash = sourceHash;
+	header.VertexCount = vertexCount;
+	header.VertexStride = sizeof(Vertex);
+	header.IndexCount = indexCount;
+	header.IndexSize = indexSize;
+	header.VertexOffset = AlignOffset(sizeof(MeshCacheHeader));
+	header.IndexOffset = AlignOffset(header.VertexOffset + vertexCount * sizeof(Vertex));
+	header.Bounds = bounds;
+	header.OriginalCacheStats = originalCacheStats;
+	header.CacheStats = cacheStats;
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+	{
+		std::cerr << "Can't write mesh cache " << path << std::endl;
+		return false;
+	}
+
+	// Zeros to pad each blob out to its offset
+	char padding[meshCacheAlignment] = {};
+	unsigned int written = sizeof(MeshCacheHeader);
+	out.write((const char*)&header, sizeof(MeshCacheHeader));
+	out.write(padding, header.VertexOffset - written);
+	out.write((const char*)vertices, vertexCount * sizeof(Vertex));
+	written = header.VertexOffset + vertexCount * sizeof(Vertex);
+	out.write(padding, header.IndexOffset - written);
+	out.write((const char*)indices, indexCount * indexSize);
+
+	if (!out.good())
+	{
+		// Don't leave a partial cache behind
+		out.close();
+		std::remove(path);
+		std::cerr << "Can't write mesh cache " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// FNV-1a, but over 8 byte words in four interleaved lanes so
+// the multiplies don't wait on each other - a byte at a time
+// this took longer than the rest of a cached load put together
+// --------------------------------------------------------
+unsigned long long MeshCache::Hash(const void* data, size_t size)
+{
+	const unsigned long long basis = 0xCBF29CE484222325ull;
+	const unsigned long long prime = 0x100000001B3ull;
+	const unsigned char* bytes = (const unsigned char*)data;
+
+	unsigned long long lanes[4] = { basis, basis + 1, basis + 2, basis + 3 };
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32)
+	{
+		for (int l = 0; l < 4; l++)
+		{
+			unsigned long long word;
+			memcpy(&word, bytes + i + l * 8, 8);
+			lanes[l] = (lanes[l] ^ word) * prime;
+		}
+	}
+	for (; i < size; i++)
+		lanes[0] = (lanes[0] ^ bytes[i]) * prime;
+
+	unsigned long long hash = (basis ^ size) * prime;
+	for (int l = 0; l < 4; l++)
+		hash = (hash ^ lanes[l]) * prime;
+	return hash;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Vertex.h"
+#include "Bounds.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+
+// --------------------------------------------------------
+// Binary cache of a loaded OBJ mesh
+//
+// Mesh writes one next to each OBJ (name.obj.meshcache) the
+// first time it loads it, with the finished vertices (tangents
+// included), indices, bounds and vertex cache stats.  Later loads memory map the
+// cache and create the GPU buffers straight from the mapping,
+// without parsing anything.
+//
+// The cache keeps a hash of the OBJ's contents, so editing the
+// OBJ (or bumping meshCacheVersion when the layout or the
+// processing changes) makes it get rebuilt.
+//
+// Layout: a MeshCacheHeader, then the vertices, then the
+// indices, each starting on a meshCacheAlignment boundary.
+// --------------------------------------------------------
+static const unsigned int meshCacheMagic = 0x4843534D;	// "MSCH"
+static const unsigned int meshCacheVersion = 4;
+static const unsigned int meshCacheAlignment = 16;
+
+struct MeshCacheHeader
+{
+	unsigned int Magic;
+	unsigned int Version;
+	unsigned long long SourceHash;	// Of the OBJ file's bytes, see MeshCache::Hash
+	unsigned int VertexCount;
+	unsigned int VertexStride;		// sizeof(Vertex) when it was written
+	unsigned int IndexCount;
+	unsigned int IndexSize;			// Bytes per index, 2 or 4
+	unsigned int VertexOffset;		// Byte offsets from the start of the file
+	unsigned int IndexOffset;
+	MeshBounds Bounds;
+	VertexCacheStats OriginalCacheStats;	// Of the OBJ's own triangle order
+	VertexCacheStats CacheStats;			// After MeshOptimizer
+};
+
+class MeshCache
+{
+	MappedFile file;
+	const MeshCacheHeader* header;
+
+public:
+	MeshCache();
+
+	// Maps the cache at path, false if it's missing, damaged, from another
+	// version or wasn't built from an OBJ with this hash
+	bool Open(const char* path, unsigned long long sourceHash);
+	void Close();
+
+	// Only valid while the cache is open - these point into the mapping
+	const MeshCacheHeader& GetHeader();
+	const Vertex* GetVertices();
+	const void* GetIndices();
+
+	static bool Write(const char* path, unsigned long long sourceHash,
+		const Vertex* vertices, int vertexCount,
+		const void* indices, int indexCount, int indexSize,
+		const MeshBounds& bounds, const VertexCacheStats& originalCacheStats, const VertexCacheStats& cacheStats);
+
+	// 64 bit FNV-1a variant, fast enough to run over the OBJ every launch
+	static unsigned long long Hash(const void* data, size_t size);
+};
@@ -0,0 +1,355 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// FIFO post-transform cache, the way a GPU's behaves.  A vertex
+// is cached while fewer than size misses have happened since it
+// went in, so nothing ever has to be shifted out.
+// --------------------------------------------------------
+struct FifoCache
+{
+	std::vector<unsigned int> stamps;
+	unsigned int time;
+	unsigned int size;
+
+	FifoCache(int vertexCount, int cacheSize)
+		: stamps(vertexCount, 0), time(cacheSize + 1), size(cacheSize) {}
+
+	// Starts empty again without touching every vertex
+	void Flush() { time += size + 1; }
+
+	// True (and the vertex goes in) on a miss
+	bool Miss(unsigned int v)
+	{
+		if (time - stamps[v] <= size)
+			return false;
+		stamps[v] = time++;
+		return true;
+	}
+};
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const unsigned int* indices, int indexCount, int vertexCount, int cacheSize)
+{
+	VertexCacheStats stats = { 0, 0 };
+	int triangleCount = indexCount / 3;
+	if (triangleCount == 0 || vertexCount == 0)
+		return stats;
+
+	FifoCache cache(vertexCount, cacheSize);
+	int misses = 0;
+	for (int i = 0; i < triangleCount * 3; i++)
+		misses += cache.Miss(indices[i]);
+
+	stats.ACMR = (float)misses / triangleCount;
+	stats.ATVR = (float)misses / vertexCount;
+	return stats;
+}
+
+// --------------------------------------------------------
+// Forsyth's vertex score - high for vertices near the front of
+// the cache (except the last triangle's, which a neighbour will
+// probably use anyway) and for vertices with few triangles left,
+// so lone triangles get finished off instead of stranded
+// --------------------------------------------------------
+static const int forsythMaxValence = 32;
+
+static float ForsythScore(int cachePosition, int trianglesLeft)
+{
+	static float cacheScores[vertexCacheOptimizeSize];
+	static float valenceScores[forsythMaxValence];
+	static bool tablesBuilt = false;
+	if (!tablesBuilt)
+	{
+		for (int i = 0; i < vertexCacheOptimizeSize; i++)
+			cacheScores[i] = i < 3 ? 0.75f : powf(1.0f - (float)(i - 3) / (vertexCacheOptimizeSize - 3), 1.5f);
+		for (int i = 1; i < forsythMaxValence; i++)
+			valenceScores[i] = 2.0f / sqrtf((float)i);
+		valenceScores[0] = 0;
+		tablesBuilt = true;
+	}
+
+	if (trianglesLeft == 0)
+		return 0;
+
+	float score = cachePosition >= 0 ? cacheScores[cachePosition] : 0;
+	return score + (trianglesLeft < forsythMaxValence ? valenceScores[trianglesLeft] : 2.0f / sqrtf((float)trianglesLeft));
+}
+
+void MeshOptimizer::OptimizeVertexCache(unsigned int* indices, int indexCount, int vertexCount)
+{
+	int triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Triangles using each vertex.  Each vertex's list stays packed: an
+	// emitted triangle is swapped out past the live ones.
+	std::vector<int> trianglesLeft(vertexCount, 0);
+	for (int i = 0; i < triangleCount * 3; i++)
+		trianglesLeft[indices[i]]++;
+
+	std::vector<int> adjacencyStart(vertexCount + 1, 0);
+	for (int v = 0; v < vertexCount; v++)
+		adjacencyStart[v + 1] = adjacencyStart[v] + trianglesLeft[v];
+
+	std::vector<int> adjacency(triangleCount * 3);
+	std::vector<int> filled(vertexCount, 0);
+	for (int i = 0; i < triangleCount * 3; i++)
+	{
+		unsigned int v = indices[i];
+		adjacency[adjacencyStart[v] + filled[v]++] = i / 3;
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (int v = 0; v < vertexCount; v++)
+		vertexScores[v] = ForsythScore(-1, trianglesLeft[v]);
+
+	// Start from the best triangle anywhere
+	std::vector<bool> emitted(triangleCount, false);
+	int best = 0;
+	float bestScore = -1;
+	for (int t = 0; t < triangleCount; t++)
+	{
+		float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		if (score > bestScore)
+		{
+			bestScore = score;
+			best = t;
+		}
+	}
+
+	// LRU cache, with room for a triangle's worth of vertices on the end
+	// that are about to fall out
+	int cache[vertexCacheOptimizeSize + 3];
+	int cacheCount = 0;
+	int newCache[vertexCacheOptimizeSize + 3];
+
+	std::vector<unsigned int> output(triangleCount * 3);
+	int scanCursor = 0;
+	for (int out = 0; out < triangleCount; out++)
+	{
+		// Nothing in the cache has triangles left - start on a fresh patch
+		if (best < 0)
+		{
+			while (emitted[scanCursor])
+				scanCursor++;
+			best = scanCursor;
+		}
+
+		const unsigned int* corners = indices + best * 3;
+		output[out * 3 + 0] = corners[0];
+		output[out * 3 + 1] = corners[1];
+		output[out * 3 + 2] = corners[2];
+		emitted[best] = true;
+
+		// The triangle leaves its vertices' live lists, and its vertices go to
+		// the front of the cache
+		int newCount = 0;
+		for (int c = 0; c < 3; c++)
+		{
+			unsigned int v = corners[c];
+			int* list = &adjacency[adjacencyStart[v]];
+			int live = trianglesLeft[v];
+			for (int i = 0; i < live; i++)
+			{
+				if (list[i] == best)
+				{
+					std::swap(list[i], list[live - 1]);
+					break;
+				}
+			}
+			trianglesLeft[v]--;
+
+			bool alreadyIn = false;
+			for (int i = 0; i < newCount; i++)
+				alreadyIn |= newCache[i] == (int)v;
+			if (!alreadyIn)
+				newCache[newCount++] = v;
+		}
+		for (int i = 0; i < cacheCount; i++)
+		{
+			int v = cache[i];
+			if (v != (int)corners[0] && v != (int)corners[1] && v != (int)corners[2])
+				newCache[newCount++] = v;
+		}
+
+		// Rescore everything that moved (including what fell out)...
+		for (int i = 0; i < newCount; i++)
+		{
+			int v = newCache[i];
+			cachePosition[v] = i < vertexCacheOptimizeSize ? i : -1;
+			vertexScores[v] = ForsythScore(cachePosition[v], trianglesLeft[v]);
+		}
+
+		// ...then their triangles, and pick the best one the cache can feed
+		best = -1;
+		bestScore = -1;
+		for (int i = 0; i < newCount; i++)
+		{
+			int v = newCache[i];
+			const int* list = &adjacency[adjacencyStart[v]];
+			for (int j = 0; j < trianglesLeft[v]; j++)
+			{
+				int t = list[j];
+				float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+				if (score > bestScore)
+				{
+					bestScore = score;
+					best = t;
+				}
+			}
+		}
+
+		cacheCount = newCount < vertexCacheOptimizeSize ? newCount : vertexCacheOptimizeSize;
+		for (int i = 0; i < cacheCount; i++)
+			cache[i] = newCache[i];
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+// A run of triangles drawn together, and how outward-facing it is
+struct OverdrawCluster
+{
+	int FirstTriangle;
+	int TriangleCount;
+	float SortKey;
+};
+
+static bool FacesFurtherOut(const OverdrawCluster& a, const OverdrawCluster& b)
+{
+	return a.SortKey > b.SortKey;
+}
+
+void MeshOptimizer::OptimizeOverdraw(const Vertex* vertices, int vertexCount, unsigned int* indices, int indexCount, float threshold)
+{
+	int triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Hard boundaries - triangles with no cached vertices at all, where the
+	// cache-optimized order has already started over
+	std::vector<int> hardStarts;
+	FifoCache cache(vertexCount, vertexCacheAnalyzeSize);
+	for (int t = 0; t < triangleCount; t++)
+	{
+		int misses = cache.Miss(indices[t * 3]) + cache.Miss(indices[t * 3 + 1]) + cache.Miss(indices[t * 3 + 2]);
+		if (misses == 3)
+			hardStarts.push_back(t);
+	}
+	if (hardStarts.empty() || hardStarts[0] != 0)
+		hardStarts.insert(hardStarts.begin(), 0);
+	hardStarts.push_back(triangleCount);
+
+	// Soft boundaries - inside each of those, end a cluster as soon as its
+	// own reuse is nearly as good as the whole run's
+	std::vector<OverdrawCluster> clusters;
+	for (size_t h = 0; h + 1 < hardStarts.size(); h++)
+	{
+		int begin = hardStarts[h];
+		int end = hardStarts[h + 1];
+
+		cache.Flush();
+		int runMisses = 0;
+		for (int i = begin * 3; i < end * 3; i++)
+			runMisses += cache.Miss(indices[i]);
+		float limit = threshold * runMisses / (end - begin);
+
+		cache.Flush();
+		int clusterStart = begin;
+		int clusterMisses = 0;
+		for (int t = begin; t < end; t++)
+		{
+			clusterMisses += cache.Miss(indices[t * 3]) + cache.Miss(indices[t * 3 + 1]) + cache.Miss(indices[t * 3 + 2]);
+			if (t + 1 == end || (float)clusterMisses / (t + 1 - clusterStart) <= limit)
+			{
+				OverdrawCluster cluster = { clusterStart, t + 1 - clusterStart, 0 };
+				clusters.push_back(cluster);
+				clusterStart = t + 1;
+				clusterMisses = 0;
+				cache.Flush();
+			}
+		}
+	}
+
+	// Area-weighted centroid and normal of each cluster (normals from the
+	// vertices, so the winding convention doesn't matter)
+	std::vector<XMFLOAT3> centroids(clusters.size());
+	std::vector<XMFLOAT3> normals(clusters.size());
+	std::vector<float> areas(clusters.size());
+	XMVECTOR meshCentroid = XMVectorZero();
+	float meshArea = 0;
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		XMVECTOR centroid = XMVectorZero();
+		XMVECTOR normal = XMVectorZero();
+		float area = 0;
+		for (int t = clusters[c].FirstTriangle; t < clusters[c].FirstTriangle + clusters[c].TriangleCount; t++)
+		{
+			const Vertex& a = vertices[indices[t * 3]];
+			const Vertex& b = vertices[indices[t * 3 + 1]];
+			const Vertex& d = vertices[indices[t * 3 + 2]];
+			XMVECTOR pa = XMLoadFloat3(&a.Position);
+			XMVECTOR pb = XMLoadFloat3(&b.Position);
+			XMVECTOR pd = XMLoadFloat3(&d.Position);
+			float triangleArea = XMVectorGetX(XMVector3Length(XMVector3Cross(pb - pa, pd - pa))) * 0.5f;
+
+			centroid += (pa + pb + pd) * (triangleArea / 3.0f);
+			normal += (XMLoadFloat3(&a.Normal) + XMLoadFloat3(&b.Normal) + XMLoadFloat3(&d.Normal)) * triangleArea;
+			area += triangleArea;
+		}
+
+		meshCentroid += centroid;
+		meshArea += area;
+		XMStoreFloat3(&centroids[c], area > 0 ? centroid / area : centroid);
+		XMStoreFloat3(&normals[c], XMVector3Normalize(normal));
+		areas[c] = area;
+	}
+	if (meshArea > 0)
+		meshCentroid /= meshArea;
+
+	// Clusters facing away from the middle of the mesh are the ones most
+	// likely to be in front, so they go first
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		XMVECTOR offset = XMLoadFloat3(&centroids[c]) - meshCentroid;
+		clusters[c].SortKey = areas[c] > 0 ? XMVectorGetX(XMVector3Dot(offset, XMLoadFloat3(&normals[c]))) : 0;
+	}
+	std::stable_sort(clusters.begin(), clusters.end(), FacesFurtherOut);
+
+	std::vector<unsigned int> output;
+	output.reserve(triangleCount * 3);
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		const unsigned int* first = indices + clusters[c].FirstTriangle * 3;
+		output.insert(output.end(), first, first + clusters[c].TriangleCount * 3);
+	}
+	std::copy(output.begin(), output.end(), indices);
+}
+
+int MeshOptimizer::OptimizeVertexFetch(Vertex* vertices, int vertexCount, unsigned int* indices, int indexCount)
+{
+	std::vector<int> remap(vertexCount, -1);
+	int used = 0;
+	for (int i = 0; i < indexCount; i++)
+	{
+		unsigned int v = indices[i];
+		if (remap[v] < 0)
+			remap[v] = used++;
+		indices[i] = remap[v];
+	}
+
+	std::vector<Vertex> reordered(used);
+	for (int v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] >= 0)
+			reordered[remap[v]] = vertices[v];
+	}
+	std::copy(reordered.begin(), reordered.end(), vertices);
+	return used;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// Reorders a welded mesh's triangles and vertices so the GPU
+// does less work drawing it
+//
+// Run in this order, since each step keeps what the one before
+// it bought:
+//  - OptimizeVertexCache: triangles that share vertices end up
+//    close together, so the post-transform cache catches them
+//    (Forsyth's linear-speed algorithm)
+//  - OptimizeOverdraw: cuts that order into clusters and draws
+//    the outward-facing ones first, so they can occlude the rest
+//    (after Sander et al.'s Tipsify).  Clusters keep their
+//    internal order, so most of the cache reuse survives.
+//  - OptimizeVertexFetch: vertices are stored in the order the
+//    indices first use them
+//
+// Pure CPU work on plain arrays - Mesh runs it once per OBJ and
+// keeps the results in the mesh cache.
+// --------------------------------------------------------
+
+// Cache size the optimizer aims for, and the FIFO cache AnalyzeVertexCache
+// simulates (a typical post-transform cache)
+static const int vertexCacheOptimizeSize = 32;
+static const int vertexCacheAnalyzeSize = 16;
+
+struct VertexCacheStats
+{
+	float ACMR;		// Transformed vertices per triangle, 0.5 is perfect and 3 is no reuse at all
+	float ATVR;		// Transformed vertices per vertex, 1 is perfect
+};
+
+namespace MeshOptimizer
+{
+	// Simulates a FIFO cache of cacheSize vertices over the triangle list
+	VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, int indexCount, int vertexCount, int cacheSize = vertexCacheAnalyzeSize);
+
+	// Reorders the triangles in place, vertices stay where they are
+	void OptimizeVertexCache(unsigned int* indices, int indexCount, int vertexCount);
+
+	// Reorders the triangles in place.  A cluster ends once its own ACMR is
+	// within threshold of the cache-optimized order's (1.05 gives up about 5%).
+	void OptimizeOverdraw(const Vertex* vertices, int vertexCount, unsigned int* indices, int indexCount, float threshold = 1.05f);
+
+	// Moves the vertices into first-use order and rewrites the indices to
+	// match.  Vertices no triangle uses are dropped.  Returns the new count.
+	int OptimizeVertexFetch(Vertex* vertices, int vertexCount, unsigned int* indices, int indexCount);
+}
@@ -0,0 +1,165 @@
+#include "MeshQuantization.h"
+
+#include <cmath>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+MeshQuantization MeshQuantizer::Calculate(const MeshBounds& bounds)
+{
+	// A flat axis still needs a usable scale, every vertex just lands on 0
+	MeshQuantization quantization;
+	quantization.Bias = bounds.Min;
+	quantization.Scale.x = bounds.Max.x > bounds.Min.x ? bounds.Max.x - bounds.Min.x : 1.0f;
+	quantization.Scale.y = bounds.Max.y > bounds.Min.y ? bounds.Max.y - bounds.Min.y : 1.0f;
+	quantization.Scale.z = bounds.Max.z > bounds.Min.z ? bounds.Max.z - bounds.Min.z : 1.0f;
+	return quantization;
+}
+
+static unsigned short EncodeUnorm16(float value, float scale, float bias)
+{
+	float unorm = (value - bias) / scale;
+	unorm = unorm < 0.0f ? 0.0f : (unorm > 1.0f ? 1.0f : unorm);
+	return (unsigned short)(unorm * 65535.0f + 0.5f);
+}
+
+// Same as the GPU's SNORM conversion (-128 and -127 both mean -1)
+static float DecodeSnorm8(signed char value)
+{
+	float decoded = value / 127.0f;
+	return decoded < -1.0f ? -1.0f : decoded;
+}
+
+XMFLOAT3 MeshQuantizer::DecodeOctahedral(const signed char* encoded)
+{
+	// Same as OctahedralDecode in VertexShaderQuantized.hlsl
+	float x = DecodeSnorm8(encoded[0]);
+	float y = DecodeSnorm8(encoded[1]);
+	float z = 1.0f - fabsf(x) - fabsf(y);
+	if (z < 0.0f)
+	{
+		float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	float length = sqrtf(x * x + y * y + z * z);
+	return XMFLOAT3(x / length, y / length, z / length);
+}
+
+// --------------------------------------------------------
+// Projects the direction onto an octahedron and unfolds the
+// lower half over the corners.  Of the four 8 bit codes around
+// that point, keeps whichever decodes closest to the direction,
+// which isn't always the nearest one.
+// --------------------------------------------------------
+void MeshQuantizer::EncodeOctahedral(const XMFLOAT3& direction, signed char* encoded)
+{
+	float sum = fabsf(direction.x) + fabsf(direction.y) + fabsf(direction.z);
+	if (sum == 0.0f)
+	{
+		encoded[0] = 0;
+		encoded[1] = 0;
+		return;
+	}
+
+	float x = direction.x / sum;
+	float y = direction.y / sum;
+	if (direction.z < 0.0f)
+	{
+		float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	float baseX = floorf(x * 127.0f);
+	float baseY = floorf(y * 127.0f);
+	float bestDot = -2.0f;
+	for (int candidate = 0; candidate < 4; candidate++)
+	{
+		float codeX = baseX + (candidate & 1);
+		float codeY = baseY + (candidate >> 1);
+		if (codeX < -127.0f || codeX > 127.0f || codeY < -127.0f || codeY > 127.0f)
+			continue;
+
+		signed char code[2] = { (signed char)codeX, (signed char)codeY };
+		XMFLOAT3 decoded = DecodeOctahedral(code);
+		float dot = (decoded.x * direction.x + decoded.y * direction.y + decoded.z * direction.z) / sum;
+		if (dot > bestDot)
+		{
+			bestDot = dot;
+			encoded[0] = code[0];
+			encoded[1] = code[1];
+		}
+	}
+}
+
+void MeshQuantizer::Encode(const MeshQuantization& quantization, const Vertex* vertices, int count, QuantizedVertex* quantized)
+{
+	for (int i = 0; i < count; i++)
+	{
+		const Vertex& vertex = vertices[i];
+		QuantizedVertex& out = quantized[i];
+		out.Position[0] = EncodeUnorm16(vertex.Position.x, quantization.Scale.x, quantization.Bias.x);
+		out.Position[1] = EncodeUnorm16(vertex.Position.y, quantization.Scale.y, quantization.Bias.y);
+		out.Position[2] = EncodeUnorm16(vertex.Position.z, quantization.Scale.z, quantization.Bias.z);
+		out.Position[3] = 0;
+		out.UV[0] = XMConvertFloatToHalf(vertex.UV.x);
+		out.UV[1] = XMConvertFloatToHalf(vertex.UV.y);
+		EncodeOctahedral(vertex.Normal, out.NormalTangent);
+		EncodeOctahedral(vertex.Tangent, out.NormalTangent + 2);
+	}
+}
+
+void MeshQuantizer::Decode(const MeshQuantization& quantization, const QuantizedVertex* quantized, int count, Vertex* vertices)
+{
+	for (int i = 0; i < count; i++)
+	{
+		const QuantizedVertex& in = quantized[i];
+		Vertex& vertex = vertices[i];
+		vertex.Position.x = in.Position[0] / 65535.0f * quantization.Scale.x + quantization.Bias.x;
+		vertex.Position.y = in.Position[1] / 65535.0f * quantization.Scale.y + quantization.Bias.y;
+		vertex.Position.z = in.Position[2] / 65535.0f * quantization.Scale.z + quantization.Bias.z;
+		vertex.UV.x = XMConvertHalfToFloat(in.UV[0]);
+		vertex.UV.y = XMConvertHalfToFloat(in.UV[1]);
+		vertex.Normal = DecodeOctahedral(in.NormalTangent);
+		vertex.Tangent = DecodeOctahedral(in.NormalTangent + 2);
+	}
+}
+
+// Angle between a direction and its decoded version (0 for zero-length directions)
+static float AngleDegrees(const XMFLOAT3& original, const XMFLOAT3& decoded)
+{
+	float length = sqrtf(original.x * original.x + original.y * original.y + original.z * original.z);
+	if (length == 0.0f)
+		return 0.0f;
+
+	float cosine = (original.x * decoded.x + original.y * decoded.y + original.z * decoded.z) / length;
+	cosine = cosine > 1.0f ? 1.0f : (cosine < -1.0f ? -1.0f : cosine);
+	return acosf(cosine) * (180.0f / XM_PI);
+}
+
+QuantizationError MeshQuantizer::MeasureError(const MeshQuantization& quantization, const Vertex* vertices, const QuantizedVertex* quantized, int count)
+{
+	QuantizationError error = { 0, 0, 0, 0 };
+	for (int i = 0; i < count; i++)
+	{
+		Vertex decoded;
+		Decode(quantization, quantized + i, 1, &decoded);
+
+		const Vertex& original = vertices[i];
+		float dx = decoded.Position.x - original.Position.x;
+		float dy = decoded.Position.y - original.Position.y;
+		float dz = decoded.Position.z - original.Position.z;
+		float position = sqrtf(dx * dx + dy * dy + dz * dz);
+		float uv = fmaxf(fabsf(decoded.UV.x - original.UV.x), fabsf(decoded.UV.y - original.UV.y));
+
+		error.Position = fmaxf(error.Position, position);
+		error.UV = fmaxf(error.UV, uv);
+		error.NormalDegrees = fmaxf(error.NormalDegrees, AngleDegrees(original.Normal, decoded.Normal));
+		error.TangentDegrees = fmaxf(error.TangentDegrees, AngleDegrees(original.Tangent, decoded.Tangent));
+	}
+	return error;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+#include "Vertex.h"
+#include "Bounds.h"
+
+// --------------------------------------------------------
+// A mesh vertex as the GPU reads it when the mesh is quantized
+// - 16 bytes instead of Vertex's 44
+//
+// Matches VertexShaderQuantized.hlsl and the input layout from
+// Mesh::GetQuantizedInputElements.
+//  - Position: 16 bit UNORM across the mesh's bounds, the shader
+//    puts it back with the mesh's scale and bias
+//  - UV: half floats
+//  - Normal and tangent: octahedral, 8 bit SNORM per component
+// --------------------------------------------------------
+struct QuantizedVertex
+{
+	unsigned short Position[4];				// R16G16B16A16_UNORM, w unused
+	DirectX::PackedVector::HALF UV[2];		// R16G16_FLOAT
+	signed char NormalTangent[4];			// R8G8B8A8_SNORM, normal in xy, tangent in zw
+};
+
+// Per-mesh dequantization - position = unorm * Scale + Bias
+struct MeshQuantization
+{
+	DirectX::XMFLOAT3 Scale;
+	DirectX::XMFLOAT3 Bias;
+};
+
+// Worst differences between the original and the decoded vertices
+struct QuantizationError
+{
+	float Position;			// Distance, in mesh units
+	float UV;
+	float NormalDegrees;
+	float TangentDegrees;
+};
+
+namespace MeshQuantizer
+{
+	// Scale and bias that spread the bounds over the full 16 bit range
+	MeshQuantization Calculate(const MeshBounds& bounds);
+
+	void Encode(const MeshQuantization& quantization, const Vertex* vertices, int count, QuantizedVertex* quantized);
+
+	// What the shader gets back, minus the world transform
+	void Decode(const MeshQuantization& quantization, const QuantizedVertex* quantized, int count, Vertex* vertices);
+
+	QuantizationError MeasureError(const MeshQuantization& quantization, const Vertex* vertices, const QuantizedVertex* quantized, int count);
+
+	// Single field encoding, exposed for checking against the shader's decoding
+	void EncodeOctahedral(const DirectX::XMFLOAT3& direction, signed char* encoded);
+	DirectX::XMFLOAT3 DecodeOctahedral(const signed char* encoded);
+}
@@ -0,0 +1,145 @@
+#include "MeshStreaming.h"
+#include "MeshWelding.h"
+
+#include <iostream>
+#include <istream>
+#include <streambuf>
+#include <string>
+
+using namespace DirectX;
+
+// Reads the mapped OBJ in place instead of copying it into a stringstream
+class MemoryReadBuffer : public std::streambuf
+{
+public:
+	MemoryReadBuffer(const void* data, size_t size)
+	{
+		char* begin = (char*)data;
+		setg(begin, begin, begin + size);
+	}
+};
+
+// Everything the callbacks build up while the file is read
+struct StreamState
+{
+	std::vector<XMFLOAT3> positions;
+	std::vector<XMFLOAT3> normals;
+	std::vector<XMFLOAT2> uvs;
+	MeshWelding::CornerWelder welder;
+	std::vector<unsigned int>* indices;
+	std::vector<tinyobj::index_t> corners;	// The current face, resolved
+};
+
+// Raw OBJ index to zero based: 1 based when positive, relative to the
+// attributes so far when negative, and 0 (left out) becomes -1.  Relative
+// ones reaching back past the first attribute become -2.
+static int ResolveIndex(int index, size_t count)
+{
+	if (index > 0)
+		return index - 1;
+	if (index < 0)
+		return (int)count + index >= 0 ? (int)count + index : -2;
+	return -1;
+}
+
+static void OnVertex(void* userData, tinyobj::real_t x, tinyobj::real_t y, tinyobj::real_t z, tinyobj::real_t /*w*/)
+{
+	StreamState* state = (StreamState*)userData;
+	state->positions.push_back(XMFLOAT3(x, y, z));
+}
+
+static void OnNormal(void* userData, tinyobj::real_t x, tinyobj::real_t y, tinyobj::real_t z)
+{
+	StreamState* state = (StreamState*)userData;
+	state->normals.push_back(XMFLOAT3(x, y, z));
+}
+
+static void OnTexcoord(void* userData, tinyobj::real_t x, tinyobj::real_t y, tinyobj::real_t /*z*/)
+{
+	StreamState* state = (StreamState*)userData;
+	state->uvs.push_back(XMFLOAT2(x, y));
+}
+
+// One "f" line - welded as a fan of triangles around its first corner
+static void OnFace(void* userData, tinyobj::index_t* indices, int numIndices)
+{
+	StreamState* state = (StreamState*)userData;
+	if (numIndices < 3)
+		return;
+
+	state->corners.resize(numIndices);
+	for (int i = 0; i < numIndices; i++)
+	{
+		tinyobj::index_t& corner = state->corners[i];
+		corner.vertex_index = ResolveIndex(indices[i].vertex_index, state->positions.size());
+		corner.normal_index = ResolveIndex(indices[i].normal_index, state->normals.size());
+		corner.texcoord_index = ResolveIndex(indices[i].texcoord_index, state->uvs.size());
+	}
+
+	for (int i = 1; i + 1 < numIndices; i++)
+	{
+		state->indices->push_back(state->welder.Add(state->corners[0]));
+		state->indices->push_back(state->welder.Add(state->corners[i]));
+		state->indices->push_back(state->welder.Add(state->corners[i + 1]));
+	}
+}
+
+bool MeshStreaming::LoadObj(const void* data, size_t size, std::vector<Vertex>* vertices, std::vector<unsigned int>* indices)
+{
+	vertices->clear();
+	indices->clear();
+
+	// Faces may point at attributes further down the file, so the values
+	// are only looked up once everything's read
+	StreamState state;
+	state.indices = indices;
+
+	tinyobj::callback_t callbacks;
+	callbacks.vertex_cb = OnVertex;
+	callbacks.normal_cb = OnNormal;
+	callbacks.texcoord_cb = OnTexcoord;
+	callbacks.index_cb = OnFace;
+
+	MemoryReadBuffer buffer(data, size);
+	std::istream stream(&buffer);
+	std::string warn;
+	std::string err;
+	bool ret = tinyobj::LoadObjWithCallback(stream, callbacks, &state, 0, &warn, &err);
+
+	if (!warn.empty())
+		std::cout << warn << std::endl;
+
+	if (!err.empty())
+		std::cerr << err << std::endl;
+
+	if (!ret)
+		return false;
+
+	const std::vector<tinyobj::index_t>& keys = state.welder.GetKeys();
+	vertices->resize(keys.size());
+	for (size_t v = 0; v < keys.size(); v++)
+	{
+		const tinyobj::index_t& key = keys[v];
+		if (key.vertex_index < 0 || key.vertex_index >= (int)state.positions.size() ||
+			key.normal_index < -1 || key.normal_index >= (int)state.normals.size() ||
+			key.texcoord_index < -1 || key.texcoord_index >= (int)state.uvs.size())
+		{
+			std::cerr << "OBJ face corner " << key.vertex_index + 1 << "/" << key.texcoord_index + 1 << "/" << key.normal_index + 1
+				<< " is out of range (" << state.positions.size() << " positions, " << state.uvs.size() << " UVs, "
+				<< state.normals.size() << " normals)" << std::endl;
+			vertices->clear();
+			indices->clear();
+			return false;
+		}
+
+		Vertex vertex = {};
+		vertex.Position = state.positions[key.vertex_index];
+		if (key.normal_index >= 0)
+			vertex.Normal = state.normals[key.normal_index];
+		if (key.texcoord_index >= 0)
+			vertex.UV = state.uvs[key.texcoord_index];
+		(*vertices)[v] = vertex;
+	}
+
+	return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// Reads an OBJ straight into welded vertices and indices
+//
+// tinyobj::LoadObjWithCallback hands over each "v", "vn", "vt"
+// and "f" line as it's parsed.  Attributes go into compact
+// arrays and every face corner is welded on its index triple
+// right away (see MeshWelding::CornerWelder), so tinyobj's
+// attrib_t and shape_t copies of the whole file never exist.
+// Once the last line is in, the triples turn into Vertex values
+// and everything but the vertices and indices is freed.
+//
+// The results match MeshWelding::WeldCorners on tinyobj::LoadObj's
+// output.  Polygons are split into fans, which is what tinyobj's
+// triangulation does for convex ones.
+// --------------------------------------------------------
+namespace MeshStreaming
+{
+	// False (with the reason on std::cerr) if a face points at an attribute
+	// the file doesn't have.  Missing normals or UVs come out as zero.
+	bool LoadObj(const void* data, size_t size, std::vector<Vertex>* vertices, std::vector<unsigned int>* indices);
+}
@@ -0,0 +1,188 @@
+#include "MeshWelding.h"
+
+#include <cmath>
+
+// Smallest power of two table with room for count keys at half load
+static unsigned int TableSize(size_t count)
+{
+	unsigned int size = 16;
+	while (size < count * 2)
+		size *= 2;
+	return size;
+}
+
+static unsigned int HashInts(const int* values, int count)
+{
+	unsigned int hash = 2166136261u;
+	for (int i = 0; i < count; i++)
+	{
+		hash ^= (unsigned int)values[i];
+		hash *= 16777619u;
+		hash ^= hash >> 15;
+	}
+	return hash;
+}
+
+MeshWelding::CornerWelder::CornerWelder()
+{
+	slots.assign(TableSize(0), -1);
+}
+
+void MeshWelding::CornerWelder::Reserve(size_t cornerCount)
+{
+	keys.reserve(cornerCount);
+	unsigned int tableSize = TableSize(cornerCount);
+	if (tableSize > slots.size())
+		Rehash(tableSize);
+}
+
+// Puts every key into a fresh table of the given size
+void MeshWelding::CornerWelder::Rehash(unsigned int tableSize)
+{
+	slots.assign(tableSize, -1);
+	for (size_t v = 0; v < keys.size(); v++)
+	{
+		const tinyobj::index_t& key = keys[v];
+		int triple[3] = { key.vertex_index, key.normal_index, key.texcoord_index };
+		unsigned int slot = HashInts(triple, 3) & (tableSize - 1);
+		while (slots[slot] >= 0)
+			slot = (slot + 1) & (tableSize - 1);
+		slots[slot] = (int)v;
+	}
+}
+
+unsigned int MeshWelding::CornerWelder::Add(const tinyobj::index_t& corner)
+{
+	unsigned int mask = (unsigned int)slots.size() - 1;
+	int triple[3] = { corner.vertex_index, corner.normal_index, corner.texcoord_index };
+	unsigned int slot = HashInts(triple, 3) & mask;
+	for (;; slot = (slot + 1) & mask)
+	{
+		int existing = slots[slot];
+		if (existing < 0)
+			break;
+		const tinyobj::index_t& key = keys[existing];
+		if (key.vertex_index == corner.vertex_index && key.normal_index == corner.normal_index && key.texcoord_index == corner.texcoord_index)
+			return (unsigned int)existing;
+	}
+
+	// First time this triple shows up - stay at or under half load
+	unsigned int vertex = (unsigned int)keys.size();
+	keys.push_back(corner);
+	if (keys.size() * 2 > slots.size())
+		Rehash((unsigned int)slots.size() * 2);
+	else
+		slots[slot] = (int)vertex;
+	return vertex;
+}
+
+const std::vector<tinyobj::index_t>& MeshWelding::CornerWelder::GetKeys()
+{
+	return keys;
+}
+
+void MeshWelding::WeldCorners(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+	std::vector<Vertex>* vertices, std::vector<unsigned int>* indices)
+{
+	size_t cornerCount = 0;
+	for (size_t s = 0; s < shapes.size(); s++)
+		cornerCount += shapes[s].mesh.indices.size();
+
+	vertices->clear();
+	indices->clear();
+	indices->reserve(cornerCount);
+
+	CornerWelder welder;
+	welder.Reserve(cornerCount);
+	for (size_t s = 0; s < shapes.size(); s++)
+	{
+		const std::vector<tinyobj::index_t>& corners = shapes[s].mesh.indices;
+		for (size_t c = 0; c < corners.size(); c++)
+			indices->push_back(welder.Add(corners[c]));
+	}
+
+	// Every distinct triple becomes a vertex
+	const std::vector<tinyobj::index_t>& keys = welder.GetKeys();
+	vertices->resize(keys.size());
+	for (size_t v = 0; v < keys.size(); v++)
+	{
+		const tinyobj::index_t& idx = keys[v];
+		Vertex vertex = {};
+		vertex.Position.x = attrib.vertices[3 * idx.vertex_index + 0];
+		vertex.Position.y = attrib.vertices[3 * idx.vertex_index + 1];
+		vertex.Position.z = attrib.vertices[3 * idx.vertex_index + 2];
+		if (idx.normal_index >= 0)
+		{
+			vertex.Normal.x = attrib.normals[3 * idx.normal_index + 0];
+			vertex.Normal.y = attrib.normals[3 * idx.normal_index + 1];
+			vertex.Normal.z = attrib.normals[3 * idx.normal_index + 2];
+		}
+		if (idx.texcoord_index >= 0)
+		{
+			vertex.UV.x = attrib.texcoords[2 * idx.texcoord_index + 0];
+			vertex.UV.y = attrib.texcoords[2 * idx.texcoord_index + 1];
+		}
+		(*vertices)[v] = vertex;
+	}
+}
+
+// Position, normal and UV rounded to multiples of epsilon
+static void QuantizeVertex(const Vertex& vertex, float inverseEpsilon, int* cells)
+{
+	const float values[8] = {
+		vertex.Position.x, vertex.Position.y, vertex.Position.z,
+		vertex.Normal.x, vertex.Normal.y, vertex.Normal.z,
+		vertex.UV.x, vertex.UV.y };
+	for (int i = 0; i < 8; i++)
+		cells[i] = (int)floorf(values[i] * inverseEpsilon + 0.5f);
+}
+
+void MeshWelding::WeldByValue(float epsilon, std::vector<Vertex>* vertices, std::vector<unsigned int>* indices)
+{
+	if (epsilon <= 0.0f || vertices->empty())
+		return;
+
+	// Each vertex either claims its cell or maps onto the vertex that got there first
+	float inverseEpsilon = 1.0f / epsilon;
+	size_t count = vertices->size();
+	unsigned int tableSize = TableSize(count);
+	std::vector<int> slots(tableSize, -1);
+	std::vector<int> cells(count * 8);
+	std::vector<unsigned int> remap(count);
+	int kept = 0;
+
+	for (size_t v = 0; v < count; v++)
+	{
+		int* cell = &cells[kept * 8];
+		QuantizeVertex((*vertices)[v], inverseEpsilon, cell);
+
+		unsigned int slot = HashInts(cell, 8) & (tableSize - 1);
+		for (;; slot = (slot + 1) & (tableSize - 1))
+		{
+			int existing = slots[slot];
+			if (existing < 0)
+				break;
+			const int* other = &cells[existing * 8];
+			bool same = true;
+			for (int i = 0; i < 8 && same; i++)
+				same = other[i] == cell[i];
+			if (same)
+				break;
+		}
+
+		if (slots[slot] >= 0)
+		{
+			remap[v] = slots[slot];
+			continue;
+		}
+
+		// Kept vertices are packed down to the front as we go
+		slots[slot] = kept;
+		remap[v] = kept;
+		(*vertices)[kept++] = (*vertices)[v];
+	}
+
+	vertices->resize(kept);
+	for (size_t i = 0; i < indices->size(); i++)
+		(*indices)[i] = remap[(*indices)[i]];
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+
+#include "Vertex.h"
+#include "tiny_obj_loader.h"
+
+// --------------------------------------------------------
+// Turns OBJ face corners into shared vertices and real indices
+//
+// OBJ faces index positions, normals and UVs separately, so two
+// corners are the same vertex exactly when their (position,
+// normal, UV) index triples match.  WeldCorners hashes those
+// triples, which is exact and never compares a float.
+// WeldByValue can then merge vertices that only match within an
+// epsilon (duplicated "v" lines and the like).
+// --------------------------------------------------------
+namespace MeshWelding
+{
+	// Welds corners one at a time, for callers that don't have every face up
+	// front (see MeshStreaming).  Vertices are numbered in the order their
+	// triples first show up, and only the triples are kept - the caller fills
+	// in the values once it has them.
+	class CornerWelder
+	{
+		// Open addressing, slots hold a vertex index (or -1), and keys[v] is
+		// vertex v's index triple
+		std::vector<int> slots;
+		std::vector<tinyobj::index_t> keys;
+
+		void Rehash(unsigned int tableSize);
+
+	public:
+		CornerWelder();
+
+		// Sizes the table for about this many corners up front
+		void Reserve(size_t cornerCount);
+
+		// The vertex index for this corner's triple
+		unsigned int Add(const tinyobj::index_t& corner);
+
+		// Index triple of each vertex so far
+		const std::vector<tinyobj::index_t>& GetKeys();
+	};
+
+	// One vertex per distinct index triple and one index per face corner (the
+	// faces must already be triangles, which tinyobj does by default).  Missing
+	// normals or UVs come out as zero.
+	void WeldCorners(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+		std::vector<Vertex>* vertices, std::vector<unsigned int>* indices);
+
+	// Merges vertices whose position, normal and UV round to the same multiples
+	// of epsilon, and remaps indices to match.  Tangents are ignored (they're
+	// calculated afterwards).
+	void WeldByValue(float epsilon, std::vector<Vertex>* vertices, std::vector<unsigned int>* indices);
+}
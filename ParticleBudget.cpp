@@ -0,0 +1,153 @@
+#include "ParticleBudget.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+ParticleBudget::ParticleBudget(int maxParticles, int maxEmitters, float fullDetailSize, float minDetail)
+{
+	this->maxParticles = maxParticles;
+	this->fullDetailSize = fullDetailSize;
+	this->minDetail = minDetail;
+
+	hasView = false;
+	order.reserve(maxEmitters);
+	requests.resize(maxEmitters, 0);
+
+	stats = {};
+	stats.Budget = maxParticles;
+}
+
+void ParticleBudget::SetMaxParticles(int maxParticles)
+{
+	this->maxParticles = maxParticles;
+	stats.Budget = maxParticles;
+}
+
+void ParticleBudget::SetView(const XMFLOAT4X4& view, const XMFLOAT4X4& projection)
+{
+	this->view = view;
+	this->projection = projection;
+	hasView = true;
+}
+
+float ParticleBudget::GetScreenSize(XMFLOAT3 position, float radius)
+{
+	// No camera yet - treat everything as fully visible
+	if (!hasView)
+		return fullDetailSize;
+
+	// View space position (rows of the transposed view matrix are the camera's axes)
+	float viewX = position.x * view._11 + position.y * view._12 + position.z * view._13 + view._14;
+	float viewY = position.x * view._21 + position.y * view._22 + position.z * view._23 + view._24;
+	float depth = position.x * view._31 + position.y * view._32 + position.z * view._33 + view._34;
+
+	// Entirely behind the camera, or the camera is inside it
+	if (depth + radius <= 0.0f)
+		return 0.0f;
+	if (depth <= radius)
+		return 1.0f;
+
+	// Outside the sides of the screen
+	float projectedRadius = radius * projection._22 / depth;
+	float aspectRadius = radius * projection._11 / depth;
+	if (fabsf(viewX * projection._11 / depth) - aspectRadius > 1.0f ||
+		fabsf(viewY * projection._22 / depth) - projectedRadius > 1.0f)
+		return 0.0f;
+
+	return projectedRadius;
+}
+
+float ParticleBudget::GetVisibility(XMFLOAT3 position, float radius, float importance)
+{
+	return GetScreenSize(position, radius) * importance;
+}
+
+void ParticleBudget::Apply(std::vector<Emitter>& emitters, std::vector<bool>& drop)
+{
+	stats.Requested = 0;
+	stats.Granted = 0;
+	stats.ThrottledEmitters = 0;
+	stats.DroppedEmitters = 0;
+
+	// What each emitter wants for its size on screen
+	int emitterCount = (int)emitters.size();
+	int total = 0;
+	int minimum = 0;
+	order.clear();
+	for (int i = 0; i < emitterCount; i++)
+	{
+		Emitter& emitter = emitters[i];
+		const EmitterSettings* settings = emitter.GetSettings();
+		float visibility = GetVisibility(emitter.GetPosition(), emitter.GetBoundingRadius(), settings->Importance);
+		emitter.SetVisibility(visibility);
+
+		float detail = visibility / fullDetailSize;
+		if (detail > 1.0f) detail = 1.0f;
+		if (detail < minDetail) detail = minDetail;
+
+		requests[i] = (int)ceilf(settings->MaxParticles * detail);
+		total += requests[i];
+		minimum += (int)ceilf(settings->MaxParticles * minDetail);
+		stats.Requested += settings->MaxParticles;
+
+		// Least visible first - there are never many emitters, so insertion sort
+		int slot = (int)order.size();
+		order.push_back(i);
+		while (slot > 0 && emitters[order[slot - 1]].GetVisibility() > visibility)
+		{
+			order[slot] = order[slot - 1];
+			slot--;
+		}
+		order[slot] = i;
+	}
+
+	// Drop the least visible until everything left fits at minimum detail
+	for (int i = 0; i < emitterCount; i++)
+		drop[i] = false;
+	for (int k = 0; k < emitterCount && minimum > maxParticles; k++)
+	{
+		int i = order[k];
+		drop[i] = true;
+		minimum -= (int)ceilf(emitters[i].GetSettings()->MaxParticles * minDetail);
+		total -= requests[i];
+		stats.DroppedEmitters++;
+	}
+
+	// Whatever's over the minimum is scaled down evenly to fit
+	float share = 1.0f;
+	if (total > maxParticles && total > minimum)
+		share = (float)(maxParticles - minimum) / (total - minimum);
+
+	for (int i = 0; i < emitterCount; i++)
+	{
+		if (drop[i])
+			continue;
+
+		int maxCount = emitters[i].GetSettings()->MaxParticles;
+		int minCount = (int)ceilf(maxCount * minDetail);
+		int limit = requests[i];
+		if (share < 1.0f)
+			limit = minCount + (int)((limit - minCount) * share);
+
+		emitters[i].SetBudget(limit, (float)limit / maxCount);
+		stats.Granted += limit;
+		if (limit < maxCount)
+			stats.ThrottledEmitters++;
+	}
+}
+
+void ParticleBudget::CountEviction()
+{
+	stats.EvictedEmitters++;
+}
+
+void ParticleBudget::CountRejection()
+{
+	stats.RejectedSpawns++;
+}
+
+const ParticleBudgetStats& ParticleBudget::GetStats()
+{
+	return stats;
+}
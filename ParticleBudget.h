@@ -0,0 +1,62 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+#include "Emitter.h"
+
+// What the budget decided, for the debug overlay
+struct ParticleBudgetStats
+{
+	int Budget;				// Most particles allowed alive at once
+	int Requested;			// What every emitter would get at full detail
+	int Granted;			// What they were given after throttling
+	int ThrottledEmitters;	// Emitters running below full detail
+	int DroppedEmitters;	// Retired early to stay in budget (last apply)
+	int EvictedEmitters;	// Retired to make room for a more visible one (running total)
+	int RejectedSpawns;		// New emitters that weren't visible enough to get in (running total)
+};
+
+// --------------------------------------------------------
+// Keeps the total number of live particles under a fixed cap
+//
+// Every emitter is weighed by how big it is on screen times its
+// importance.  Small or unimportant emitters have their particle
+// limit and spawn rate scaled down, and if the budget is still
+// exceeded with everything at minimum detail, the least visible
+// emitters are dropped.
+// --------------------------------------------------------
+class ParticleBudget
+{
+	int maxParticles;
+	float fullDetailSize;	// Projected radius (as a fraction of half the screen) that gets full detail
+	float minDetail;		// Lowest fraction of its particles an emitter is throttled to
+
+	// Camera matrices, transposed like the Camera keeps them
+	bool hasView;
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 projection;
+
+	// Scratch, sized for the most emitters there can be
+	std::vector<int> order;
+	std::vector<int> requests;
+
+	ParticleBudgetStats stats;
+public:
+	ParticleBudget(int maxParticles, int maxEmitters, float fullDetailSize = 0.1f, float minDetail = 0.25f);
+
+	void SetMaxParticles(int maxParticles);
+	void SetView(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection);
+
+	// Projected radius of a sphere, 0 when it's entirely off screen
+	float GetScreenSize(DirectX::XMFLOAT3 position, float radius);
+	float GetVisibility(DirectX::XMFLOAT3 position, float radius, float importance);
+
+	// Sets every emitter's particle limit and spawn rate.  Emitters that
+	// have to go to stay in budget are flagged in drop.
+	void Apply(std::vector<Emitter>& emitters, std::vector<bool>& drop);
+
+	void CountEviction();
+	void CountRejection();
+	const ParticleBudgetStats& GetStats();
+};
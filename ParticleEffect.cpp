@@ -0,0 +1,196 @@
+#include "ParticleEffect.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace DirectX;
+
+void ParticleCurve::AddKey(float age, float value)
+{
+	// Keep the keys in age order
+	Key key = { age, value };
+	size_t slot = keys.size();
+	keys.push_back(key);
+	while (slot > 0 && keys[slot - 1].Age > age)
+	{
+		keys[slot] = keys[slot - 1];
+		slot--;
+	}
+	keys[slot] = key;
+}
+
+bool ParticleCurve::IsEmpty()
+{
+	return keys.empty();
+}
+
+float ParticleCurve::Evaluate(float age)
+{
+	if (keys.empty())
+		return 0.0f;
+	if (age <= keys.front().Age)
+		return keys.front().Value;
+	if (age >= keys.back().Age)
+		return keys.back().Value;
+
+	// Find the two keys either side of the age and blend between them
+	size_t next = 1;
+	while (keys[next].Age < age)
+		next++;
+	const Key& a = keys[next - 1];
+	const Key& b = keys[next];
+	float span = b.Age - a.Age;
+	float t = span > 0.0f ? (age - a.Age) / span : 1.0f;
+	return a.Value + t * (b.Value - a.Value);
+}
+
+void ParticleCurve::Bake(float* table, int size)
+{
+	for (int i = 0; i < size; i++)
+		table[i] = Evaluate((float)i / (size - 1));
+}
+
+void ParticleCurve::BakeIntegrated(float* table, int size)
+{
+	// Trapezoid rule between table entries
+	float step = 1.0f / (size - 1);
+	float total = 0.0f;
+	float previous = Evaluate(0.0f);
+	table[0] = 0.0f;
+	for (int i = 1; i < size; i++)
+	{
+		float speed = Evaluate(i * step);
+		total += (previous + speed) * 0.5f * step;
+		table[i] = total;
+		previous = speed;
+	}
+
+	// Normalize so the particle still ends up at its end rotation
+	for (int i = 0; i < size; i++)
+		table[i] = total != 0.0f ? table[i] / total : (float)i / (size - 1);
+}
+
+static void ReportUnreadable(const char* path, int lineNumber, const std::string& name)
+{
+	std::cerr << path << "(" << lineNumber << "): couldn't read " << name << std::endl;
+}
+
+// --------------------------------------------------------
+// The file is one setting per line, "name values...", with #
+// starting a comment.  Curve lines ("color", "alpha", "size",
+// "rotationSpeed") add one key each, starting with the age, and
+// "burst" lines add a burst (time, then particle count).  A key
+// or burst line that doesn't read is skipped.
+// --------------------------------------------------------
+bool LoadEmitterSettings(const char* path, EmitterSettings* settings)
+{
+	// Defaults - an effect that emits nothing unless the file says otherwise
+	*settings = EmitterSettings();
+	settings->Lifetime = 1.0f;
+	settings->Importance = 1.0f;
+
+	ParticleCurve red, green, blue, alpha, size, rotationSpeed;
+
+	std::ifstream file(path);
+	if (!file.is_open())
+		std::cerr << "Couldn't open effect " << path << std::endl;
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		size_t comment = line.find('#');
+		if (comment != std::string::npos)
+			line.erase(comment);
+
+		std::istringstream values(line);
+		std::string name;
+		if (!(values >> name))
+			continue;
+
+		float age = 0.0f;
+		if (name == "maxParticles") values >> settings->MaxParticles;
+		else if (name == "particlesPerSecond") values >> settings->ParticlesPerSecond;
+		else if (name == "lifetime") values >> settings->Lifetime;
+		else if (name == "duration") values >> settings->Duration;
+		else if (name == "importance") values >> settings->Importance;
+		else if (name == "analytic") values >> settings->Analytic;
+		else if (name == "startVelocity") values >> settings->StartVelocity.x >> settings->StartVelocity.y >> settings->StartVelocity.z;
+		else if (name == "velocityRandomRange") values >> settings->VelocityRandomRange.x >> settings->VelocityRandomRange.y >> settings->VelocityRandomRange.z;
+		else if (name == "positionRandomRange") values >> settings->PositionRandomRange.x >> settings->PositionRandomRange.y >> settings->PositionRandomRange.z;
+		else if (name == "rotationRandomRanges") values >> settings->RotationRandomRanges.x >> settings->RotationRandomRanges.y >> settings->RotationRandomRanges.z >> settings->RotationRandomRanges.w;
+		else if (name == "acceleration") values >> settings->Acceleration.x >> settings->Acceleration.y >> settings->Acceleration.z;
+		else if (name == "burst")
+		{
+			ParticleBurst burst;
+			if (!(values >> burst.Time >> burst.Count))
+			{
+				ReportUnreadable(path, lineNumber, name);
+				continue;
+			}
+			if (settings->BurstCount == maxParticleBursts)
+			{
+				std::cerr << path << "(" << lineNumber << "): too many bursts" << std::endl;
+				continue;
+			}
+
+			// Keep the bursts in time order
+			int slot = settings->BurstCount++;
+			while (slot > 0 && settings->Bursts[slot - 1].Time > burst.Time)
+			{
+				settings->Bursts[slot] = settings->Bursts[slot - 1];
+				slot--;
+			}
+			settings->Bursts[slot] = burst;
+		}
+		else if (name == "color")
+		{
+			float r, g, b;
+			if (!(values >> age >> r >> g >> b))
+			{
+				ReportUnreadable(path, lineNumber, name);
+				continue;
+			}
+			red.AddKey(age, r);
+			green.AddKey(age, g);
+			blue.AddKey(age, b);
+		}
+		else if (name == "alpha" || name == "size" || name == "rotationSpeed")
+		{
+			float value;
+			if (!(values >> age >> value))
+			{
+				ReportUnreadable(path, lineNumber, name);
+				continue;
+			}
+			ParticleCurve& curve = name == "alpha" ? alpha : name == "size" ? size : rotationSpeed;
+			curve.AddKey(age, value);
+		}
+		else
+		{
+			std::cerr << path << "(" << lineNumber << "): unknown setting " << name << std::endl;
+			continue;
+		}
+
+		if (values.fail())
+			ReportUnreadable(path, lineNumber, name);
+	}
+
+	// Defaults for anything not given
+	if (red.IsEmpty()) { red.AddKey(0, 1); green.AddKey(0, 1); blue.AddKey(0, 1); }
+	if (alpha.IsEmpty()) alpha.AddKey(0, 1);
+	if (size.IsEmpty()) size.AddKey(0, 1);
+	if (rotationSpeed.IsEmpty()) rotationSpeed.AddKey(0, 1);
+
+	ParticleCurves& curves = settings->Curves;
+	red.Bake(curves.R, particleCurveResolution);
+	green.Bake(curves.G, particleCurveResolution);
+	blue.Bake(curves.B, particleCurveResolution);
+	alpha.Bake(curves.A, particleCurveResolution);
+	size.Bake(curves.Size, particleCurveResolution);
+	rotationSpeed.BakeIntegrated(curves.Rotation, particleCurveResolution);
+	return file.is_open();
+}
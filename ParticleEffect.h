@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+#include "Emitter.h"
+
+// --------------------------------------------------------
+// A value over a particle's life, as keys at ages from 0 to 1
+// with straight lines between them.  Before the first key and
+// after the last one the value holds steady.
+// --------------------------------------------------------
+class ParticleCurve
+{
+	struct Key
+	{
+		float Age;
+		float Value;
+	};
+
+	std::vector<Key> keys;
+public:
+	void AddKey(float age, float value);
+	bool IsEmpty();
+
+	float Evaluate(float age);
+
+	// Samples the curve into table[0..size), evenly across the particle's life
+	void Bake(float* table, int size);
+
+	// Treats the curve as a rotation speed - the table gets how far through
+	// its total rotation a particle is at each age (0 at birth, 1 at death)
+	void BakeIntegrated(float* table, int size);
+};
+
+// --------------------------------------------------------
+// Loads an effect description (see assets/Effects) and bakes
+// its curves.  Settings not in the file default to zero (so no
+// particles), missing curves to white, opaque, size 1 and constant
+// rotation speed.  Returns false if the file can't be read.
+// --------------------------------------------------------
+bool LoadEmitterSettings(const char* path, EmitterSettings* settings);
@@ -0,0 +1,565 @@
+#include "ParticleKernels.h"
+#include "ParticleUpdateKernel.h"
+
+#include <cstring>
+#include <emmintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// Number of float arrays in ParticleArrays
+static const int particleArrayCount = 18;
+
+void ParticleKernels::Allocate(ParticleArrays* arrays, int count, float deadAge)
+{
+	// Round up so the 8 wide kernel never reads past the end
+	int capacity = (count + 7) & ~7;
+	float* block = (float*)_mm_malloc(sizeof(float) * capacity * particleArrayCount, 32);
+	memset(block, 0, sizeof(float) * capacity * particleArrayCount);
+
+	float** fields[particleArrayCount] = {
+		&arrays->Age,
+		&arrays->StartX, &arrays->StartY, &arrays->StartZ,
+		&arrays->VelocityX, &arrays->VelocityY, &arrays->VelocityZ,
+		&arrays->RotationStart, &arrays->RotationEnd,
+		&arrays->X, &arrays->Y, &arrays->Z,
+		&arrays->Size, &arrays->Rotation,
+		&arrays->R, &arrays->G, &arrays->B, &arrays->A };
+	for (int i = 0; i < particleArrayCount; i++)
+		*fields[i] = block + i * capacity;
+
+	for (int i = 0; i < capacity; i++)
+		arrays->Age[i] = deadAge;
+
+	arrays->Capacity = capacity;
+}
+
+void ParticleKernels::Free(ParticleArrays* arrays)
+{
+	// Age is the start of the block
+	_mm_free(arrays->Age);
+	memset(arrays, 0, sizeof(ParticleArrays));
+}
+
+bool ParticleKernels::HasAVX2()
+{
+	int info[4] = {};
+#if defined(_MSC_VER)
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	// The OS has to save the YMM registers too
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	unsigned int a, b, c, d;
+	if (__get_cpuid_max(0, 0) < 7)
+		return false;
+
+	__cpuid(1, a, b, c, d);
+	if (!(c & (1 << 27)) || !(c & (1 << 28)))
+		return false;
+	unsigned int xcr0, xcr0High;
+	__asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+	if ((xcr0 & 6) != 6)
+		return false;
+
+	__cpuid_count(7, 0, a, b, c, d);
+	(void)info;
+	return (b & (1 << 5)) != 0;
+#endif
+}
+
+int ParticleKernels::Update(const ParticleUpdateParams& params, const ParticleArrays& arrays, int first, int count)
+{
+	static bool avx2 = HasAVX2();
+	UpdateKernel kernel = avx2 ? GetUpdateKernelAVX2(params.Features) : GetUpdateKernelSSE(params.Features);
+	return kernel(params, arrays, first, count);
+}
+
+// --------------------------------------------------------
+// Reference kernel, one particle at a time.  Also finishes
+// whatever doesn't fill a whole group in the wider kernels.
+// --------------------------------------------------------
+int ParticleKernels::UpdateScalar(const ParticleUpdateParams& params, const ParticleArrays& arrays, int first, int count)
+{
+	const ParticleCurves& curves = *params.Curves;
+	float curveScale = (particleCurveResolution - 1) / params.Lifetime;
+	float lastEntry = (float)(particleCurveResolution - 1);
+
+	int deaths = 0;
+	for (int i = first; i < first + count; i++)
+	{
+		// Already dead, nothing to do
+		if (arrays.Age[i] >= params.Lifetime)
+			continue;
+
+		float t = arrays.Age[i] + params.DeltaTime;
+		arrays.Age[i] = t;
+		if (t >= params.Lifetime)
+		{
+			deaths++;
+			continue;
+		}
+
+		// Nearest curve entry to the particle's age
+		float entry = t * curveScale + 0.5f;
+		int c = (int)(entry < lastEntry ? entry : lastEntry);
+
+		arrays.R[i] = curves.R[c];
+		arrays.G[i] = curves.G[c];
+		arrays.B[i] = curves.B[c];
+		arrays.A[i] = curves.A[c];
+		arrays.Size[i] = curves.Size[c];
+		arrays.Rotation[i] = arrays.RotationStart[i] + curves.Rotation[c] * (arrays.RotationEnd[i] - arrays.RotationStart[i]);
+
+		// Constant acceleration: a * t^2 / 2 + v * t + p
+		float halfT2 = t * t * 0.5f;
+		arrays.X[i] = params.Acceleration.x * halfT2 + arrays.VelocityX[i] * t + arrays.StartX[i];
+		arrays.Y[i] = params.Acceleration.y * halfT2 + arrays.VelocityY[i] * t + arrays.StartY[i];
+		arrays.Z[i] = params.Acceleration.z * halfT2 + arrays.VelocityZ[i] * t + arrays.StartZ[i];
+	}
+	return deaths;
+}
+
+int ParticleKernels::UpdateAges(const ParticleUpdateParams& params, const ParticleArrays& arrays, int first, int count)
+{
+	__m128 dt = _mm_set1_ps(params.DeltaTime);
+	__m128 lifetime = _mm_set1_ps(params.Lifetime);
+
+	int deaths = 0;
+	int end = first + count;
+	int i = first;
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 age = _mm_loadu_ps(arrays.Age + i);
+		__m128 wasAlive = _mm_cmplt_ps(age, lifetime);
+		__m128 t = _mm_add_ps(age, dt);
+		_mm_storeu_ps(arrays.Age + i, _mm_or_ps(_mm_and_ps(wasAlive, t), _mm_andnot_ps(wasAlive, age)));
+
+		int diedMask = _mm_movemask_ps(_mm_and_ps(wasAlive, _mm_cmpge_ps(t, lifetime)));
+		deaths += (diedMask & 1) + ((diedMask >> 1) & 1) + ((diedMask >> 2) & 1) + ((diedMask >> 3) & 1);
+	}
+
+	for (; i < end; i++)
+	{
+		if (arrays.Age[i] >= params.Lifetime)
+			continue;
+		arrays.Age[i] += params.DeltaTime;
+		if (arrays.Age[i] >= params.Lifetime)
+			deaths++;
+	}
+	return deaths;
+}
+
+// --------------------------------------------------------
+// SSE for the wide kernel (ParticleUpdateKernel.h).  SSE has
+// no gather, so the curve lookups are done per lane.
+// --------------------------------------------------------
+struct SSEOps
+{
+	typedef __m128 Float;
+	typedef __m128i Int;
+	enum { Width = 4 };
+
+	static Float Load(const float* p) { return _mm_loadu_ps(p); }
+	static void Store(float* p, Float v) { _mm_storeu_ps(p, v); }
+	static Float Set1(float v) { return _mm_set1_ps(v); }
+	static Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+	static Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+	static Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+	static Float Min(Float a, Float b) { return _mm_min_ps(a, b); }
+	static Float And(Float a, Float b) { return _mm_and_ps(a, b); }
+	static Float LessThan(Float a, Float b) { return _mm_cmplt_ps(a, b); }
+	static Float GreaterEqual(Float a, Float b) { return _mm_cmpge_ps(a, b); }
+	static Float Select(Float mask, Float a, Float b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+	static int MoveMask(Float v) { return _mm_movemask_ps(v); }
+	static Int ToInt(Float v) { return _mm_cvttps_epi32(v); }
+
+	static Float Gather(const float* table, Int indices)
+	{
+		int entries[4];
+		_mm_storeu_si128((__m128i*)entries, indices);
+		return _mm_set_ps(table[entries[3]], table[entries[2]], table[entries[1]], table[entries[0]]);
+	}
+};
+
+ParticleKernels::UpdateKernel ParticleKernels::GetUpdateKernelSSE(unsigned int features)
+{
+	return ParticleUpdateKernels<SSEOps>::Get(features);
+}
+
+// 4 wide, every feature
+int ParticleKernels::UpdateSSE(const ParticleUpdateParams& params, const ParticleArrays& arrays, int first, int count)
+{
+	return UpdateParticlesWide<SSEOps, true, true, true>(params, arrays, first, count);
+}
+
+// --------------------------------------------------------
+// Initializes freshly spawned particles, four at a time.  Each
+// field is its own pass so only a couple of arrays are being
+// written at once.
+// --------------------------------------------------------
+void ParticleKernels::Spawn(const ParticleSpawnParams& params, const ParticleArrays& arrays, int first, int count, const float* randoms)
+{
+	// Constant fields
+	const float constants[6] = { params.Size, params.Color.x, params.Color.y, params.Color.z, params.Color.w, params.Age };
+	float* constantArrays[6] = { arrays.Size, arrays.R, arrays.G, arrays.B, arrays.A, arrays.Age };
+	for (int f = 0; f < 6; f++)
+	{
+		float* out = constantArrays[f] + first;
+		__m128 value = _mm_set1_ps(constants[f]);
+		int i = 0;
+		for (; i + 4 <= count; i += 4)
+			_mm_storeu_ps(out + i, value);
+		for (; i < count; i++)
+			out[i] = constants[f];
+	}
+
+	// Random fields are base + random * scale, written to one or two arrays
+	struct RandomField
+	{
+		float Base;
+		float Scale;
+		float* Out;
+		float* AlsoOut;
+	};
+	RandomField fields[particleSpawnRandoms] =
+	{
+		{ params.Position.x - params.PositionRange.x, params.PositionRange.x * 2, arrays.StartX, arrays.X },
+		{ params.Position.y - params.PositionRange.y, params.PositionRange.y * 2, arrays.StartY, arrays.Y },
+		{ params.Position.z - params.PositionRange.z, params.PositionRange.z * 2, arrays.StartZ, arrays.Z },
+		{ params.Velocity.x - params.VelocityRange.x, params.VelocityRange.x * 2, arrays.VelocityX, 0 },
+		{ params.Velocity.y - params.VelocityRange.y, params.VelocityRange.y * 2, arrays.VelocityY, 0 },
+		{ params.Velocity.z - params.VelocityRange.z, params.VelocityRange.z * 2, arrays.VelocityZ, 0 },
+		{ params.RotationRanges.x, params.RotationRanges.y - params.RotationRanges.x, arrays.RotationStart, arrays.Rotation },
+		{ params.RotationRanges.z, params.RotationRanges.w - params.RotationRanges.z, arrays.RotationEnd, 0 },
+	};
+
+	for (int f = 0; f < particleSpawnRandoms; f++)
+	{
+		const RandomField& field = fields[f];
+		const float* r = randoms + f * count;
+		float* out = field.Out + first;
+		float* alsoOut = field.AlsoOut ? field.AlsoOut + first : 0;
+		__m128 base = _mm_set1_ps(field.Base);
+		__m128 scale = _mm_set1_ps(field.Scale);
+
+		int i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 value = _mm_add_ps(base, _mm_mul_ps(_mm_loadu_ps(r + i), scale));
+			_mm_storeu_ps(out + i, value);
+			if (alsoOut)
+				_mm_storeu_ps(alsoOut + i, value);
+		}
+		for (; i < count; i++)
+		{
+			out[i] = field.Base + r[i] * field.Scale;
+			if (alsoOut)
+				alsoOut[i] = out[i];
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Ages come from the birth times, then it's an ordinary update
+// with no time step - the update kernels are already closed form
+// in age, so they give the same answer a stepped particle would.
+// --------------------------------------------------------
+void ParticleKernels::Evaluate(const ParticleUpdateParams& params, float time, const ParticleArrays& arrays, int first, int count, ParticleArrays* state)
+{
+	state->StartX = arrays.StartX + first;
+	state->StartY = arrays.StartY + first;
+	state->StartZ = arrays.StartZ + first;
+	state->VelocityX = arrays.VelocityX + first;
+	state->VelocityY = arrays.VelocityY + first;
+	state->VelocityZ = arrays.VelocityZ + first;
+	state->RotationStart = arrays.RotationStart + first;
+	state->RotationEnd = arrays.RotationEnd + first;
+	state->Capacity = count;
+
+	// Left alone by the kernel, so read straight from the spawn values
+	if (!(params.Features & particleFeatureRotation))
+		state->Rotation = arrays.Rotation + first;
+	if (!(params.Features & particleFeatureColorOverLife))
+	{
+		state->R = arrays.R + first;
+		state->G = arrays.G + first;
+		state->B = arrays.B + first;
+		state->A = arrays.A + first;
+	}
+
+	const float* births = arrays.Age + first;
+	__m128 now = _mm_set1_ps(time);
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(state->Age + i, _mm_sub_ps(now, _mm_loadu_ps(births + i)));
+	for (; i < count; i++)
+		state->Age[i] = time - births[i];
+
+	ParticleUpdateParams evaluate = params;
+	evaluate.DeltaTime = 0.0f;
+	Update(evaluate, *state, 0, count);
+}
+
+// --------------------------------------------------------
+// Builds the quads for a range of particles
+//
+// The corner offsets (-1,1), (1,1), (1,-1), (-1,-1) rotated by
+// the particle's rotation only take two distinct vectors, so each
+// particle needs one sin/cos (done four particles at a time) and
+// two multiply-adds against the camera's right and up vectors.
+// Without Rotation every particle shares one sin/cos, and without
+// SpriteSheet every quad gets the first frame.
+// --------------------------------------------------------
+template <bool Rotation, bool SpriteSheet>
+static void ExpandBillboardQuads(const BillboardParams& params, const ParticleArrays& arrays, int first, int count, ParticleVertex* vertices)
+{
+	using namespace DirectX;
+
+	XMVECTOR camRight = XMLoadFloat3(&params.CameraRight);
+	XMVECTOR camUp = XMLoadFloat3(&params.CameraUp);
+	float framesPerLifetime = params.FrameCount / params.Lifetime;
+	int lastFrame = params.FrameCount - 1;
+
+	XMFLOAT4 sines, cosines;
+	if (!Rotation)
+	{
+		XMVECTOR sinVec, cosVec;
+		XMVectorSinCos(&sinVec, &cosVec, XMVectorReplicate(arrays.Rotation[first]));
+		XMStoreFloat4(&sines, sinVec);
+		XMStoreFloat4(&cosines, cosVec);
+	}
+
+	int end = first + count;
+	for (int group = first; group < end; group += 4)
+	{
+		int groupCount = end - group < 4 ? end - group : 4;
+		if (Rotation)
+		{
+			// Sin and cos for up to four particles at once
+			XMFLOAT4 rotation(0, 0, 0, 0);
+			float* rotationLanes = &rotation.x;
+			for (int lane = 0; lane < groupCount; lane++)
+				rotationLanes[lane] = arrays.Rotation[group + lane];
+
+			XMVECTOR sinVec, cosVec;
+			XMVectorSinCos(&sinVec, &cosVec, XMLoadFloat4(&rotation));
+			XMStoreFloat4(&sines, sinVec);
+			XMStoreFloat4(&cosines, cosVec);
+		}
+
+		for (int lane = 0; lane < groupCount; lane++)
+		{
+			int i = group + lane;
+			float sine = (&sines.x)[lane];
+			float cosine = (&cosines.x)[lane];
+			float size = arrays.Size[i];
+
+			// Rotated corner (1,1) is (c - s, c + s), corner (1,-1) is (c + s, s - c),
+			// and the other two are their negatives
+			float a = (cosine - sine) * size;
+			float b = (cosine + sine) * size;
+			XMVECTOR position = XMVectorSet(arrays.X[i], arrays.Y[i], arrays.Z[i], 0);
+			XMVECTOR cornerA = camRight * a + camUp * b;
+			XMVECTOR cornerB = camRight * b - camUp * a;
+
+			ParticleVertex* quad = vertices + (i - first) * 4;
+			XMStoreFloat3(&quad[0].Position, position - cornerB);
+			XMStoreFloat3(&quad[1].Position, position + cornerA);
+			XMStoreFloat3(&quad[2].Position, position + cornerB);
+			XMStoreFloat3(&quad[3].Position, position - cornerA);
+
+			XMFLOAT4 color(arrays.R[i], arrays.G[i], arrays.B[i], arrays.A[i]);
+			quad[0].Color = color;
+			quad[1].Color = color;
+			quad[2].Color = color;
+			quad[3].Color = color;
+
+			// Sprite sheet frame from the particle's age
+			int frame = 0;
+			if (SpriteSheet)
+			{
+				frame = (int)(arrays.Age[i] * framesPerLifetime);
+				if (frame > lastFrame)
+					frame = lastFrame;
+			}
+			XMFLOAT2 uv = params.Frames[frame];
+			quad[0].UV = uv;
+			quad[1].UV = XMFLOAT2(uv.x + params.FrameSize.x, uv.y);
+			quad[2].UV = XMFLOAT2(uv.x + params.FrameSize.x, uv.y + params.FrameSize.y);
+			quad[3].UV = XMFLOAT2(uv.x, uv.y + params.FrameSize.y);
+		}
+	}
+}
+
+void ParticleKernels::ExpandBillboards(const BillboardParams& params, const ParticleArrays& arrays, int first, int count, ParticleVertex* vertices)
+{
+	if (count <= 0)
+		return;
+
+	typedef void(*Expand)(const BillboardParams&, const ParticleArrays&, int, int, ParticleVertex*);
+	static const Expand expands[4] =
+	{
+		ExpandBillboardQuads<false, false>,
+		ExpandBillboardQuads<true, false>,
+		ExpandBillboardQuads<false, true>,
+		ExpandBillboardQuads<true, true>,
+	};
+	bool rotation = (params.Features & particleFeatureRotation) != 0;
+	bool spriteSheet = (params.Features & particleFeatureSpriteSheet) != 0;
+	expands[(rotation ? 1 : 0) + (spriteSheet ? 2 : 0)](params, arrays, first, count, vertices);
+}
+
+// --------------------------------------------------------
+// View space depth is just a dot product with the camera's
+// forward vector (the translation part is the same for every
+// particle, so it doesn't change the order)
+// --------------------------------------------------------
+void ParticleKernels::ViewDepths(DirectX::XMFLOAT3 forward, const ParticleArrays& arrays, int first, int count, float* depths)
+{
+	__m128 fx = _mm_set1_ps(forward.x);
+	__m128 fy = _mm_set1_ps(forward.y);
+	__m128 fz = _mm_set1_ps(forward.z);
+
+	// Neither side is necessarily aligned here
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		int p = first + i;
+		__m128 depth = _mm_mul_ps(_mm_loadu_ps(arrays.X + p), fx);
+		depth = _mm_add_ps(depth, _mm_mul_ps(_mm_loadu_ps(arrays.Y + p), fy));
+		depth = _mm_add_ps(depth, _mm_mul_ps(_mm_loadu_ps(arrays.Z + p), fz));
+		_mm_storeu_ps(depths + i, depth);
+	}
+
+	for (; i < count; i++)
+	{
+		int p = first + i;
+		depths[i] = arrays.X[p] * forward.x + arrays.Y[p] * forward.y + arrays.Z[p] * forward.z;
+	}
+}
+
+// --------------------------------------------------------
+// Quantizes depths into 16 bit keys over the range actually in
+// use, farthest first - sorting the keys ascending gives back
+// to front order
+// --------------------------------------------------------
+void ParticleKernels::DepthKeys(const float* depths, int count, unsigned short* keys)
+{
+	if (count == 0)
+		return;
+
+	// Depth range, four at a time
+	__m128 minDepth = _mm_set1_ps(depths[0]);
+	__m128 maxDepth = minDepth;
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 depth = _mm_loadu_ps(depths + i);
+		minDepth = _mm_min_ps(minDepth, depth);
+		maxDepth = _mm_max_ps(maxDepth, depth);
+	}
+	float mins[4], maxs[4];
+	_mm_storeu_ps(mins, minDepth);
+	_mm_storeu_ps(maxs, maxDepth);
+	float nearest = mins[0];
+	float farthest = maxs[0];
+	for (int lane = 1; lane < 4; lane++)
+	{
+		if (mins[lane] < nearest) nearest = mins[lane];
+		if (maxs[lane] > farthest) farthest = maxs[lane];
+	}
+	for (int j = i; j < count; j++)
+	{
+		if (depths[j] < nearest) nearest = depths[j];
+		if (depths[j] > farthest) farthest = depths[j];
+	}
+
+	float scale = farthest > nearest ? 65535.0f / (farthest - nearest) : 0.0f;
+	__m128 far4 = _mm_set1_ps(farthest);
+	__m128 scale4 = _mm_set1_ps(scale);
+	__m128 half = _mm_set1_ps(0.5f);
+	for (i = 0; i + 4 <= count; i += 4)
+	{
+		__m128 key = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(far4, _mm_loadu_ps(depths + i)), scale4), half);
+		__m128i keyInt = _mm_cvttps_epi32(key);
+		int lanes[4];
+		_mm_storeu_si128((__m128i*)lanes, keyInt);
+		keys[i] = (unsigned short)lanes[0];
+		keys[i + 1] = (unsigned short)lanes[1];
+		keys[i + 2] = (unsigned short)lanes[2];
+		keys[i + 3] = (unsigned short)lanes[3];
+	}
+	for (; i < count; i++)
+		keys[i] = (unsigned short)((farthest - depths[i]) * scale + 0.5f);
+}
+
+// --------------------------------------------------------
+// Two 8 bit LSD passes.  Both passes are stable, so particles
+// with equal keys keep the order they went in with.
+// --------------------------------------------------------
+void ParticleKernels::RadixSort(unsigned short* keys, unsigned int* values, unsigned short* keyScratch, unsigned int* valueScratch, int count)
+{
+	if (count == 0)
+		return;
+
+	// Both histograms in one read of the keys
+	int counts[2][256];
+	memset(counts, 0, sizeof(counts));
+	for (int i = 0; i < count; i++)
+	{
+		counts[0][keys[i] & 0xFF]++;
+		counts[1][keys[i] >> 8]++;
+	}
+
+	unsigned short* keysIn = keys;
+	unsigned int* valuesIn = values;
+	unsigned short* keysOut = keyScratch;
+	unsigned int* valuesOut = valueScratch;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		int shift = pass * 8;
+
+		// Every key has the same digit, this pass wouldn't move anything
+		if (counts[pass][keysIn[0] >> shift & 0xFF] == count)
+			continue;
+
+		// Counts to starting offsets
+		int offsets[256];
+		int total = 0;
+		for (int d = 0; d < 256; d++)
+		{
+			offsets[d] = total;
+			total += counts[pass][d];
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			int slot = offsets[keysIn[i] >> shift & 0xFF]++;
+			keysOut[slot] = keysIn[i];
+			valuesOut[slot] = valuesIn[i];
+		}
+
+		unsigned short* keySwap = keysIn; keysIn = keysOut; keysOut = keySwap;
+		unsigned int* valueSwap = valuesIn; valuesIn = valuesOut; valuesOut = valueSwap;
+	}
+
+	// An odd number of passes left the result in the scratch arrays
+	if (keysIn != keys)
+	{
+		memcpy(keys, keysIn, sizeof(unsigned short) * count);
+		memcpy(values, valuesIn, sizeof(unsigned int) * count);
+	}
+}
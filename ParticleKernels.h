@@ -0,0 +1,186 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// Particle fields in structure-of-arrays form
+//
+// Every array holds Capacity floats, starts on a 32 byte
+// boundary and is padded to a multiple of eight, so the
+// kernels can use aligned 4 and 8 wide loads.
+// --------------------------------------------------------
+struct ParticleArrays
+{
+	// Set when a particle spawns
+	float* Age;
+	float* StartX;
+	float* StartY;
+	float* StartZ;
+	float* VelocityX;
+	float* VelocityY;
+	float* VelocityZ;
+	float* RotationStart;
+	float* RotationEnd;
+
+	// Written by the update kernel
+	float* X;
+	float* Y;
+	float* Z;
+	float* Size;
+	float* Rotation;
+	float* R;
+	float* G;
+	float* B;
+	float* A;
+
+	int Capacity;
+};
+
+// One corner of a billboarded particle quad
+struct ParticleVertex
+{
+	DirectX::XMFLOAT3 Position;
+	DirectX::XMFLOAT2 UV;
+	DirectX::XMFLOAT4 Color;
+};
+
+// --------------------------------------------------------
+// Over-lifetime curves baked into lookup tables
+//
+// Entry i holds the value at i / (particleCurveResolution - 1)
+// of a particle's life, and the kernels read the entry nearest
+// to each particle's age.  Rotation is the fraction of the way
+// from a particle's start rotation to its end rotation (the
+// rotation speed curve, integrated).
+// --------------------------------------------------------
+static const int particleCurveResolution = 64;
+
+struct ParticleCurves
+{
+	float R[particleCurveResolution];
+	float G[particleCurveResolution];
+	float B[particleCurveResolution];
+	float A[particleCurveResolution];
+	float Size[particleCurveResolution];
+	float Rotation[particleCurveResolution];
+};
+
+// --------------------------------------------------------
+// Parts of the particle math an effect may not need
+//
+// Each combination gets its own compiled kernel, so an effect
+// only pays for what it uses.  A feature is only left out when
+// skipping it gives exactly the same results:
+//  - Rotation: particles start with different rotations or turn
+//    over their lives (off means every particle always has the
+//    same rotation)
+//  - Acceleration: non-zero acceleration
+//  - ColorOverLife: the color or alpha curves aren't flat
+//  - SpriteSheet: more than one frame to pick from (billboards only)
+// --------------------------------------------------------
+static const unsigned int particleFeatureRotation = 1;
+static const unsigned int particleFeatureAcceleration = 2;
+static const unsigned int particleFeatureColorOverLife = 4;
+static const unsigned int particleFeatureSpriteSheet = 8;
+static const unsigned int particleFeatureAll = 15;
+
+// Everything the kernels need that is the same for every particle of an emitter
+struct ParticleUpdateParams
+{
+	float DeltaTime;
+	float Lifetime;
+	const ParticleCurves* Curves;
+	DirectX::XMFLOAT3 Acceleration;
+	unsigned int Features;
+};
+
+// Everything needed to start new particles of an emitter
+struct ParticleSpawnParams
+{
+	DirectX::XMFLOAT3 Position;
+	DirectX::XMFLOAT3 PositionRange;	// Random offset in [-range, range] on each axis
+	DirectX::XMFLOAT3 Velocity;
+	DirectX::XMFLOAT3 VelocityRange;
+	DirectX::XMFLOAT4 RotationRanges;	// Min start, max start, min end, max end
+	float Size;
+	DirectX::XMFLOAT4 Color;
+	float Age;		// 0, or the birth time for analytic emitters
+};
+
+// Random numbers per spawned particle, see ParticleKernels::Spawn
+static const int particleSpawnRandoms = 8;
+
+// Per-draw data for expanding particles into camera-facing quads
+struct BillboardParams
+{
+	DirectX::XMFLOAT3 CameraRight;
+	DirectX::XMFLOAT3 CameraUp;
+	float Lifetime;
+
+	// Top-left UV of each sprite sheet frame (a single (0,0) frame
+	// with a size of (1,1) when the texture isn't a sprite sheet)
+	const DirectX::XMFLOAT2* Frames;
+	int FrameCount;
+	DirectX::XMFLOAT2 FrameSize;
+
+	unsigned int Features;
+};
+
+namespace ParticleKernels
+{
+	// One aligned block for all of the arrays, ages start out dead
+	void Allocate(ParticleArrays* arrays, int count, float deadAge);
+	void Free(ParticleArrays* arrays);
+
+	// Ages particles [first, first + count) and evaluates their color, size,
+	// rotation and position.  Returns how many died during this step.
+	// Picks the widest kernel the CPU supports the first time it's called,
+	// specialized for params.Features.
+	int Update(const ParticleUpdateParams& params, const ParticleArrays& arrays, int first, int count);
+
+	// The individual kernels, exposed so they can be compared against each
+	// other.  These do every feature, whatever params.Features says.
+	int UpdateScalar(const ParticleUpdateParams& params, const ParticleArrays& arrays, int first, int count);
+	int UpdateSSE(const ParticleUpdateParams& params, const ParticleArrays& arrays, int first, int count);
+	int UpdateAVX2(const ParticleUpdateParams& params, const ParticleArrays& arrays, int first, int count);
+
+	// The wide kernel specialized for a set of features (see ParticleUpdateKernel.h)
+	typedef int(*UpdateKernel)(const ParticleUpdateParams& params, const ParticleArrays& arrays, int first, int count);
+	UpdateKernel GetUpdateKernelSSE(unsigned int features);
+	UpdateKernel GetUpdateKernelAVX2(unsigned int features);
+
+	bool HasAVX2();
+
+	// Only ages particles and counts deaths - for emitters nobody can see.  The
+	// other outputs go stale, but running Update with no time step brings them
+	// back, since the kernels are closed form in age.
+	int UpdateAges(const ParticleUpdateParams& params, const ParticleArrays& arrays, int first, int count);
+
+	// Starts particles [first, first + count), which must be contiguous.  randoms
+	// holds particleSpawnRandoms rows of count numbers in [0, 1): position x, y,
+	// z, velocity x, y, z, start rotation and end rotation.
+	void Spawn(const ParticleSpawnParams& params, const ParticleArrays& arrays, int first, int count, const float* randoms);
+
+	// Analytic mode - particles never get updated, their Age holds their birth
+	// time and everything else is worked out from their spawn values when needed.
+	// Evaluates [first, first + count) at the given emitter time into state's
+	// Age, X, Y, Z, Size, Rotation, R, G, B and A (from index 0), which the caller
+	// provides.  The rest of state is pointed into arrays, so state can go
+	// straight to ExpandBillboards or ViewDepths.  Outputs params.Features says
+	// never change (rotation, color) are pointed into arrays too, not written.
+	void Evaluate(const ParticleUpdateParams& params, float time, const ParticleArrays& arrays, int first, int count, ParticleArrays* state);
+
+	// Writes four vertices for each particle in [first, first + count),
+	// packed from the start of vertices.  Only the rotation and sprite sheet
+	// bits of params.Features matter here.
+	void ExpandBillboards(const BillboardParams& params, const ParticleArrays& arrays, int first, int count, ParticleVertex* vertices);
+
+	// Sorting support - view depth of [first, first + count) packed into depths,
+	// then 16 bit keys that put the farthest particle first
+	void ViewDepths(DirectX::XMFLOAT3 forward, const ParticleArrays& arrays, int first, int count, float* depths);
+	void DepthKeys(const float* depths, int count, unsigned short* keys);
+
+	// Sorts keys ascending, carrying values along.  Stable, and the scratch
+	// arrays must hold count entries each.
+	void RadixSort(unsigned short* keys, unsigned int* values, unsigned short* keyScratch, unsigned int* valueScratch, int count);
+}
@@ -0,0 +1,43 @@
+#include "ParticleKernels.h"
+#include "ParticleUpdateKernel.h"
+
+#include <immintrin.h>
+
+// --------------------------------------------------------
+// AVX2 for the wide kernel (ParticleUpdateKernel.h).  This
+// file is the only one built with AVX2 enabled, and its kernels
+// are only called after ParticleKernels::Update has checked
+// that the CPU supports it.
+// --------------------------------------------------------
+struct AVX2Ops
+{
+	typedef __m256 Float;
+	typedef __m256i Int;
+	enum { Width = 8 };
+
+	static Float Load(const float* p) { return _mm256_loadu_ps(p); }
+	static void Store(float* p, Float v) { _mm256_storeu_ps(p, v); }
+	static Float Set1(float v) { return _mm256_set1_ps(v); }
+	static Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+	static Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+	static Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+	static Float Min(Float a, Float b) { return _mm256_min_ps(a, b); }
+	static Float And(Float a, Float b) { return _mm256_and_ps(a, b); }
+	static Float LessThan(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static Float GreaterEqual(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static Float Select(Float mask, Float a, Float b) { return _mm256_blendv_ps(b, a, mask); }
+	static int MoveMask(Float v) { return _mm256_movemask_ps(v); }
+	static Int ToInt(Float v) { return _mm256_cvttps_epi32(v); }
+	static Float Gather(const float* table, Int indices) { return _mm256_i32gather_ps(table, indices, 4); }
+};
+
+ParticleKernels::UpdateKernel ParticleKernels::GetUpdateKernelAVX2(unsigned int features)
+{
+	return ParticleUpdateKernels<AVX2Ops>::Get(features);
+}
+
+// 8 wide, every feature
+int ParticleKernels::UpdateAVX2(const ParticleUpdateParams& params, const ParticleArrays& arrays, int first, int count)
+{
+	return UpdateParticlesWide<AVX2Ops, true, true, true>(params, arrays, first, count);
+}
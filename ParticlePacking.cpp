@@ -0,0 +1,88 @@
+#include "ParticlePacking.h"
+
+#include <cmath>
+#include <emmintrin.h>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Colors and frames are done four particles at a time, the
+// two halves one at a time
+// --------------------------------------------------------
+void ParticlePacking::Pack(const BillboardParams& params, const ParticleArrays& arrays, int first, int count, PackedParticle* packed)
+{
+	bool spriteSheet = (params.Features & particleFeatureSpriteSheet) != 0;
+	float framesPerLifetime = params.FrameCount / params.Lifetime;
+	int lastFrame = params.FrameCount - 1;
+
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 scale = _mm_set1_ps(255.0f);
+	__m128 half = _mm_set1_ps(0.5f);
+	__m128 frameScale = _mm_set1_ps(spriteSheet ? framesPerLifetime : 0.0f);
+	__m128 maxFrame = _mm_set1_ps((float)lastFrame);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		int p = first + i;
+
+		// Saturate, scale to 0 - 255 and round, then one byte per channel
+		__m128i r = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(arrays.R + p), zero), one), scale), half));
+		__m128i g = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(arrays.G + p), zero), one), scale), half));
+		__m128i b = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(arrays.B + p), zero), one), scale), half));
+		__m128i a = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(arrays.A + p), zero), one), scale), half));
+		__m128i rgba = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+
+		// Frame from age, clamped to the last one
+		__m128i frame = _mm_cvttps_epi32(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(arrays.Age + p), frameScale), maxFrame));
+
+		unsigned int colors[4], frames[4];
+		_mm_storeu_si128((__m128i*)colors, rgba);
+		_mm_storeu_si128((__m128i*)frames, frame);
+		for (int lane = 0; lane < 4; lane++)
+		{
+			PackedParticle& out = packed[i + lane];
+			out.Position = XMFLOAT3(arrays.X[p + lane], arrays.Y[p + lane], arrays.Z[p + lane]);
+			out.Size = PackedVector::XMConvertFloatToHalf(arrays.Size[p + lane]);
+			out.Rotation = PackedVector::XMConvertFloatToHalf(WrapRotation(arrays.Rotation[p + lane]));
+			out.Color = colors[lane];
+			out.Frame = frames[lane];
+		}
+	}
+
+	for (; i < count; i++)
+	{
+		int p = first + i;
+		PackedParticle& out = packed[i];
+		out.Position = XMFLOAT3(arrays.X[p], arrays.Y[p], arrays.Z[p]);
+		out.Size = PackedVector::XMConvertFloatToHalf(arrays.Size[p]);
+		out.Rotation = PackedVector::XMConvertFloatToHalf(WrapRotation(arrays.Rotation[p]));
+		out.Color = PackColor(arrays.R[p], arrays.G[p], arrays.B[p], arrays.A[p]);
+
+		int frame = spriteSheet ? (int)(arrays.Age[p] * framesPerLifetime) : 0;
+		out.Frame = frame > lastFrame ? lastFrame : frame;
+	}
+}
+
+int ParticlePacking::GetUploadSize(int count)
+{
+	return count * sizeof(PackedParticle);
+}
+
+unsigned int ParticlePacking::PackColor(float r, float g, float b, float a)
+{
+	float channels[4] = { r, g, b, a };
+	unsigned int color = 0;
+	for (int c = 0; c < 4; c++)
+	{
+		float value = channels[c] < 0.0f ? 0.0f : (channels[c] > 1.0f ? 1.0f : channels[c]);
+		color |= (unsigned int)(value * 255.0f + 0.5f) << (c * 8);
+	}
+	return color;
+}
+
+float ParticlePacking::WrapRotation(float rotation)
+{
+	return rotation - XM_2PI * floorf(rotation / XM_2PI + 0.5f);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+#include "ParticleKernels.h"
+
+// --------------------------------------------------------
+// One particle as the GPU reads it - 24 bytes
+//
+// The vertex shader builds the quad's corners from this, so
+// each particle is uploaded once instead of as four 36 byte
+// ParticleVertex corners (144 bytes).  Matches the Particle
+// struct in ParticleVS.hlsl.
+// --------------------------------------------------------
+struct PackedParticle
+{
+	DirectX::XMFLOAT3 Position;
+	DirectX::PackedVector::HALF Size;
+	DirectX::PackedVector::HALF Rotation;	// Wrapped into [-pi, pi] to keep the precision
+	unsigned int Color;						// RGBA8, red in the low byte
+	unsigned int Frame;						// Sprite sheet frame
+};
+
+namespace ParticlePacking
+{
+	// Packs particles [first, first + count) from the start of packed.  Uses
+	// the same BillboardParams as ParticleKernels::ExpandBillboards (only the
+	// lifetime, frame count and sprite sheet feature bit matter here).
+	void Pack(const BillboardParams& params, const ParticleArrays& arrays, int first, int count, PackedParticle* packed);
+
+	// Upload size of count particles
+	int GetUploadSize(int count);
+
+	// Single field packing, exposed for checking against the shader's unpacking
+	unsigned int PackColor(float r, float g, float b, float a);
+	float WrapRotation(float rotation);
+}
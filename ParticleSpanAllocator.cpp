@@ -0,0 +1,160 @@
+#include "ParticleSpanAllocator.h"
+
+ParticleSpanAllocator::ParticleSpanAllocator(int capacity, int minSpan)
+{
+	this->capacity = capacity;
+	this->minSpan = minSpan;
+
+	// Enough classes to cover a span the size of the whole store
+	classCount = 1;
+	while (classCount < maxClasses && (minSpan << (classCount - 1)) < capacity)
+		classCount++;
+
+	// Spans are reused far more often than they're split, but reserving
+	// keeps a long wave from reallocating the free lists mid-frame
+	for (int c = 0; c < classCount; c++)
+		freeSpans[c].reserve(capacity / (minSpan << c) + 1);
+	freeClassAt.resize(capacity / minSpan + 1);
+	freeListIndex.resize(capacity / minSpan + 1);
+
+	Clear();
+}
+
+int ParticleSpanAllocator::ClassOf(int count)
+{
+	int sizeClass = 0;
+	while ((minSpan << sizeClass) < count)
+		sizeClass++;
+	return sizeClass;
+}
+
+void ParticleSpanAllocator::PushFree(int offset, int sizeClass)
+{
+	int block = offset / minSpan;
+	freeClassAt[block] = (signed char)sizeClass;
+	freeListIndex[block] = (int)freeSpans[sizeClass].size();
+	freeSpans[sizeClass].push_back(offset);
+}
+
+// Swaps the last span of the same class into its place
+void ParticleSpanAllocator::RemoveFree(int offset)
+{
+	int block = offset / minSpan;
+	std::vector<int>& list = freeSpans[freeClassAt[block]];
+	int last = list.back();
+	list[freeListIndex[block]] = last;
+	freeListIndex[last / minSpan] = freeListIndex[block];
+	list.pop_back();
+	freeClassAt[block] = -1;
+}
+
+int ParticleSpanAllocator::Allocate(int count)
+{
+	if (count <= 0)
+		return -1;
+
+	int sizeClass = ClassOf(count);
+	if (sizeClass >= classCount)
+		return -1;
+	int size = minSpan << sizeClass;
+
+	// Reuse a span of the same size
+	if (!freeSpans[sizeClass].empty())
+	{
+		int offset = freeSpans[sizeClass].back();
+		RemoveFree(offset);
+		usedParticles += size;
+		return offset;
+	}
+
+	// Carve off fresh space, starting on a multiple of the size.  The gap
+	// that skips goes on the free lists as the biggest aligned spans it holds.
+	int aligned = (bumpOffset + size - 1) / size * size;
+	if (aligned + size <= capacity)
+	{
+		while (bumpOffset < aligned)
+		{
+			int gapClass = 0;
+			while (gapClass + 1 < sizeClass &&
+				bumpOffset % (minSpan << (gapClass + 1)) == 0 &&
+				bumpOffset + (minSpan << (gapClass + 1)) <= aligned)
+				gapClass++;
+			PushFree(bumpOffset, gapClass);
+			bumpOffset += minSpan << gapClass;
+		}
+
+		bumpOffset += size;
+		usedParticles += size;
+		return aligned;
+	}
+
+	// Split the smallest bigger span that's free, keeping the front
+	// half each time and putting the back half on the smaller list
+	for (int bigger = sizeClass + 1; bigger < classCount; bigger++)
+	{
+		if (freeSpans[bigger].empty())
+			continue;
+
+		int offset = freeSpans[bigger].back();
+		RemoveFree(offset);
+		for (int c = bigger - 1; c >= sizeClass; c--)
+			PushFree(offset + (minSpan << c), c);
+
+		usedParticles += size;
+		return offset;
+	}
+
+	return -1;
+}
+
+void ParticleSpanAllocator::Free(int offset, int count)
+{
+	int sizeClass = ClassOf(count);
+	usedParticles -= minSpan << sizeClass;
+
+	// Nothing live - start over with one unfragmented store
+	if (usedParticles == 0)
+	{
+		Clear();
+		return;
+	}
+
+	// Merge with the buddy for as long as it's free and the same size
+	while (sizeClass + 1 < classCount)
+	{
+		int buddy = ((offset / minSpan) ^ (1 << sizeClass)) * minSpan;
+		if (buddy / minSpan >= (int)freeClassAt.size() || freeClassAt[buddy / minSpan] != sizeClass)
+			break;
+
+		RemoveFree(buddy);
+		offset = offset < buddy ? offset : buddy;
+		sizeClass++;
+	}
+
+	PushFree(offset, sizeClass);
+}
+
+void ParticleSpanAllocator::Clear()
+{
+	for (int c = 0; c < maxClasses; c++)
+		freeSpans[c].clear();
+	for (int i = 0; i < (int)freeClassAt.size(); i++)
+		freeClassAt[i] = -1;
+	bumpOffset = 0;
+	usedParticles = 0;
+}
+
+int ParticleSpanAllocator::GetSpanSize(int count)
+{
+	return minSpan << ClassOf(count);
+}
+
+int ParticleSpanAllocator::GetCapacity()
+{
+	return capacity;
+}
+
+int ParticleSpanAllocator::GetUsedParticles()
+{
+	return usedParticles;
+}
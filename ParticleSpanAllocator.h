@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+// --------------------------------------------------------
+// Hands out spans of a fixed-size particle store
+//
+// Span sizes are rounded up to a power of two (a size class)
+// and freed spans go on a per-class free list.  Fresh space is
+// carved off the end of the store, and a bigger free span is
+// split when a class runs dry.  Every span starts on a multiple
+// of its own size, so a freed span merges with its free buddy
+// (the other half of the span it was split from) back into the
+// bigger class.  Nothing here touches the GPU.
+// --------------------------------------------------------
+class ParticleSpanAllocator
+{
+	static const int maxClasses = 24;
+
+	int capacity;
+	int minSpan;
+	int classCount;
+	int bumpOffset;	// Everything past this has never been handed out
+	int usedParticles;
+	std::vector<int> freeSpans[maxClasses];
+
+	// Per minSpan sized block - the class of the free span starting there
+	// (or -1), and where it sits in that class's free list
+	std::vector<signed char> freeClassAt;
+	std::vector<int> freeListIndex;
+
+	int ClassOf(int count);
+	void PushFree(int offset, int sizeClass);
+	void RemoveFree(int offset);
+public:
+	ParticleSpanAllocator(int capacity, int minSpan = 16);
+
+	// Returns the offset of a span with room for at least count
+	// particles, or -1 if the store is full
+	int Allocate(int count);
+	void Free(int offset, int count);
+	void Clear();
+
+	// The size Allocate actually reserves for a request
+	int GetSpanSize(int count);
+
+	// Stats
+	int GetCapacity();
+	int GetUsedParticles();
+};
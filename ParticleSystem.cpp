@@ -0,0 +1,739 @@
+#include "ParticleSystem.h"
+
+using namespace DirectX;
+
+ParticleSystem::ParticleSystem(int capacity, int maxEmitters, unsigned long long seed, bool isSpriteSheet, unsigned int spriteSheetWidth, unsigned int spriteSheetHeight)
+	: allocator(capacity), emitterSeeds(seed, 2), budget(capacity, maxEmitters)
+{
+	this->maxEmitters = maxEmitters;
+	emitters.reserve(maxEmitters);
+
+	// Emitters only ever read the living part of their span, so the starting ages don't matter
+	ParticleKernels::Allocate(&particles, capacity, 0.0f);
+	vertices = new ParticleVertex[4 * capacity];
+	packedParticles = 0;
+	packed = false;
+	vertexParticleCount = 0;
+	uploadedBytes = 0;
+
+	// Sorting scratch space is only allocated if sorting is turned on
+	sorted = false;
+	culledEmitters = 0;
+	cameraForward = XMFLOAT3(0, 0, 1);
+	drawOrder.reserve(maxEmitters);
+	emitterDepths.resize(maxEmitters, 0.0f);
+	depths = 0;
+	sortKeys = 0;
+	sortKeyScratch = 0;
+	sortOrder = 0;
+	sortOrderScratch = 0;
+
+	// Enough for every emitter to wrap plus the largest emitters being chunked
+	workers = 0;
+	stepTime = 0;
+	jobs.reserve(maxEmitters * 2 + capacity / maxJobParticles + 1);
+	batches.reserve(maxEmitters * 2 + capacity / maxJobParticles + 1);
+	emitterDeaths.resize(maxEmitters, 0);
+	emitterActive.resize(maxEmitters, false);
+	emitterDropped.resize(maxEmitters, false);
+
+	// Precompute where every frame of the sprite sheet starts.  A plain
+	// texture is just a sheet with one frame covering the whole thing.
+	sheetWidth = isSpriteSheet && spriteSheetWidth > 1 ? spriteSheetWidth : 1;
+	int sheetHeight = isSpriteSheet && spriteSheetHeight > 1 ? spriteSheetHeight : 1;
+	frameCount = sheetWidth * sheetHeight;
+	frameSize = XMFLOAT2(1.0f / sheetWidth, 1.0f / sheetHeight);
+	frames = new XMFLOAT2[frameCount];
+	for (int i = 0; i < frameCount; i++)
+	{
+		// Column & row index across the sprite sheet
+		int uIndex = i % sheetWidth;
+		int vIndex = i / sheetWidth; // Integer division is important here!
+		frames[i] = XMFLOAT2(uIndex * frameSize.x, vIndex * frameSize.y);
+	}
+
+	vertexBuffer = 0;
+	packedBuffer = 0;
+	packedView = 0;
+	indexBuffer = 0;
+	sortedIndexBuffer = 0;
+	indexFormat = DXGI_FORMAT_R32_UINT;
+	texture = 0;
+	vs = 0;
+	ps = 0;
+}
+
+ParticleSystem::~ParticleSystem()
+{
+	ParticleKernels::Free(&particles);
+	delete[] vertices;
+	delete[] packedParticles;
+	delete[] frames;
+	delete[] depths;
+	delete[] sortKeys;
+	delete[] sortKeyScratch;
+	delete[] sortOrder;
+	delete[] sortOrderScratch;
+	if (vertexBuffer) vertexBuffer->Release();
+	if (packedBuffer) packedBuffer->Release();
+	if (packedView) packedView->Release();
+	if (indexBuffer) indexBuffer->Release();
+	if (sortedIndexBuffer) sortedIndexBuffer->Release();
+}
+
+void ParticleSystem::SetWorkerPool(WorkerPool* workers)
+{
+	this->workers = workers;
+}
+
+void ParticleSystem::SetSorted(bool sorted)
+{
+	this->sorted = sorted;
+	if (sorted && !depths)
+	{
+		int capacity = allocator.GetCapacity();
+		depths = new float[capacity];
+		sortKeys = new unsigned short[capacity];
+		sortKeyScratch = new unsigned short[capacity];
+		sortOrder = new unsigned int[capacity];
+		sortOrderScratch = new unsigned int[capacity];
+	}
+}
+
+bool ParticleSystem::IsSorted()
+{
+	return sorted;
+}
+
+void ParticleSystem::SetPacked(bool packed)
+{
+	this->packed = packed;
+
+	// Only one of the two is ever filled
+	int capacity = allocator.GetCapacity();
+	if (packed && !packedParticles)
+	{
+		packedParticles = new PackedParticle[capacity];
+		delete[] vertices;
+		vertices = 0;
+	}
+	else if (!packed && !vertices)
+	{
+		vertices = new ParticleVertex[4 * capacity];
+		delete[] packedParticles;
+		packedParticles = 0;
+	}
+}
+
+bool ParticleSystem::IsPacked()
+{
+	return packed;
+}
+
+// --------------------------------------------------------
+// Writes a range of particles to their place in the upload
+// (particle index output), in whichever format is in use
+// --------------------------------------------------------
+void ParticleSystem::ExpandParticles(const BillboardParams& params, const ParticleArrays& arrays, int first, int count, int output)
+{
+	if (packed)
+		ParticlePacking::Pack(params, arrays, first, count, packedParticles + output);
+	else
+		ParticleKernels::ExpandBillboards(params, arrays, first, count, vertices + output * 4);
+}
+
+// --------------------------------------------------------
+// Splits an emitter's living particles into jobs of at most
+// maxJobParticles, writing their quads from output onwards
+// --------------------------------------------------------
+void ParticleSystem::AddJobs(int emitter, int output)
+{
+	int firsts[2], counts[2];
+	int rangeCount = emitters[emitter].GetLivingRanges(firsts, counts);
+	for (int r = 0; r < rangeCount; r++)
+	{
+		for (int offset = 0; offset < counts[r]; offset += maxJobParticles)
+		{
+			ParticleJob job;
+			job.Emitter = emitter;
+			job.First = firsts[r] + offset;
+			job.Count = counts[r] - offset < maxJobParticles ? counts[r] - offset : maxJobParticles;
+			job.Output = output;
+			job.Deaths = 0;
+			jobs.push_back(job);
+			output += job.Count;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Groups consecutive jobs into batches and runs them, across
+// the worker pool if there is one
+// --------------------------------------------------------
+void ParticleSystem::RunBatches(WorkerPool::Task task)
+{
+	batches.clear();
+	int batchParticles = 0;
+	for (int j = 0; j < (int)jobs.size(); j++)
+	{
+		if (batches.empty() || batchParticles >= minBatchParticles)
+		{
+			ParticleBatch batch = { j, 0 };
+			batches.push_back(batch);
+			batchParticles = 0;
+		}
+		batches.back().JobCount++;
+		batchParticles += jobs[j].Count;
+	}
+
+	if (workers)
+		workers->ParallelFor((int)batches.size(), task, this);
+	else
+	{
+		for (int b = 0; b < (int)batches.size(); b++)
+			task(this, b);
+	}
+}
+
+void ParticleSystem::UpdateBatch(void* context, int index)
+{
+	ParticleSystem* system = (ParticleSystem*)context;
+	ParticleBatch batch = system->batches[index];
+	for (int j = batch.FirstJob; j < batch.FirstJob + batch.JobCount; j++)
+	{
+		ParticleJob& job = system->jobs[j];
+		Emitter& emitter = system->emitters[job.Emitter];
+		ParticleUpdateParams params = emitter.GetUpdateParams(system->stepTime);
+		if (emitter.IsCulled())
+			job.Deaths = ParticleKernels::UpdateAges(params, system->particles, job.First, job.Count);
+		else
+			job.Deaths = ParticleKernels::Update(params, system->particles, job.First, job.Count);
+	}
+}
+
+void ParticleSystem::ExpandBatch(void* context, int index)
+{
+	ParticleSystem* system = (ParticleSystem*)context;
+	ParticleBatch batch = system->batches[index];
+	BillboardParams params = system->billboardParams;
+	for (int j = batch.FirstJob; j < batch.FirstJob + batch.JobCount; j++)
+	{
+		const ParticleJob& job = system->jobs[j];
+		Emitter& emitter = system->emitters[job.Emitter];
+		params.Lifetime = emitter.GetLifetime();
+		params.Features = system->billboardParams.Features | emitter.GetFeatures();
+		if (!emitter.IsAnalytic())
+		{
+			// Only aged while it was off screen - catch everything else up first
+			if (emitter.IsStale())
+				ParticleKernels::Update(emitter.GetUpdateParams(0.0f), system->particles, job.First, job.Count);
+
+			system->ExpandParticles(params, system->particles, job.First, job.Count, job.Output);
+			if (system->sorted)
+				ParticleKernels::ViewDepths(system->cameraForward, system->particles, job.First, job.Count, system->depths + job.Output);
+			continue;
+		}
+
+		// Analytic particles are evaluated a block at a time into scratch space
+		// that stays in cache, then expanded from there
+		float age[analyticBlock], x[analyticBlock], y[analyticBlock], z[analyticBlock], size[analyticBlock];
+		float rotation[analyticBlock], r[analyticBlock], g[analyticBlock], b[analyticBlock], a[analyticBlock];
+		ParticleArrays state = {};
+		state.Age = age; state.X = x; state.Y = y; state.Z = z; state.Size = size;
+		state.Rotation = rotation; state.R = r; state.G = g; state.B = b; state.A = a;
+
+		ParticleUpdateParams updateParams = emitter.GetUpdateParams(0.0f);
+		float time = emitter.GetTime();
+		for (int offset = 0; offset < job.Count; offset += analyticBlock)
+		{
+			int count = job.Count - offset < analyticBlock ? job.Count - offset : analyticBlock;
+			int output = job.Output + offset;
+			ParticleKernels::Evaluate(updateParams, time, system->particles, job.First + offset, count, &state);
+			system->ExpandParticles(params, state, 0, count, output);
+			if (system->sorted)
+				ParticleKernels::ViewDepths(system->cameraForward, state, 0, count, system->depths + output);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Frustum planes straight from the view-projection matrix.
+// The camera keeps both matrices transposed, so projection *
+// view here is the transpose of the usual view * projection,
+// and its rows are the columns the planes are built from.
+// --------------------------------------------------------
+static void GetFrustumPlanes(const XMFLOAT4X4& view, const XMFLOAT4X4& projection, XMFLOAT4* planes)
+{
+	float rows[4][4];
+	for (int r = 0; r < 4; r++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			rows[r][c] = 0.0f;
+			for (int k = 0; k < 4; k++)
+				rows[r][c] += projection.m[r][k] * view.m[k][c];
+		}
+	}
+
+	// Left, right, bottom, top, near (depth starts at 0 in D3D), far
+	for (int c = 0; c < 4; c++)
+	{
+		(&planes[0].x)[c] = rows[3][c] + rows[0][c];
+		(&planes[1].x)[c] = rows[3][c] - rows[0][c];
+		(&planes[2].x)[c] = rows[3][c] + rows[1][c];
+		(&planes[3].x)[c] = rows[3][c] - rows[1][c];
+		(&planes[4].x)[c] = rows[2][c];
+		(&planes[5].x)[c] = rows[3][c] - rows[2][c];
+	}
+}
+
+// A box is outside if its corner farthest along a plane's normal is still behind it
+static bool IsBoxOutside(const XMFLOAT4* planes, XMFLOAT3 min, XMFLOAT3 max)
+{
+	for (int p = 0; p < 6; p++)
+	{
+		const XMFLOAT4& plane = planes[p];
+		float x = plane.x >= 0.0f ? max.x : min.x;
+		float y = plane.y >= 0.0f ? max.y : min.y;
+		float z = plane.z >= 0.0f ? max.z : min.z;
+		if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f)
+			return true;
+	}
+	return false;
+}
+
+void ParticleSystem::CullEmitters(const XMFLOAT4X4& view, const XMFLOAT4X4& projection)
+{
+	XMFLOAT4 planes[6];
+	GetFrustumPlanes(view, projection, planes);
+
+	culledEmitters = 0;
+	for (int i = 0; i < (int)emitters.size(); i++)
+	{
+		XMFLOAT3 min, max;
+		emitters[i].GetBounds(&min, &max);
+		bool culled = IsBoxOutside(planes, min, max);
+		emitters[i].SetCulled(culled);
+		if (culled)
+			culledEmitters++;
+	}
+}
+
+// --------------------------------------------------------
+// Coarse sort - orders emitters farthest first by where they
+// are, so particles with the same (quantized) depth still come
+// out roughly back to front.  There are only ever a few dozen
+// emitters, so an insertion sort is plenty.
+// --------------------------------------------------------
+void ParticleSystem::SortEmitters()
+{
+	drawOrder.clear();
+	for (int i = 0; i < (int)emitters.size(); i++)
+	{
+		XMFLOAT3 position = emitters[i].GetPosition();
+		emitterDepths[i] = position.x * cameraForward.x + position.y * cameraForward.y + position.z * cameraForward.z;
+
+		int slot = (int)drawOrder.size();
+		drawOrder.push_back(i);
+		while (slot > 0 && emitterDepths[drawOrder[slot - 1]] < emitterDepths[i])
+		{
+			drawOrder[slot] = drawOrder[slot - 1];
+			slot--;
+		}
+		drawOrder[slot] = i;
+	}
+}
+
+// --------------------------------------------------------
+// Six indices per quad, in sorted order, as whatever index
+// format the buffers were created with
+// --------------------------------------------------------
+void ParticleSystem::WriteSortedIndices(void* indices)
+{
+	if (indexFormat == DXGI_FORMAT_R16_UINT)
+	{
+		unsigned short* out = (unsigned short*)indices;
+		for (int i = 0; i < vertexParticleCount; i++, out += 6)
+		{
+			unsigned short v = (unsigned short)(sortOrder[i] * 4);
+			out[0] = v; out[1] = v + 1; out[2] = v + 2;
+			out[3] = v; out[4] = v + 2; out[5] = v + 3;
+		}
+	}
+	else
+	{
+		unsigned int* out = (unsigned int*)indices;
+		for (int i = 0; i < vertexParticleCount; i++, out += 6)
+		{
+			unsigned int v = sortOrder[i] * 4;
+			out[0] = v; out[1] = v + 1; out[2] = v + 2;
+			out[3] = v; out[4] = v + 2; out[5] = v + 3;
+		}
+	}
+}
+
+bool ParticleSystem::SpawnEmitter(const EmitterSettings* settings, XMFLOAT3 position, float startTime)
+{
+	// Nothing to emit (e.g. the effect file didn't load)
+	if (settings->MaxParticles <= 0)
+		return false;
+
+	float visibility = budget.GetVisibility(position, Emitter::CalculateBoundingRadius(settings), settings->Importance);
+
+	// Make room by retiring the least visible emitters, but only ones less visible than this
+	int offset = -1;
+	while (true)
+	{
+		if ((int)emitters.size() < maxEmitters)
+		{
+			offset = allocator.Allocate(settings->MaxParticles);
+			if (offset >= 0)
+				break;
+		}
+
+		int leastVisible = -1;
+		for (int i = 0; i < (int)emitters.size(); i++)
+		{
+			if (leastVisible < 0 || emitters[i].GetVisibility() < emitters[leastVisible].GetVisibility())
+				leastVisible = i;
+		}
+
+		if (leastVisible < 0 || emitters[leastVisible].GetVisibility() >= visibility)
+		{
+			budget.CountRejection();
+			return false;
+		}
+
+		RetireEmitter(leastVisible);
+		budget.CountEviction();
+	}
+
+	emitters.push_back(Emitter(settings, position, offset, allocator.GetSpanSize(settings->MaxParticles), emitterSeeds.NextUInt64()));
+	emitters.back().SetVisibility(visibility);
+	emitters.back().Start(particles);
+	if (startTime > 0.0f)
+		emitters.back().FastForward(startTime, particles);
+	return true;
+}
+
+// --------------------------------------------------------
+// Hands the span back and swaps the last emitter in
+// --------------------------------------------------------
+void ParticleSystem::RetireEmitter(int index)
+{
+	allocator.Free(emitters[index].GetSpanOffset(), emitters[index].GetSpanSize());
+	emitters[index] = emitters.back();
+	emitters.pop_back();
+}
+
+void ParticleSystem::SetParticleBudget(int maxParticles)
+{
+	budget.SetMaxParticles(maxParticles);
+}
+
+void ParticleSystem::ApplyBudget(Camera* camera)
+{
+	budget.SetView(camera->GetViewMatrix(), camera->GetProjectionMatrix());
+	budget.Apply(emitters, emitterDropped);
+
+	// Backwards, so the emitter swapped into a retired slot has already been checked
+	for (int i = (int)emitters.size() - 1; i >= 0; i--)
+	{
+		if (emitterDropped[i])
+			RetireEmitter(i);
+	}
+}
+
+const ParticleBudgetStats& ParticleSystem::GetBudgetStats()
+{
+	return budget.GetStats();
+}
+
+void ParticleSystem::Update(float dt)
+{
+	// Count down every emitter and gather the particles that need simulating
+	stepTime = dt;
+	jobs.clear();
+	for (int i = 0; i < (int)emitters.size(); i++)
+	{
+		emitterActive[i] = emitters[i].BeginUpdate(dt);
+		emitterDeaths[i] = 0;
+		if (emitterActive[i] && !emitters[i].IsAnalytic())
+		{
+			AddJobs(i, 0);
+			emitters[i].SetStale(emitters[i].IsCulled());
+		}
+	}
+
+	// Run the kernels, possibly on other threads
+	RunBatches(UpdateBatch);
+
+	// Merge - deaths are summed per emitter, then spawning happens in
+	// emitter order on this thread so spawning never races the kernels
+	for (size_t j = 0; j < jobs.size(); j++)
+		emitterDeaths[jobs[j].Emitter] += jobs[j].Deaths;
+
+	for (int i = 0; i < (int)emitters.size(); i++)
+	{
+		if (emitterActive[i])
+			emitters[i].FinishUpdate(dt, emitterDeaths[i], particles);
+	}
+
+	// Retire expired emitters
+	for (int i = 0; i < (int)emitters.size(); i++)
+	{
+		if (emitters[i].GetTotalTime() < 0.0f)
+		{
+			RetireEmitter(i);
+			i--;
+		}
+	}
+}
+
+int ParticleSystem::BuildVertices(XMFLOAT3 cameraRight, XMFLOAT3 cameraUp, XMFLOAT3 cameraForward)
+{
+	this->cameraForward = cameraForward;
+	billboardParams.CameraRight = cameraRight;
+	billboardParams.CameraUp = cameraUp;
+	billboardParams.Lifetime = 1.0f;	// Each emitter fills in its own
+	billboardParams.Frames = frames;
+	billboardParams.FrameCount = frameCount;
+	billboardParams.FrameSize = frameSize;
+	billboardParams.Features = frameCount > 1 ? particleFeatureSpriteSheet : 0;
+
+	// Every emitter's quads go right after the previous emitter's,
+	// farthest emitter first when sorting
+	if (sorted)
+		SortEmitters();
+
+	jobs.clear();
+	vertexParticleCount = 0;
+	for (int i = 0; i < (int)emitters.size(); i++)
+	{
+		int emitter = sorted ? drawOrder[i] : i;
+		if (emitters[emitter].IsCulled())
+			continue;
+		AddJobs(emitter, vertexParticleCount);
+		vertexParticleCount += emitters[emitter].GetLivingCount();
+	}
+
+	RunBatches(ExpandBatch);
+
+	// Everything visible was caught up while it was expanded
+	for (int i = 0; i < (int)emitters.size(); i++)
+	{
+		if (!emitters[i].IsCulled())
+			emitters[i].SetStale(false);
+	}
+
+	// Fine sort - every particle on its own depth.  The radix sort is
+	// stable, so ties keep the emitter order from above.
+	if (sorted)
+	{
+		ParticleKernels::DepthKeys(depths, vertexParticleCount, sortKeys);
+		for (int i = 0; i < vertexParticleCount; i++)
+			sortOrder[i] = i;
+		ParticleKernels::RadixSort(sortKeys, sortOrder, sortKeyScratch, sortOrderScratch, vertexParticleCount);
+	}
+
+	return vertexParticleCount;
+}
+
+const ParticleVertex* ParticleSystem::GetVertices()
+{
+	return vertices;
+}
+
+const PackedParticle* ParticleSystem::GetPackedParticles()
+{
+	return packedParticles;
+}
+
+const unsigned int* ParticleSystem::GetSortOrder()
+{
+	return sortOrder;
+}
+
+void ParticleSystem::CreateBuffers(ID3D11Device* device, SimpleVertexShader* vs, SimplePixelShader* ps, ID3D11ShaderResourceView* texture)
+{
+	this->vs = vs;
+	this->ps = ps;
+	this->texture = texture;
+
+	int capacity = allocator.GetCapacity();
+
+	if (packed)
+	{
+		// DYNAMIC structured buffer the vertex shader reads particles from
+		D3D11_BUFFER_DESC pbDesc = {};
+		pbDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		pbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		pbDesc.Usage = D3D11_USAGE_DYNAMIC;
+		pbDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		pbDesc.StructureByteStride = sizeof(PackedParticle);
+		pbDesc.ByteWidth = sizeof(PackedParticle) * capacity;
+		device->CreateBuffer(&pbDesc, 0, &packedBuffer);
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.FirstElement = 0;
+		srvDesc.Buffer.NumElements = capacity;
+		device->CreateShaderResourceView(packedBuffer, &srvDesc, &packedView);
+	}
+	else
+	{
+		// DYNAMIC vertex buffer (no initial data necessary)
+		D3D11_BUFFER_DESC vbDesc = {};
+		vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		vbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		vbDesc.Usage = D3D11_USAGE_DYNAMIC;
+		vbDesc.ByteWidth = sizeof(ParticleVertex) * 4 * capacity;
+		device->CreateBuffer(&vbDesc, 0, &vertexBuffer);
+	}
+
+	// Index buffer data - 16 bit indices whenever every vertex fits.  The
+	// packed vertex shader reads these as particle * 4 + corner, so the
+	// same indices work for both formats.
+	bool shortIndices = capacity * 4 <= 65536;
+	int indexSize = shortIndices ? sizeof(unsigned short) : sizeof(unsigned int);
+	indexFormat = shortIndices ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+	unsigned char* indices = new unsigned char[capacity * 6 * indexSize];
+	unsigned short* shortData = (unsigned short*)indices;
+	unsigned int* intData = (unsigned int*)indices;
+	int indexCount = 0;
+	for (int i = 0; i < capacity * 4; i += 4)
+	{
+		unsigned int quad[6] = { (unsigned int)i, (unsigned int)i + 1, (unsigned int)i + 2, (unsigned int)i, (unsigned int)i + 2, (unsigned int)i + 3 };
+		for (int q = 0; q < 6; q++)
+		{
+			if (shortIndices)
+				shortData[indexCount++] = (unsigned short)quad[q];
+			else
+				intData[indexCount++] = quad[q];
+		}
+	}
+	D3D11_SUBRESOURCE_DATA indexData = {};
+	indexData.pSysMem = indices;
+
+	// Regular (static) index buffer
+	D3D11_BUFFER_DESC ibDesc = {};
+	ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	ibDesc.CPUAccessFlags = 0;
+	ibDesc.Usage = D3D11_USAGE_DEFAULT;
+	ibDesc.ByteWidth = indexSize * capacity * 6;
+	device->CreateBuffer(&ibDesc, &indexData, &indexBuffer);
+
+	// Same size again, but DYNAMIC, for drawing in sorted order
+	ibDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	ibDesc.Usage = D3D11_USAGE_DYNAMIC;
+	device->CreateBuffer(&ibDesc, 0, &sortedIndexBuffer);
+
+	delete[] indices;
+}
+
+void ParticleSystem::Draw(ID3D11DeviceContext* context, Camera* camera)
+{
+	// Get the right, up and forward vectors out of the view matrix once for the whole draw
+	// (Remember that it is probably already transposed)
+	XMFLOAT4X4 view = camera->GetViewMatrix();
+	CullEmitters(view, camera->GetProjectionMatrix());
+	int particleCount = BuildVertices(
+		XMFLOAT3(view._11, view._12, view._13),
+		XMFLOAT3(view._21, view._22, view._23),
+		XMFLOAT3(view._31, view._32, view._33));
+
+	// Nothing to draw (or upload)
+	uploadedBytes = 0;
+	if (particleCount == 0)
+		return;
+
+	// Copy only the particles that were built
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (packed)
+	{
+		uploadedBytes = ParticlePacking::GetUploadSize(particleCount);
+		context->Map(packedBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+		memcpy(mapped.pData, packedParticles, uploadedBytes);
+		context->Unmap(packedBuffer, 0);
+	}
+	else
+	{
+		uploadedBytes = sizeof(ParticleVertex) * 4 * particleCount;
+		context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+		memcpy(mapped.pData, vertices, uploadedBytes);
+		context->Unmap(vertexBuffer, 0);
+	}
+
+	// Sorted mode draws through indices rewritten in back to front order
+	ID3D11Buffer* drawIndices = indexBuffer;
+	if (sorted)
+	{
+		context->Map(sortedIndexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+		WriteSortedIndices(mapped.pData);
+		context->Unmap(sortedIndexBuffer, 0);
+		drawIndices = sortedIndexBuffer;
+		uploadedBytes += particleCount * 6 * (indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(unsigned short) : sizeof(unsigned int));
+	}
+
+	// Set up buffers - packed particles come from the structured buffer instead
+	UINT stride = packed ? 0 : sizeof(ParticleVertex);
+	UINT offset = 0;
+	ID3D11Buffer* drawVertices = packed ? 0 : vertexBuffer;
+	context->IASetVertexBuffers(0, 1, &drawVertices, &stride, &offset);
+	context->IASetIndexBuffer(drawIndices, indexFormat, 0);
+
+	vs->SetMatrix4x4("view", camera->GetViewMatrix());
+	vs->SetMatrix4x4("projection", camera->GetProjectionMatrix());
+	if (packed)
+	{
+		vs->SetFloat3("cameraRight", billboardParams.CameraRight);
+		vs->SetFloat3("cameraUp", billboardParams.CameraUp);
+		vs->SetFloat2("frameSize", frameSize);
+		vs->SetInt("sheetWidth", sheetWidth);
+		vs->SetShaderResourceView("particles", packedView);
+	}
+	vs->SetShader();
+	vs->CopyAllBufferData();
+
+	ps->SetShaderResourceView("particle", texture);
+
+	ps->SetShader();
+
+	// Every emitter in one draw
+	context->DrawIndexed(particleCount * 6, 0, 0);
+}
+
+int ParticleSystem::GetEmitterCount()
+{
+	return (int)emitters.size();
+}
+
+int ParticleSystem::GetCulledEmitterCount()
+{
+	return culledEmitters;
+}
+
+int ParticleSystem::GetLivingParticleCount()
+{
+	int count = 0;
+	for (size_t i = 0; i < emitters.size(); i++)
+		count += emitters[i].GetLivingCount();
+	return count;
+}
+
+int ParticleSystem::GetCapacity()
+{
+	return allocator.GetCapacity();
+}
+
+int ParticleSystem::GetUsedParticles()
+{
+	return allocator.GetUsedParticles();
+}
+
+int ParticleSystem::GetUploadedBytes()
+{
+	return uploadedBytes;
+}
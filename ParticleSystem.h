@@ -0,0 +1,209 @@
+#pragma once
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include <vector>
+
+#include "Camera.h"
+#include "SimpleShader.h"
+#include "Emitter.h"
+#include "ParticleKernels.h"
+#include "ParticlePacking.h"
+#include "ParticleSpanAllocator.h"
+#include "ParticleBudget.h"
+#include "WorkerPool.h"
+
+// --------------------------------------------------------
+// Owns every particle in the game
+//
+// All emitters share one particle store (each gets a span of
+// it) and one set of GPU buffers, so starting an effect never
+// allocates or calls the device, and everything using the same
+// texture draws in one call.
+//
+// The simulation side (SpawnEmitter, Update, BuildVertices) has
+// no device dependency; CreateBuffers and Draw are the only GPU
+// parts.
+//
+// With a WorkerPool, the particle kernels and billboard expansion
+// are split into jobs: big emitters are chunked, small ones are
+// batched together.  Spawning and retiring stay on the calling
+// thread, and every emitter gets its own random stream seeded from
+// the system's seed, so the results don't depend on how many
+// threads there are.
+//
+// Additive particles can be drawn in any order.  For alpha
+// blended ones, SetSorted turns on back to front drawing:
+// emitters are laid out farthest first, then every particle is
+// radix sorted on its view depth and drawn through a dynamic
+// index buffer in that order.
+//
+// A ParticleBudget caps how many particles can be alive at once.
+// ApplyBudget throttles emitters by how visible they are, and when
+// the system is full a new emitter replaces the least visible one
+// (if it's more visible itself).
+//
+// Analytic emitters skip the update pass entirely - their
+// particles are evaluated from their spawn values while the
+// quads are built.
+//
+// Emitters whose bounds are outside the camera's frustum aren't
+// expanded, uploaded or drawn, and their next update only ages
+// their particles.  If they come back into view, their particles
+// are re-evaluated at their current age before being drawn.
+//
+// SetPacked switches the upload from four ParticleVertex corners
+// per particle (144 bytes) to one PackedParticle (24 bytes) in a
+// structured buffer, and ParticleVS.hlsl builds the corners from
+// SV_VertexID.  The unpacked corners are drawn with ParticleQuadVS.
+// --------------------------------------------------------
+class ParticleSystem
+{
+	// A range of one emitter's particles, and where its quads go
+	struct ParticleJob
+	{
+		int Emitter;
+		int First;
+		int Count;
+		int Output;		// Particle index in the vertex array
+		int Deaths;
+	};
+
+	// A run of consecutive jobs handed to one thread
+	struct ParticleBatch
+	{
+		int FirstJob;
+		int JobCount;
+	};
+
+	static const int maxJobParticles = 1024;	// Bigger ranges are split
+	static const int minBatchParticles = 1024;	// Smaller jobs are grouped until they reach this
+	static const int analyticBlock = 64;		// Analytic particles evaluated at once, on the stack
+
+	ParticleArrays particles;
+	ParticleSpanAllocator allocator;
+	std::vector<Emitter> emitters;
+	int maxEmitters;
+	Random emitterSeeds;	// Hands each new emitter the seed for its stream
+
+	ParticleBudget budget;
+	std::vector<bool> emitterDropped;
+	void RetireEmitter(int index);
+
+	// Sprite sheet frames - the whole texture when it isn't a sprite sheet
+	DirectX::XMFLOAT2* frames;
+	int frameCount;
+	int sheetWidth;
+	DirectX::XMFLOAT2 frameSize;
+
+	// Quads (or packed particles) for every visible particle, back to back
+	ParticleVertex* vertices;
+	PackedParticle* packedParticles;
+	bool packed;
+	int vertexParticleCount;
+	int uploadedBytes;
+	void ExpandParticles(const BillboardParams& params, const ParticleArrays& arrays, int first, int count, int output);
+
+	// Sorting - emitters in draw order, then per particle depths, keys
+	// and the sorted particle order (plus scratch space for the sort)
+	bool sorted;
+	DirectX::XMFLOAT3 cameraForward;
+	std::vector<int> drawOrder;
+	std::vector<float> emitterDepths;
+	float* depths;
+	unsigned short* sortKeys;
+	unsigned short* sortKeyScratch;
+	unsigned int* sortOrder;
+	unsigned int* sortOrderScratch;
+
+	int culledEmitters;
+
+	void SortEmitters();
+	void WriteSortedIndices(void* indices);
+
+	// Threading
+	WorkerPool* workers;
+	std::vector<ParticleJob> jobs;
+	std::vector<ParticleBatch> batches;
+	std::vector<int> emitterDeaths;
+	std::vector<bool> emitterActive;
+	float stepTime;
+	BillboardParams billboardParams;
+
+	void AddJobs(int emitter, int output);
+	void RunBatches(WorkerPool::Task task);
+	static void UpdateBatch(void* context, int index);
+	static void ExpandBatch(void* context, int index);
+
+	// Rendering
+	ID3D11Buffer* vertexBuffer;
+	ID3D11Buffer* packedBuffer;				// Structured buffer in packed mode, instead of vertexBuffer
+	ID3D11ShaderResourceView* packedView;
+	ID3D11Buffer* indexBuffer;
+	ID3D11Buffer* sortedIndexBuffer;	// Rewritten every frame in sorted mode
+	DXGI_FORMAT indexFormat;
+	ID3D11ShaderResourceView* texture;
+	SimpleVertexShader* vs;
+	SimplePixelShader* ps;
+public:
+	ParticleSystem(int capacity, int maxEmitters, unsigned long long seed, bool isSpriteSheet = false, unsigned int spriteSheetWidth = 1, unsigned int spriteSheetHeight = 1);
+	~ParticleSystem();
+
+	ParticleSystem(const ParticleSystem&) = delete;
+	ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+	// Null runs everything on the calling thread
+	void SetWorkerPool(WorkerPool* workers);
+
+	// Back to front drawing for alpha blended effects, off by default
+	void SetSorted(bool sorted);
+	bool IsSorted();
+
+	// One PackedParticle per particle instead of four ParticleVertex corners,
+	// off by default.  Call before CreateBuffers, and draw with ParticleVS
+	// when packed or ParticleQuadVS when not.
+	void SetPacked(bool packed);
+	bool IsPacked();
+
+	// Starts an effect, startTime seconds in (to prewarm it).  When the system is
+	// full, the least visible emitter makes room if it's less visible than the
+	// new one - otherwise this returns false.
+	bool SpawnEmitter(const EmitterSettings* settings, DirectX::XMFLOAT3 position, float startTime = 0.0f);
+
+	// Most particles allowed alive at once (defaults to the capacity)
+	void SetParticleBudget(int maxParticles);
+
+	// Re-weighs every emitter from the camera's point of view and throttles or
+	// drops them to fit the budget.  Call before Update.
+	void ApplyBudget(Camera* camera);
+	const ParticleBudgetStats& GetBudgetStats();
+
+	// Updates every emitter and retires the ones that have finished
+	void Update(float dt);
+
+	// Flags every emitter whose bounds are outside the camera's view, so
+	// BuildVertices skips it and the next Update only ages its particles
+	void CullEmitters(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection);
+
+	// Expands every visible particle into the vertex array (or packs it, in packed
+	// mode), returns the particle count.  In sorted mode this also sorts them along
+	// cameraForward.
+	int BuildVertices(DirectX::XMFLOAT3 cameraRight, DirectX::XMFLOAT3 cameraUp, DirectX::XMFLOAT3 cameraForward);
+	const ParticleVertex* GetVertices();				// Null in packed mode
+	const PackedParticle* GetPackedParticles();		// Null unless packed
+
+	// Quads in back to front order, valid after BuildVertices in sorted mode
+	const unsigned int* GetSortOrder();
+
+	// GPU side
+	void CreateBuffers(ID3D11Device* device, SimpleVertexShader* vs, SimplePixelShader* ps, ID3D11ShaderResourceView* texture);
+	void Draw(ID3D11DeviceContext* context, Camera* camera);
+
+	// Stats
+	int GetEmitterCount();
+	int GetCulledEmitterCount();
+	int GetLivingParticleCount();
+	int GetCapacity();
+	int GetUsedParticles();
+	int GetUploadedBytes();		// Particles and sorted indices sent to the GPU by the last Draw
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "ParticleKernels.h"
+
+// --------------------------------------------------------
+// The wide particle update, written once for any vector width
+//
+// Ops wraps one instruction set (see ParticleKernels.cpp for
+// SSE and ParticleKernelsAVX2.cpp for AVX2), and each feature an
+// effect can leave out is a template parameter, so every
+// instantiation only contains the work its effects need:
+//  - Rotation: off when every particle's rotation is fixed at spawn
+//  - Acceleration: off for effects with no acceleration
+//  - ColorOverLife: off when the color and alpha curves are flat
+//
+// Leaving a feature out never changes the results - the skipped
+// outputs already hold the values the full kernel would write
+// (see particleFeatureRotation in ParticleKernels.h).
+// Only include this from the file that instantiates it for its
+// instruction set.
+// --------------------------------------------------------
+template <class Ops, bool Rotation, bool Acceleration, bool ColorOverLife>
+int UpdateParticlesWide(const ParticleUpdateParams& params, const ParticleArrays& arrays, int first, int count)
+{
+	typedef typename Ops::Float Float;
+	typedef typename Ops::Int Int;
+	const ParticleCurves& curves = *params.Curves;
+
+	// Per-emitter constants, loaded once
+	Float dt = Ops::Set1(params.DeltaTime);
+	Float lifetime = Ops::Set1(params.Lifetime);
+	Float curveScale = Ops::Set1((particleCurveResolution - 1) / params.Lifetime);
+	Float lastEntry = Ops::Set1((float)(particleCurveResolution - 1));
+	Float accelX = Ops::Set1(params.Acceleration.x);
+	Float accelY = Ops::Set1(params.Acceleration.y);
+	Float accelZ = Ops::Set1(params.Acceleration.z);
+	Float half = Ops::Set1(0.5f);
+
+	int deaths = 0;
+	int end = first + count;
+	int i = first;
+	for (; i + Ops::Width <= end; i += Ops::Width)
+	{
+		Float age = Ops::Load(arrays.Age + i);
+		Float wasAlive = Ops::LessThan(age, lifetime);
+		Float t = Ops::Add(age, dt);
+		Ops::Store(arrays.Age + i, Ops::Select(wasAlive, t, age));
+
+		// Lanes that were alive and crossed the lifetime this step
+		int diedMask = Ops::MoveMask(Ops::And(wasAlive, Ops::GreaterEqual(t, lifetime)));
+		for (; diedMask; diedMask &= diedMask - 1)
+			deaths++;
+
+		// Nearest curve entries (clamped, dead lanes can be well past the end)
+		Int entries = Ops::ToInt(Ops::Min(Ops::Add(Ops::Mul(t, curveScale), half), lastEntry));
+
+		if (ColorOverLife)
+		{
+			Ops::Store(arrays.R + i, Ops::Gather(curves.R, entries));
+			Ops::Store(arrays.G + i, Ops::Gather(curves.G, entries));
+			Ops::Store(arrays.B + i, Ops::Gather(curves.B, entries));
+			Ops::Store(arrays.A + i, Ops::Gather(curves.A, entries));
+		}
+		Ops::Store(arrays.Size + i, Ops::Gather(curves.Size, entries));
+
+		if (Rotation)
+		{
+			Float rotStart = Ops::Load(arrays.RotationStart + i);
+			Float rotEnd = Ops::Load(arrays.RotationEnd + i);
+			Float rotProgress = Ops::Gather(curves.Rotation, entries);
+			Ops::Store(arrays.Rotation + i, Ops::Add(rotStart, Ops::Mul(rotProgress, Ops::Sub(rotEnd, rotStart))));
+		}
+
+		// a * t^2 / 2 + v * t + p, or just v * t + p
+		Float vtX = Ops::Mul(Ops::Load(arrays.VelocityX + i), t);
+		Float vtY = Ops::Mul(Ops::Load(arrays.VelocityY + i), t);
+		Float vtZ = Ops::Mul(Ops::Load(arrays.VelocityZ + i), t);
+		if (Acceleration)
+		{
+			Float halfT2 = Ops::Mul(Ops::Mul(t, t), half);
+			vtX = Ops::Add(Ops::Mul(accelX, halfT2), vtX);
+			vtY = Ops::Add(Ops::Mul(accelY, halfT2), vtY);
+			vtZ = Ops::Add(Ops::Mul(accelZ, halfT2), vtZ);
+		}
+		Ops::Store(arrays.X + i, Ops::Add(vtX, Ops::Load(arrays.StartX + i)));
+		Ops::Store(arrays.Y + i, Ops::Add(vtY, Ops::Load(arrays.StartY + i)));
+		Ops::Store(arrays.Z + i, Ops::Add(vtZ, Ops::Load(arrays.StartZ + i)));
+	}
+
+	// The last few can't be done as a group, since the slots past
+	// the end of the range may belong to living particles.  Same math
+	// as UpdateScalar, minus the features that are off.
+	float scalarScale = (particleCurveResolution - 1) / params.Lifetime;
+	float scalarLastEntry = (float)(particleCurveResolution - 1);
+	for (; i < end; i++)
+	{
+		if (arrays.Age[i] >= params.Lifetime)
+			continue;
+
+		float t = arrays.Age[i] + params.DeltaTime;
+		arrays.Age[i] = t;
+		if (t >= params.Lifetime)
+		{
+			deaths++;
+			continue;
+		}
+
+		float entry = t * scalarScale + 0.5f;
+		int c = (int)(entry < scalarLastEntry ? entry : scalarLastEntry);
+
+		if (ColorOverLife)
+		{
+			arrays.R[i] = curves.R[c];
+			arrays.G[i] = curves.G[c];
+			arrays.B[i] = curves.B[c];
+			arrays.A[i] = curves.A[c];
+		}
+		arrays.Size[i] = curves.Size[c];
+		if (Rotation)
+			arrays.Rotation[i] = arrays.RotationStart[i] + curves.Rotation[c] * (arrays.RotationEnd[i] - arrays.RotationStart[i]);
+
+		float vtX = arrays.VelocityX[i] * t;
+		float vtY = arrays.VelocityY[i] * t;
+		float vtZ = arrays.VelocityZ[i] * t;
+		if (Acceleration)
+		{
+			float halfT2 = t * t * 0.5f;
+			vtX = params.Acceleration.x * halfT2 + vtX;
+			vtY = params.Acceleration.y * halfT2 + vtY;
+			vtZ = params.Acceleration.z * halfT2 + vtZ;
+		}
+		arrays.X[i] = vtX + arrays.StartX[i];
+		arrays.Y[i] = vtY + arrays.StartY[i];
+		arrays.Z[i] = vtZ + arrays.StartZ[i];
+	}
+	return deaths;
+}
+
+// --------------------------------------------------------
+// Every combination of features, indexed by the
+// particleFeatureRotation / Acceleration / ColorOverLife bits
+// (see ParticleKernels.h)
+// --------------------------------------------------------
+template <class Ops>
+struct ParticleUpdateKernels
+{
+	static ParticleKernels::UpdateKernel Get(unsigned int features)
+	{
+		static const ParticleKernels::UpdateKernel kernels[8] =
+		{
+			UpdateParticlesWide<Ops, false, false, false>,
+			UpdateParticlesWide<Ops, true, false, false>,
+			UpdateParticlesWide<Ops, false, true, false>,
+			UpdateParticlesWide<Ops, true, true, false>,
+			UpdateParticlesWide<Ops, false, false, true>,
+			UpdateParticlesWide<Ops, true, false, true>,
+			UpdateParticlesWide<Ops, false, true, true>,
+			UpdateParticlesWide<Ops, true, true, true>,
+		};
+		return kernels[features & 7];
+	}
+};
@@ -4,16 +4,25 @@ cbuffer externalData : register(b0)
 {
     matrix view;
     matrix projection;
+
+	// Billboarding and sprite sheet info, the same for every particle
+	float3 cameraRight;
+	float3 cameraUp;
+	float2 frameSize;
+	uint sheetWidth;
 };
 
-// Describes individual vertex data
-struct VertexShaderInput
+// One particle, packed on the CPU (see PackedParticle in ParticlePacking.h)
+struct Particle
 {
-    float3 position		: POSITION;
-    float2 uv			: TEXCOORD;
-    float4 color		: COLOR;
+	float3 position;
+	uint sizeRotation;		// Two halves, size in the low 16 bits
+	uint color;				// RGBA8, red in the low byte
+	uint frame;
 };
 
+StructuredBuffer<Particle> particles : register(t0);
+
 // Defines the output data of our vertex shader
 struct VertexToPixel
 {
@@ -22,19 +31,43 @@ struct VertexToPixel
 	float4 color		: TEXCOORD1;
 };
 
-// The entry point for our vertex shader
-VertexToPixel main(VertexShaderInput input)
+// Corner order matches the CPU built quads (ParticleKernels::ExpandBillboards)
+static const float2 cornerUVs[4] = { float2(0, 0), float2(1, 0), float2(1, 1), float2(0, 1) };
+
+// The entry point for our vertex shader - there's no vertex buffer, the
+// index buffer's values are particle * 4 + corner
+VertexToPixel main(uint id : SV_VertexID)
 {
+	Particle particle = particles[id >> 2];
+	uint corner = id & 3;
+
+	float size = f16tof32(particle.sizeRotation);
+	float rotation = f16tof32(particle.sizeRotation >> 16);
+
+	// The rotated corners only take two distinct offsets, a and b
+	float s, c;
+	sincos(rotation, s, c);
+	float a = (c - s) * size;
+	float b = (c + s) * size;
+	float2 offsets[4] = { float2(-b, a), float2(a, b), float2(b, -a), float2(-a, -b) };
+	float2 offset = offsets[corner];
+	float3 position = particle.position + cameraRight * offset.x + cameraUp * offset.y;
+
     // Set up output
     VertexToPixel output;
 
     // Calculate output position
     matrix viewProj = mul(view, projection);
-    output.position = mul(float4(input.position, 1.0f), viewProj);
+    output.position = mul(float4(position, 1.0f), viewProj);
+
+	// Sprite sheet frame, then the corner within it
+	float2 frameOrigin = float2(particle.frame % sheetWidth, particle.frame / sheetWidth) * frameSize;
+	output.uv = frameOrigin + cornerUVs[corner] * frameSize;
+	output.color = float4(
+		particle.color & 0xFF,
+		(particle.color >> 8) & 0xFF,
+		(particle.color >> 16) & 0xFF,
+		particle.color >> 24) / 255.0f;
 
-	// Pass uv through
-	output.uv = input.uv;
-	output.color = input.color;
-   
     return output;
-}
\ No newline at end of file
+}
@@ -0,0 +1,118 @@
+#include "Random.h"
+
+#include <emmintrin.h>
+
+// splitmix64 - spreads a seed out into well mixed state words
+static unsigned long long SplitMix64(unsigned long long* x)
+{
+	unsigned long long z = (*x += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+Random::Random(unsigned long long seed, unsigned long long stream)
+{
+	Seed(seed, stream);
+}
+
+void Random::Seed(unsigned long long seed, unsigned long long stream)
+{
+	unsigned long long mix = seed ^ (stream * 0xD1B54A32D192ED03ull);
+	for (int i = 0; i < 16; i += 2)
+	{
+		unsigned long long bits = SplitMix64(&mix);
+		state[i] = (unsigned int)bits;
+		state[i + 1] = (unsigned int)(bits >> 32);
+	}
+
+	// xoshiro can't recover from an all zero lane
+	for (int lane = 0; lane < 4; lane++)
+	{
+		if (!state[lane] && !state[4 + lane] && !state[8 + lane] && !state[12 + lane])
+			state[lane] = 1;
+	}
+
+	bufferedCount = 0;
+}
+
+// --------------------------------------------------------
+// Advances all four lanes once, writing one result per lane
+// --------------------------------------------------------
+void Random::Step(unsigned int* results)
+{
+	// Unaligned loads, the object may live anywhere
+	__m128i s0 = _mm_loadu_si128((const __m128i*)(state + 0));
+	__m128i s1 = _mm_loadu_si128((const __m128i*)(state + 4));
+	__m128i s2 = _mm_loadu_si128((const __m128i*)(state + 8));
+	__m128i s3 = _mm_loadu_si128((const __m128i*)(state + 12));
+
+	_mm_storeu_si128((__m128i*)results, _mm_add_epi32(s0, s3));
+
+	__m128i t = _mm_slli_epi32(s1, 9);
+	s2 = _mm_xor_si128(s2, s0);
+	s3 = _mm_xor_si128(s3, s1);
+	s1 = _mm_xor_si128(s1, s2);
+	s0 = _mm_xor_si128(s0, s3);
+	s2 = _mm_xor_si128(s2, t);
+	s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+	_mm_storeu_si128((__m128i*)(state + 0), s0);
+	_mm_storeu_si128((__m128i*)(state + 4), s1);
+	_mm_storeu_si128((__m128i*)(state + 8), s2);
+	_mm_storeu_si128((__m128i*)(state + 12), s3);
+}
+
+unsigned int Random::NextUInt()
+{
+	// Integers skip the float buffer, they're only used for seeding other streams
+	unsigned int results[4];
+	Step(results);
+	return results[0];
+}
+
+unsigned long long Random::NextUInt64()
+{
+	unsigned int results[4];
+	Step(results);
+	return ((unsigned long long)results[1] << 32) | results[0];
+}
+
+float Random::NextFloat()
+{
+	if (bufferedCount == 0)
+	{
+		FillFloats(buffered, 4);
+		bufferedCount = 4;
+	}
+	return buffered[4 - bufferedCount--];
+}
+
+float Random::Range(float min, float max)
+{
+	return min + NextFloat() * (max - min);
+}
+
+void Random::FillFloats(float* values, int count)
+{
+	// The top 24 bits fit a float's mantissa exactly, scaled into [0, 1)
+	const __m128 scale = _mm_set1_ps(1.0f / 16777216.0f);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		unsigned int results[4];
+		Step(results);
+		__m128i bits = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)results), 8);
+		_mm_storeu_ps(values + i, _mm_mul_ps(_mm_cvtepi32_ps(bits), scale));
+	}
+
+	// Partial step for the last few
+	if (i < count)
+	{
+		unsigned int results[4];
+		Step(results);
+		for (int lane = 0; i < count; lane++, i++)
+			values[i] = (results[lane] >> 8) * (1.0f / 16777216.0f);
+	}
+}
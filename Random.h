@@ -0,0 +1,35 @@
+#pragma once
+
+// --------------------------------------------------------
+// Seedable random number stream (xoshiro128+, four lanes)
+//
+// Four independent xoshiro128+ generators run side by side in
+// one SSE register, so FillFloats produces four numbers per
+// step.  Each stream owns its state, so separate streams can be
+// used from separate threads, and a stream seeded the same way
+// always produces the same numbers.
+// --------------------------------------------------------
+class Random
+{
+	// Lane l of state word w is state[w * 4 + l]
+	unsigned int state[16];
+
+	// Leftovers from the last step, handed out one at a time by Next*
+	float buffered[4];
+	int bufferedCount;
+
+	void Step(unsigned int* results);
+public:
+	// Different stream ids give unrelated sequences from the same seed
+	Random(unsigned long long seed = 1, unsigned long long stream = 0);
+
+	void Seed(unsigned long long seed, unsigned long long stream = 0);
+
+	unsigned int NextUInt();
+	unsigned long long NextUInt64();
+	float NextFloat();					// [0, 1)
+	float Range(float min, float max);	// [min, max)
+
+	// Fills values with count floats in [0, 1)
+	void FillFloats(float* values, int count);
+};
@@ -608,6 +608,30 @@ SimpleVertexShader::SimpleVertexShader(ID3D11Device * device, ID3D11DeviceContex
 	this->perInstanceCompatible = perInstanceCompatible;
 }
 
+// --------------------------------------------------------
+// Constructor overload which takes the input layout's elements
+//
+// LoadShader() builds the input layout from these instead of
+// from reflection - for vertex formats reflection can't work
+// out (normalized or half float inputs, which the shader just
+// sees as floats).  The semantic names must outlive the shader.
+// --------------------------------------------------------
+SimpleVertexShader::SimpleVertexShader(ID3D11Device * device, ID3D11DeviceContext * context, const D3D11_INPUT_ELEMENT_DESC * inputElements, unsigned int inputElementCount)
+	: ISimpleShader(device, context)
+{
+	this->inputLayout = 0;
+	this->inputElements.assign(inputElements, inputElements + inputElementCount);
+	this->shader = 0;
+
+	// Per instance data would have to be in the elements themselves
+	this->perInstanceCompatible = false;
+	for (unsigned int i = 0; i < inputElementCount; i++)
+	{
+		if (inputElements[i].InputSlotClass == D3D11_INPUT_PER_INSTANCE_DATA)
+			this->perInstanceCompatible = true;
+	}
+}
+
 // --------------------------------------------------------
 // Destructor - Clean up actual shader (base will be called automatically)
 // --------------------------------------------------------
@@ -655,6 +679,18 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
 	if (inputLayout)
 		return true;
 
+	// Or the elements to make one from?
+	if (!inputElements.empty())
+	{
+		HRESULT hr = device->CreateInputLayout(
+			&inputElements[0],
+			(unsigned int)inputElements.size(),
+			shaderBlob->GetBufferPointer(),
+			shaderBlob->GetBufferSize(),
+			&inputLayout);
+		return hr == S_OK;
+	}
+
 	// Vertex shader was created successfully, so we now use the
 	// shader code to re-reflect and create an input layout that 
 	// matches what the vertex shader expects.  Code adapted from:
@@ -679,6 +715,10 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
 		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
 		refl->GetInputParameterDesc(i, &paramDesc);
 
+		// System values (like SV_VertexID) don't come from a vertex buffer
+		if (paramDesc.SystemValueType != D3D_NAME_UNDEFINED)
+			continue;
+
 		// Check the semantic name for "_PER_INSTANCE"
 		std::string perInstanceStr = "_PER_INSTANCE";
 		std::string sem = paramDesc.SemanticName;
@@ -736,13 +776,16 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
 		inputLayoutDesc.push_back(elementDesc);
 	}
 
-	// Try to create Input Layout
-	HRESULT hr = device->CreateInputLayout(
-		&inputLayoutDesc[0], 
-		(unsigned int)inputLayoutDesc.size(), 
-		shaderBlob->GetBufferPointer(), 
-		shaderBlob->GetBufferSize(),
-		&inputLayout);
+	// Try to create Input Layout (a shader with no vertex inputs doesn't need one)
+	if (!inputLayoutDesc.empty())
+	{
+		HRESULT hr = device->CreateInputLayout(
+			&inputLayoutDesc[0], 
+			(unsigned int)inputLayoutDesc.size(), 
+			shaderBlob->GetBufferPointer(), 
+			shaderBlob->GetBufferSize(),
+			&inputLayout);
+	}
 
 	// All done, clean up
 	refl->Release();
@@ -153,6 +153,7 @@ class SimpleVertexShader : public ISimpleShader
 public:
 	SimpleVertexShader(ID3D11Device* device, ID3D11DeviceContext* context);
 	SimpleVertexShader(ID3D11Device* device, ID3D11DeviceContext* context, ID3D11InputLayout* inputLayout, bool perInstanceCompatible);
+	SimpleVertexShader(ID3D11Device* device, ID3D11DeviceContext* context, const D3D11_INPUT_ELEMENT_DESC* inputElements, unsigned int inputElementCount);
 	~SimpleVertexShader();
 	ID3D11VertexShader* GetDirectXShader() { return shader; }
 	ID3D11InputLayout* GetInputLayout() { return inputLayout; }
@@ -164,6 +165,7 @@ public:
 protected:
 	bool perInstanceCompatible;
 	ID3D11InputLayout* inputLayout;
+	std::vector<D3D11_INPUT_ELEMENT_DESC> inputElements;
 	ID3D11VertexShader* shader;
 	bool CreateShader(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
@@ -0,0 +1,61 @@
+
+// Constant Buffer
+// - Same as VertexShader.hlsl, plus the mesh's dequantization
+cbuffer externalData : register(b0)
+{
+	matrix world;
+	matrix view;
+	matrix projection;
+
+	// Position = stored position * positionScale + positionBias
+	// (see MeshQuantization in MeshQuantization.h)
+	float3 positionScale;
+	float3 positionBias;
+};
+
+// A QuantizedVertex (MeshQuantization.h) - the formats come from
+// Mesh::GetQuantizedInputElements, not from these types
+struct VertexShaderInput
+{
+	float4 position			: POSITION;		// R16G16B16A16_UNORM, 0 - 1 across the mesh's bounds
+	float2 uv				: TEXCOORD;		// R16G16_FLOAT
+	float4 normalTangent	: NORMAL;		// R8G8B8A8_SNORM, octahedral normal (xy) and tangent (zw)
+};
+
+// Matches VertexShader.hlsl and VertexShaderSpecularMap.hlsl, so
+// quantized meshes work with those materials' pixel shaders
+struct VertexToPixel
+{
+	float4 position		: SV_POSITION;	// XYZW position (System Value Position)
+	float2 uv			: TEXCOORD;
+	float3 normal		: NORMAL;
+	float3 worldPos		: POSITION;		// Used by point and spot lights
+};
+
+// --------------------------------------------------------
+// Unfolds an octahedral encoded direction
+// (MeshQuantizer::DecodeOctahedral does the same on the CPU)
+// --------------------------------------------------------
+float3 OctahedralDecode(float2 encoded)
+{
+	float3 direction = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+	if (direction.z < 0.0f)
+		direction.xy = (1.0f - abs(direction.yx)) * (direction.xy >= 0.0f ? 1.0f : -1.0f);
+	return normalize(direction);
+}
+
+VertexToPixel main( VertexShaderInput input )
+{
+	VertexToPixel output;
+
+	float3 position = input.position.xyz * positionScale + positionBias;
+	float3 normal = OctahedralDecode(input.normalTangent.xy);
+
+	matrix worldViewProj = mul(mul(world, view), projection);
+	output.position = mul(float4(position, 1.0f), worldViewProj);
+	output.normal = normalize(mul(normal, (float3x3)world));
+	output.worldPos = mul(float4(position, 1.0f), world).xyz;
+	output.uv = input.uv;
+
+	return output;
+}
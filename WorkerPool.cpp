@@ -0,0 +1,119 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int workerCount)
+{
+	task = 0;
+	context = 0;
+	taskCount = 0;
+	nextTask = 0;
+	finishedTasks = 0;
+	generation = 0;
+	busyWorkers = 0;
+	quitting = false;
+
+	for (int i = 0; i < workerCount; i++)
+		workers.push_back(std::thread(&WorkerPool::WorkerLoop, this));
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quitting = true;
+	}
+	wake.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+void WorkerPool::ParallelFor(int count, Task task, void* context)
+{
+	if (count <= 0)
+		return;
+
+	// Not worth waking anyone up
+	if (workers.empty() || count == 1)
+	{
+		for (int i = 0; i < count; i++)
+			task(context, i);
+		return;
+	}
+
+	{
+		// A worker still on its way out of the last loop could bump nextTask
+		// after the reset below, so let it finish first
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this] { return busyWorkers == 0; });
+
+		this->task = task;
+		this->context = context;
+		taskCount = count;
+		nextTask = 0;
+		finishedTasks = 0;
+		generation++;
+	}
+	wake.notify_all();
+
+	// Help out, then wait for the stragglers.  Workers only join while
+	// taskCount is set, and this waits for every one that did (not just
+	// every task), so nobody is still touching the counters when the next
+	// loop resets them.
+	RunTasks(task, context, count);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return finishedTasks.load() == taskCount && busyWorkers == 0; });
+	taskCount = 0;
+}
+
+void WorkerPool::RunTasks(Task task, void* context, int taskCount)
+{
+	int finishedHere = 0;
+	for (int i = nextTask++; i < taskCount; i = nextTask++)
+	{
+		task(context, i);
+		finishedHere++;
+	}
+	finishedTasks += finishedHere;
+}
+
+void WorkerPool::WorkerLoop()
+{
+	unsigned int seenGeneration = 0;
+	while (true)
+	{
+		Task currentTask;
+		void* currentContext;
+		int currentCount;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return quitting || generation != seenGeneration; });
+			if (quitting)
+				return;
+
+			seenGeneration = generation;
+
+			// Woke up after the calling thread already finished the loop alone
+			if (taskCount == 0)
+				continue;
+
+			currentTask = task;
+			currentContext = context;
+			currentCount = taskCount;
+			busyWorkers++;
+		}
+
+		RunTasks(currentTask, currentContext, currentCount);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busyWorkers--;
+		}
+		done.notify_all();
+	}
+}
+
+int WorkerPool::GetThreadCount()
+{
+	return (int)workers.size() + 1;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+
+// --------------------------------------------------------
+// A fixed set of worker threads for data-parallel loops
+//
+// ParallelFor hands out task indices from a shared counter and
+// the calling thread works alongside the workers until every
+// task is done.  Tasks take a plain function pointer and context
+// so kicking off a loop never allocates.
+// --------------------------------------------------------
+class WorkerPool
+{
+public:
+	typedef void (*Task)(void* context, int index);
+
+	// workerCount extra threads (0 runs everything on the calling thread)
+	WorkerPool(int workerCount);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	// Runs task(context, i) for every i in [0, count) and returns once they've all finished
+	void ParallelFor(int count, Task task, void* context);
+
+	int GetThreadCount();	// Including the calling thread
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+
+	// The current loop
+	Task task;
+	void* context;
+	int taskCount;
+	std::atomic<int> nextTask;
+	std::atomic<int> finishedTasks;
+	unsigned int generation;	// Bumped for every loop so workers know there's new work
+	int busyWorkers;			// Workers between picking up a loop and finishing with it
+	bool quitting;
+
+	void WorkerLoop();
+	void RunTasks(Task task, void* context, int taskCount);
+};
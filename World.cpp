@@ -0,0 +1,442 @@
+#include "World.h"
+#include <cfloat>
+
+using namespace DirectX;
+
+World::World(Broadphase* broadphase, int initialCapacity)
+{
+	this->broadphase = broadphase;
+	this->initialCapacity = initialCapacity;
+	entityCount = 0;
+	matricesRebuilt = 0;
+
+	records.reserve(initialCapacity);
+	freeRecords.reserve(initialCapacity);
+}
+
+World::~World()
+{
+	Clear();
+	for (size_t i = 0; i < archetypes.size(); i++)
+		delete archetypes[i];
+}
+
+int World::FindOrCreateArchetype(unsigned int mask)
+{
+	for (size_t i = 0; i < archetypes.size(); i++)
+	{
+		if (archetypes[i]->Mask == mask)
+			return (int)i;
+	}
+
+	// New combination of components - reserve everything up front so
+	// a busy wave doesn't reallocate the arrays
+	Archetype* archetype = new Archetype();
+	archetype->Mask = mask;
+	archetype->Owners.reserve(initialCapacity);
+	if (mask & COMPONENT_TRANSFORM) archetype->Transforms.reserve(initialCapacity);
+	if (mask & COMPONENT_VELOCITY) archetype->Velocities.reserve(initialCapacity);
+	if (mask & COMPONENT_COLLIDER) archetype->Colliders.reserve(initialCapacity);
+	if (mask & COMPONENT_RENDER) archetype->Renders.reserve(initialCapacity);
+	if (mask & COMPONENT_TEAM) archetype->Teams.reserve(initialCapacity);
+	if (mask & COMPONENT_LIFETIME) archetype->Lifetimes.reserve(initialCapacity);
+	if (mask & COMPONENT_CULL_BOUNDS) archetype->CullBounds.reserve(initialCapacity);
+
+	archetypes.push_back(archetype);
+	return (int)archetypes.size() - 1;
+}
+
+bool World::Locate(EntityHandle handle, Archetype** archetype, int* row)
+{
+	if (handle.index >= records.size())
+		return false;
+
+	EntityRecord& record = records[handle.index];
+	if (!record.alive || record.generation != handle.generation)
+		return false;
+
+	*archetype = archetypes[record.archetype];
+	*row = record.row;
+	return true;
+}
+
+EntityHandle World::Create(unsigned int componentMask)
+{
+	int archetypeIndex = FindOrCreateArchetype(componentMask);
+	Archetype* archetype = archetypes[archetypeIndex];
+
+	// Grab a record slot for the handle
+	unsigned int index;
+	if (!freeRecords.empty())
+	{
+		index = freeRecords.back();
+		freeRecords.pop_back();
+	}
+	else
+	{
+		index = (unsigned int)records.size();
+		EntityRecord record = {};
+		records.push_back(record);
+	}
+
+	EntityHandle handle;
+	handle.index = index;
+	handle.generation = records[index].generation;
+
+	records[index].archetype = archetypeIndex;
+	records[index].row = archetype->Count();
+	records[index].alive = true;
+
+	// Append a row with default values for every component in the mask
+	archetype->Owners.push_back(handle);
+	if (componentMask & COMPONENT_TRANSFORM)
+	{
+		TransformComponent transform;
+		transform.World = XMFLOAT4X4(
+			1, 0, 0, 0,
+			0, 1, 0, 0,
+			0, 0, 1, 0,
+			0, 0, 0, 1);
+		transform.Position = XMFLOAT3(0, 0, 0);
+		transform.Scale = XMFLOAT3(1, 1, 1);
+		transform.Rotation = XMFLOAT4(0, 0, 0, 1);
+		transform.Dirty = true;
+		archetype->Transforms.push_back(transform);
+	}
+	if (componentMask & COMPONENT_VELOCITY)
+	{
+		VelocityComponent velocity = { XMFLOAT3(0, 0, 0) };
+		archetype->Velocities.push_back(velocity);
+	}
+	if (componentMask & COMPONENT_COLLIDER)
+	{
+		ColliderComponent collider = { 0, XMFLOAT3(1, 1, 1), -1 };
+		archetype->Colliders.push_back(collider);
+	}
+	if (componentMask & COMPONENT_RENDER)
+	{
+		RenderComponent render = { 0, 0 };
+		archetype->Renders.push_back(render);
+	}
+	if (componentMask & COMPONENT_TEAM)
+	{
+		TeamComponent team = { TEAM_PLAYER_LASER };
+		archetype->Teams.push_back(team);
+	}
+	if (componentMask & COMPONENT_LIFETIME)
+	{
+		LifetimeComponent lifetime = { 0 };
+		archetype->Lifetimes.push_back(lifetime);
+	}
+	if (componentMask & COMPONENT_CULL_BOUNDS)
+	{
+		CullBoundsComponent cull = { XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX), XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX) };
+		archetype->CullBounds.push_back(cull);
+	}
+
+	entityCount++;
+	return handle;
+}
+
+void World::RemoveRow(Archetype* archetype, int row)
+{
+	int last = archetype->Count() - 1;
+
+	// Move the last row into the hole, then drop the last row
+	if (row != last)
+	{
+		archetype->Owners[row] = archetype->Owners[last];
+		if (archetype->Mask & COMPONENT_TRANSFORM) archetype->Transforms[row] = archetype->Transforms[last];
+		if (archetype->Mask & COMPONENT_VELOCITY) archetype->Velocities[row] = archetype->Velocities[last];
+		if (archetype->Mask & COMPONENT_COLLIDER) archetype->Colliders[row] = archetype->Colliders[last];
+		if (archetype->Mask & COMPONENT_RENDER) archetype->Renders[row] = archetype->Renders[last];
+		if (archetype->Mask & COMPONENT_TEAM) archetype->Teams[row] = archetype->Teams[last];
+		if (archetype->Mask & COMPONENT_LIFETIME) archetype->Lifetimes[row] = archetype->Lifetimes[last];
+		if (archetype->Mask & COMPONENT_CULL_BOUNDS) archetype->CullBounds[row] = archetype->CullBounds[last];
+
+		// The moved entity's record has to follow it
+		records[archetype->Owners[row].index].row = row;
+	}
+
+	archetype->Owners.pop_back();
+	if (archetype->Mask & COMPONENT_TRANSFORM) archetype->Transforms.pop_back();
+	if (archetype->Mask & COMPONENT_VELOCITY) archetype->Velocities.pop_back();
+	if (archetype->Mask & COMPONENT_COLLIDER) archetype->Colliders.pop_back();
+	if (archetype->Mask & COMPONENT_RENDER) archetype->Renders.pop_back();
+	if (archetype->Mask & COMPONENT_TEAM) archetype->Teams.pop_back();
+	if (archetype->Mask & COMPONENT_LIFETIME) archetype->Lifetimes.pop_back();
+	if (archetype->Mask & COMPONENT_CULL_BOUNDS) archetype->CullBounds.pop_back();
+}
+
+void World::Destroy(EntityHandle handle)
+{
+	Archetype* archetype;
+	int row;
+	if (!Locate(handle, &archetype, &row))
+		return;
+
+	// Unregister from the broadphase before the row goes away
+	if ((archetype->Mask & COMPONENT_COLLIDER) && archetype->Colliders[row].Proxy >= 0)
+		broadphase->DestroyProxy(archetype->Colliders[row].Proxy);
+
+	RemoveRow(archetype, row);
+
+	// Bumping the generation invalidates any handles still floating around
+	EntityRecord& record = records[handle.index];
+	record.alive = false;
+	record.generation++;
+	freeRecords.push_back(handle.index);
+	entityCount--;
+}
+
+bool World::IsAlive(EntityHandle handle)
+{
+	Archetype* archetype;
+	int row;
+	return Locate(handle, &archetype, &row);
+}
+
+void World::Clear()
+{
+	for (size_t a = 0; a < archetypes.size(); a++)
+	{
+		while (archetypes[a]->Count() > 0)
+			Destroy(archetypes[a]->Owners[archetypes[a]->Count() - 1]);
+	}
+}
+
+TransformComponent* World::GetTransform(EntityHandle handle)
+{
+	Archetype* archetype;
+	int row;
+	if (!Locate(handle, &archetype, &row) || !(archetype->Mask & COMPONENT_TRANSFORM))
+		return 0;
+	return &archetype->Transforms[row];
+}
+
+VelocityComponent* World::GetVelocity(EntityHandle handle)
+{
+	Archetype* archetype;
+	int row;
+	if (!Locate(handle, &archetype, &row) || !(archetype->Mask & COMPONENT_VELOCITY))
+		return 0;
+	return &archetype->Velocities[row];
+}
+
+TeamComponent* World::GetTeam(EntityHandle handle)
+{
+	Archetype* archetype;
+	int row;
+	if (!Locate(handle, &archetype, &row) || !(archetype->Mask & COMPONENT_TEAM))
+		return 0;
+	return &archetype->Teams[row];
+}
+
+LifetimeComponent* World::GetLifetime(EntityHandle handle)
+{
+	Archetype* archetype;
+	int row;
+	if (!Locate(handle, &archetype, &row) || !(archetype->Mask & COMPONENT_LIFETIME))
+		return 0;
+	return &archetype->Lifetimes[row];
+}
+
+CullBoundsComponent* World::GetCullBounds(EntityHandle handle)
+{
+	Archetype* archetype;
+	int row;
+	if (!Locate(handle, &archetype, &row) || !(archetype->Mask & COMPONENT_CULL_BOUNDS))
+		return 0;
+	return &archetype->CullBounds[row];
+}
+
+RenderComponent* World::GetRender(EntityHandle handle)
+{
+	Archetype* archetype;
+	int row;
+	if (!Locate(handle, &archetype, &row) || !(archetype->Mask & COMPONENT_RENDER))
+		return 0;
+	return &archetype->Renders[row];
+}
+
+void World::AttachCollider(EntityHandle handle, const MeshBounds& bounds, DirectX::XMFLOAT3 scale, unsigned int layer, unsigned int mask)
+{
+	Archetype* archetype;
+	int row;
+	if (!Locate(handle, &archetype, &row) || !(archetype->Mask & COMPONENT_COLLIDER))
+		return;
+
+	ColliderComponent& collider = archetype->Colliders[row];
+	collider.Bounds = &bounds;
+	collider.Scale = scale;
+	collider.Proxy = broadphase->CreateProxy(layer, mask, 0);
+
+	if (collider.Proxy >= (int)proxyOwners.size())
+		proxyOwners.resize(collider.Proxy + 1);
+	proxyOwners[collider.Proxy] = handle;
+}
+
+EntityHandle World::GetProxyOwner(int proxy)
+{
+	if (proxy < 0 || proxy >= (int)proxyOwners.size())
+	{
+		EntityHandle none = { 0xFFFFFFFF, 0 };
+		return none;
+	}
+	return proxyOwners[proxy];
+}
+
+// --------------------------------------------------------
+// Movement system - integrates velocity into position
+// --------------------------------------------------------
+void World::UpdateMovement(float dt)
+{
+	for (size_t a = 0; a < archetypes.size(); a++)
+	{
+		Archetype* archetype = archetypes[a];
+		if (!archetype->Has(COMPONENT_TRANSFORM | COMPONENT_VELOCITY))
+			continue;
+
+		TransformComponent* transforms = archetype->Transforms.data();
+		VelocityComponent* velocities = archetype->Velocities.data();
+		int count = archetype->Count();
+		for (int i = 0; i < count; i++)
+		{
+			transforms[i].Position.x += velocities[i].Velocity.x * dt;
+			transforms[i].Position.y += velocities[i].Velocity.y * dt;
+			transforms[i].Position.z += velocities[i].Velocity.z * dt;
+			transforms[i].Dirty = true;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Lifetime system - destroys entities whose time is up
+// --------------------------------------------------------
+void World::UpdateLifetimes(float dt)
+{
+	for (size_t a = 0; a < archetypes.size(); a++)
+	{
+		Archetype* archetype = archetypes[a];
+		if (!archetype->Has(COMPONENT_LIFETIME))
+			continue;
+
+		for (int i = 0; i < archetype->Count(); i++)
+		{
+			archetype->Lifetimes[i].Remaining -= dt;
+			if (archetype->Lifetimes[i].Remaining <= 0.0f)
+			{
+				// The last row gets swapped in here, so look at this row again
+				Destroy(archetype->Owners[i]);
+				i--;
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Bounds culling system - destroys entities that left the play area
+// --------------------------------------------------------
+void World::CullOutOfBounds()
+{
+	for (size_t a = 0; a < archetypes.size(); a++)
+	{
+		Archetype* archetype = archetypes[a];
+		if (!archetype->Has(COMPONENT_TRANSFORM | COMPONENT_CULL_BOUNDS))
+			continue;
+
+		for (int i = 0; i < archetype->Count(); i++)
+		{
+			XMFLOAT3 pos = archetype->Transforms[i].Position;
+			CullBoundsComponent& cull = archetype->CullBounds[i];
+			if (pos.x < cull.Min.x || pos.y < cull.Min.y || pos.z < cull.Min.z ||
+				pos.x > cull.Max.x || pos.y > cull.Max.y || pos.z > cull.Max.z)
+			{
+				Destroy(archetype->Owners[i]);
+				i--;
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Collider system - pushes each collider's world box to the broadphase
+// (centered on the entity, sized by the collider's scale)
+// --------------------------------------------------------
+void World::UpdateColliders()
+{
+	for (size_t a = 0; a < archetypes.size(); a++)
+	{
+		Archetype* archetype = archetypes[a];
+		if (!archetype->Has(COMPONENT_TRANSFORM | COMPONENT_COLLIDER))
+			continue;
+
+		TransformComponent* transforms = archetype->Transforms.data();
+		ColliderComponent* colliders = archetype->Colliders.data();
+		int count = archetype->Count();
+		for (int i = 0; i < count; i++)
+		{
+			if (colliders[i].Proxy < 0)
+				continue;
+
+			XMVECTOR halfWidth = (XMLoadFloat3(&colliders[i].Bounds->Max) - XMLoadFloat3(&colliders[i].Bounds->Min)) * 0.5f;
+			halfWidth = XMVectorMultiply(halfWidth, XMLoadFloat3(&colliders[i].Scale));
+			XMVECTOR center = XMLoadFloat3(&transforms[i].Position);
+
+			XMFLOAT3 minCoord, maxCoord;
+			XMStoreFloat3(&minCoord, center - halfWidth);
+			XMStoreFloat3(&maxCoord, center + halfWidth);
+			broadphase->SetExtents(colliders[i].Proxy, minCoord, maxCoord);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Transform system - rebuilds stale world matrices
+// --------------------------------------------------------
+void World::UpdateTransforms()
+{
+	matricesRebuilt = 0;
+	for (size_t a = 0; a < archetypes.size(); a++)
+	{
+		Archetype* archetype = archetypes[a];
+		if (!archetype->Has(COMPONENT_TRANSFORM))
+			continue;
+
+		TransformComponent* transforms = archetype->Transforms.data();
+		int count = archetype->Count();
+		for (int i = 0; i < count; i++)
+		{
+			if (!transforms[i].Dirty)
+				continue;
+
+			XMMATRIX world =
+				XMMatrixScalingFromVector(XMLoadFloat3(&transforms[i].Scale)) *
+				XMMatrixRotationQuaternion(XMLoadFloat4(&transforms[i].Rotation)) *
+				XMMatrixTranslationFromVector(XMLoadFloat3(&transforms[i].Position));
+			XMStoreFloat4x4(&transforms[i].World, XMMatrixTranspose(world));
+			transforms[i].Dirty = false;
+			matricesRebuilt++;
+		}
+	}
+}
+
+int World::GetArchetypeCount()
+{
+	return (int)archetypes.size();
+}
+
+Archetype* World::GetArchetype(int index)
+{
+	return archetypes[index];
+}
+
+int World::GetEntityCount()
+{
+	return entityCount;
+}
+
+int World::GetMatricesRebuilt()
+{
+	return matricesRebuilt;
+}
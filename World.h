@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "Components.h"
+#include "Broadphase.h"
+
+// --------------------------------------------------------
+// A handle to an entity in the World.  The generation is
+// bumped every time a slot is freed, so a handle to a
+// destroyed entity never resolves to whatever gets created
+// in that slot later.
+// --------------------------------------------------------
+struct EntityHandle
+{
+	unsigned int index;
+	unsigned int generation;
+};
+
+// --------------------------------------------------------
+// All entities sharing one combination of components.
+// Each component lives in its own dense array and row i of
+// every array belongs to the same entity.
+// --------------------------------------------------------
+struct Archetype
+{
+	unsigned int Mask;
+	std::vector<EntityHandle> Owners;
+	std::vector<TransformComponent> Transforms;
+	std::vector<VelocityComponent> Velocities;
+	std::vector<ColliderComponent> Colliders;
+	std::vector<RenderComponent> Renders;
+	std::vector<TeamComponent> Teams;
+	std::vector<LifetimeComponent> Lifetimes;
+	std::vector<CullBoundsComponent> CullBounds;
+
+	int Count() { return (int)Owners.size(); }
+	bool Has(unsigned int components) { return (Mask & components) == components; }
+};
+
+// --------------------------------------------------------
+// A small archetype-based entity component system
+//
+// Systems walk each matching archetype's arrays front to back,
+// and removing an entity swaps the last row into its place.
+// --------------------------------------------------------
+class World
+{
+	struct EntityRecord
+	{
+		int archetype;
+		int row;
+		unsigned int generation;
+		bool alive;
+	};
+
+	std::vector<Archetype*> archetypes;
+	std::vector<EntityRecord> records;
+	std::vector<unsigned int> freeRecords;
+	int initialCapacity;
+	int entityCount;
+
+	// Colliders register with the broadphase, this maps proxies back to entities
+	Broadphase* broadphase;
+	std::vector<EntityHandle> proxyOwners;
+
+	int matricesRebuilt;
+
+	int FindOrCreateArchetype(unsigned int mask);
+	bool Locate(EntityHandle handle, Archetype** archetype, int* row);
+	void RemoveRow(Archetype* archetype, int row);
+public:
+	World(Broadphase* broadphase, int initialCapacity);
+	~World();
+
+	EntityHandle Create(unsigned int componentMask);
+	void Destroy(EntityHandle handle);
+	bool IsAlive(EntityHandle handle);
+	void Clear();
+
+	// Component access - null if the entity is gone or doesn't have the component
+	TransformComponent* GetTransform(EntityHandle handle);
+	VelocityComponent* GetVelocity(EntityHandle handle);
+	TeamComponent* GetTeam(EntityHandle handle);
+	LifetimeComponent* GetLifetime(EntityHandle handle);
+	CullBoundsComponent* GetCullBounds(EntityHandle handle);
+	RenderComponent* GetRender(EntityHandle handle);
+
+	// Sets up the collider component and registers it with the broadphase
+	void AttachCollider(EntityHandle handle, const MeshBounds& bounds, DirectX::XMFLOAT3 scale, unsigned int layer, unsigned int mask);
+	EntityHandle GetProxyOwner(int proxy);
+
+	// Systems
+	void UpdateMovement(float dt);
+	void UpdateLifetimes(float dt);
+	void CullOutOfBounds();
+	void UpdateColliders();
+	void UpdateTransforms();
+
+	// Iteration (for drawing)
+	int GetArchetypeCount();
+	Archetype* GetArchetype(int index);
+
+	// Stats
+	int GetEntityCount();
+	int GetMatricesRebuilt();
+};
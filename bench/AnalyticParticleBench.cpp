@@ -0,0 +1,127 @@
+#include "BenchTimer.h"
+#include "ParticleKernels.h"
+#include "Random.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// --------------------------------------------------------
+// Stepped particles (Update then ExpandBillboards every frame)
+// against analytic ones (Evaluate into 64-particle blocks,
+// then ExpandBillboards from those, the way ParticleSystem
+// draws them), 100k particles, one thread.
+//
+// The time step is 1/64 s and every birth time lands on it, so
+// a stepped particle's age and an analytic one's time - birth
+// are the same float, and the quads the two build have to match
+// bit for bit.  No particle dies during the run.
+// --------------------------------------------------------
+static const int particleCount = 100000;
+static const int frames = 60;
+static const int analyticBlock = 64;	// As in ParticleSystem
+static const float deltaTime = 1.0f / 64.0f;
+
+int main()
+{
+	ParticleCurves curves;
+	for (int i = 0; i < particleCurveResolution; i++)
+	{
+		float t = i / (float)(particleCurveResolution - 1);
+		curves.R[i] = 1.0f - t;
+		curves.G[i] = t;
+		curves.B[i] = 0.5f;
+		curves.A[i] = 1.0f - t * t;
+		curves.Size[i] = 0.1f + t;
+		curves.Rotation[i] = t * (2.0f - t);
+	}
+
+	ParticleUpdateParams params;
+	params.DeltaTime = deltaTime;
+	params.Lifetime = 2.0f;
+	params.Curves = &curves;
+	params.Acceleration = DirectX::XMFLOAT3(0.0f, -9.8f, 0.0f);
+	params.Features = particleFeatureAll;
+
+	DirectX::XMFLOAT2 sheet[16];
+	for (int f = 0; f < 16; f++)
+		sheet[f] = DirectX::XMFLOAT2((f % 4) * 0.25f, (f / 4) * 0.25f);
+	BillboardParams billboard;
+	billboard.CameraRight = DirectX::XMFLOAT3(1, 0, 0);
+	billboard.CameraUp = DirectX::XMFLOAT3(0, 1, 0);
+	billboard.Lifetime = params.Lifetime;
+	billboard.Frames = sheet;
+	billboard.FrameCount = 16;
+	billboard.FrameSize = DirectX::XMFLOAT2(0.25f, 0.25f);
+	billboard.Features = particleFeatureAll;
+
+	// The same spawn values for both.  Ages start anywhere in the first
+	// second, so after the run the oldest is still under the lifetime.
+	ParticleArrays stepped, analytic;
+	ParticleKernels::Allocate(&stepped, particleCount, params.Lifetime);
+	ParticleKernels::Allocate(&analytic, particleCount, params.Lifetime);
+	Random random(9);
+	std::vector<float> randoms((size_t)particleCount * particleSpawnRandoms);
+	random.FillFloats(&randoms[0], (int)randoms.size());
+	ParticleSpawnParams spawn = {};
+	spawn.PositionRange = DirectX::XMFLOAT3(10, 10, 10);
+	spawn.Velocity = DirectX::XMFLOAT3(0, 3, 0);
+	spawn.VelocityRange = DirectX::XMFLOAT3(1, 1, 1);
+	spawn.RotationRanges = DirectX::XMFLOAT4(0, 3.0f, -6.0f, 6.0f);
+	spawn.Size = 1.0f;
+	spawn.Color = DirectX::XMFLOAT4(1, 1, 1, 1);
+	ParticleKernels::Spawn(spawn, stepped, 0, particleCount, &randoms[0]);
+	ParticleKernels::Spawn(spawn, analytic, 0, particleCount, &randoms[0]);
+	for (int i = 0; i < particleCount; i++)
+	{
+		float age = (i % 64) * deltaTime;
+		stepped.Age[i] = age;
+		analytic.Age[i] = -age;		// Born that long before time 0
+	}
+
+	std::vector<ParticleVertex> steppedVertices((size_t)particleCount * 4);
+	std::vector<ParticleVertex> analyticVertices((size_t)particleCount * 4);
+	float age[analyticBlock], x[analyticBlock], y[analyticBlock], z[analyticBlock], size[analyticBlock];
+	float rotation[analyticBlock], r[analyticBlock], g[analyticBlock], b[analyticBlock], a[analyticBlock];
+	ParticleArrays state = {};
+	state.Age = age; state.X = x; state.Y = y; state.Z = z; state.Size = size;
+	state.Rotation = rotation; state.R = r; state.G = g; state.B = b; state.A = a;
+
+	double steppedMs = 0, analyticMs = 0;
+	int differentFrames = 0;
+	float time = 0.0f;
+	BenchTimer timer;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		timer.Restart();
+		ParticleKernels::Update(params, stepped, 0, particleCount);
+		ParticleKernels::ExpandBillboards(billboard, stepped, 0, particleCount, &steppedVertices[0]);
+		steppedMs += timer.GetMilliseconds();
+
+		time += deltaTime;
+		timer.Restart();
+		for (int first = 0; first < particleCount; first += analyticBlock)
+		{
+			int count = particleCount - first < analyticBlock ? particleCount - first : analyticBlock;
+			ParticleKernels::Evaluate(params, time, analytic, first, count, &state);
+			ParticleKernels::ExpandBillboards(billboard, state, 0, count, &analyticVertices[(size_t)first * 4]);
+		}
+		analyticMs += timer.GetMilliseconds();
+
+		if (memcmp(&steppedVertices[0], &analyticVertices[0], steppedVertices.size() * sizeof(ParticleVertex)) != 0)
+			differentFrames++;
+	}
+
+	std::printf("%d particles, %d frames, AVX2 %s\n", particleCount, frames, ParticleKernels::HasAVX2() ? "available" : "not available");
+	std::printf("%-30s %10s %12s\n", "mode", "ms/frame", "Mparticles/s");
+	std::printf("%-30s %10.3f %12.0f\n", "stepped: Update + Expand", steppedMs / frames, particleCount / (steppedMs / frames) / 1000.0);
+	std::printf("%-30s %10.3f %12.0f\n", "analytic: Evaluate + Expand", analyticMs / frames, particleCount / (analyticMs / frames) / 1000.0);
+	if (differentFrames)
+		std::printf("QUADS DIFFER in %d of %d frames\n", differentFrames, frames);
+	else
+		std::printf("quads match in every frame\n");
+
+	ParticleKernels::Free(&analytic);
+	ParticleKernels::Free(&stepped);
+	return differentFrames ? 1 : 0;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <chrono>
+
+// --------------------------------------------------------
+// Wall clock milliseconds for the benchmarks
+// --------------------------------------------------------
+class BenchTimer
+{
+	std::chrono::steady_clock::time_point start;
+public:
+	BenchTimer() { Restart(); }
+
+	void Restart() { start = std::chrono::steady_clock::now(); }
+
+	double GetMilliseconds()
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+};
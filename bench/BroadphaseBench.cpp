@@ -0,0 +1,171 @@
+#include "BenchTimer.h"
+#include "Broadphase.h"
+#include "Collision.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+// --------------------------------------------------------
+// Sweep-and-prune against the nested loops it replaced, with
+// 1k, 10k and 100k colliders and no rendering.  Half are
+// enemies, a quarter player lasers and a quarter enemy lasers,
+// plus the player, spread over a field that grows with the
+// count so the density stays the same.  Every frame everything
+// moves a little, then both find the laser hits, and the hits
+// they find are compared.
+// --------------------------------------------------------
+typedef std::pair<int, int> Hit;	// Collider indices, laser first
+
+struct Scene
+{
+	MeshBounds Bounds;
+	std::vector<Collision*> Colliders;
+	std::vector<DirectX::XMFLOAT3> Positions;
+	std::vector<DirectX::XMFLOAT3> Velocities;
+	std::vector<int> PlayerLasers;
+	std::vector<int> Enemies;
+	std::vector<int> EnemyLasers;
+	int Player;
+	float FieldSize;
+	Broadphase Phase;
+};
+
+static int AddCollider(Scene* scene, Random& random, unsigned int layer, unsigned int mask, float scale, float speed)
+{
+	int index = (int)scene->Colliders.size();
+	Collision* collider = new Collision(scene->Bounds);
+	collider->SetScale(DirectX::XMFLOAT3(scale, scale, scale));
+	collider->AttachToBroadphase(&scene->Phase, layer, mask, (void*)(size_t)index);
+	scene->Colliders.push_back(collider);
+	scene->Positions.push_back(DirectX::XMFLOAT3(random.Range(0, scene->FieldSize), 0, random.Range(0, scene->FieldSize)));
+	scene->Velocities.push_back(DirectX::XMFLOAT3(random.Range(-0.1f, 0.1f), 0, speed));
+	return index;
+}
+
+static void BuildScene(Scene* scene, int count)
+{
+	scene->Bounds.Min = DirectX::XMFLOAT3(-0.5f, -0.5f, -0.5f);
+	scene->Bounds.Max = DirectX::XMFLOAT3(0.5f, 0.5f, 0.5f);
+	scene->Bounds.Center = DirectX::XMFLOAT3(0, 0, 0);
+	scene->Bounds.Radius = 0.87f;
+	scene->FieldSize = sqrtf((float)count) * 4.0f;
+
+	Random random(count);
+	scene->Player = AddCollider(scene, random, LAYER_PLAYER, LAYER_ENEMY_LASER, 2.0f, 0.0f);
+	for (int i = 0; i < count / 2; i++)
+		scene->Enemies.push_back(AddCollider(scene, random, LAYER_ENEMY, LAYER_PLAYER_LASER, 1.5f, -0.05f));
+	for (int i = 0; i < count / 4; i++)
+		scene->PlayerLasers.push_back(AddCollider(scene, random, LAYER_PLAYER_LASER, LAYER_ENEMY, 0.2f, 0.5f));
+	for (int i = 0; i < count / 4; i++)
+		scene->EnemyLasers.push_back(AddCollider(scene, random, LAYER_ENEMY_LASER, LAYER_PLAYER, 0.2f, -0.3f));
+
+	// Somebody has to be near the player
+	scene->Positions[scene->Player] = scene->Positions[scene->EnemyLasers[0]];
+}
+
+// Everything moves and wraps around the field
+static void MoveScene(Scene* scene)
+{
+	for (size_t i = 0; i < scene->Colliders.size(); i++)
+	{
+		DirectX::XMFLOAT3& p = scene->Positions[i];
+		const DirectX::XMFLOAT3& v = scene->Velocities[i];
+		p.x = fmodf(p.x + v.x + scene->FieldSize, scene->FieldSize);
+		p.z = fmodf(p.z + v.z + scene->FieldSize, scene->FieldSize);
+		scene->Colliders[i]->SetPosition(p);
+	}
+}
+
+static void NestedLoops(Scene* scene, std::vector<Hit>* hits)
+{
+	hits->clear();
+	for (size_t l = 0; l < scene->PlayerLasers.size(); l++)
+	{
+		Collision* laser = scene->Colliders[scene->PlayerLasers[l]];
+		for (size_t e = 0; e < scene->Enemies.size(); e++)
+		{
+			if (scene->Colliders[scene->Enemies[e]]->CheckCollision(laser))
+				hits->push_back(Hit(scene->PlayerLasers[l], scene->Enemies[e]));
+		}
+	}
+
+	Collision* player = scene->Colliders[scene->Player];
+	for (size_t l = 0; l < scene->EnemyLasers.size(); l++)
+	{
+		if (player->CheckCollision(scene->Colliders[scene->EnemyLasers[l]]))
+			hits->push_back(Hit(scene->EnemyLasers[l], scene->Player));
+	}
+}
+
+static void SweepAndPrune(Scene* scene, std::vector<Hit>* hits)
+{
+	hits->clear();
+	const std::vector<BroadphasePair>& pairs = scene->Phase.FindPairs();
+	for (size_t p = 0; p < pairs.size(); p++)
+	{
+		int a = (int)(size_t)scene->Phase.GetUserData(pairs[p].proxyA);
+		int b = (int)(size_t)scene->Phase.GetUserData(pairs[p].proxyB);
+		unsigned int layerA = scene->Phase.GetLayer(pairs[p].proxyA);
+		bool aIsLaser = layerA == LAYER_PLAYER_LASER || layerA == LAYER_ENEMY_LASER;
+		hits->push_back(aIsLaser ? Hit(a, b) : Hit(b, a));
+	}
+}
+
+int main()
+{
+	std::printf("%8s %10s %14s %14s %9s\n", "colliders", "hits/frame", "nested ms", "sweep ms", "speedup");
+
+	int counts[] = { 1000, 10000, 100000 };
+	for (int c = 0; c < 3; c++)
+	{
+		Scene scene;
+		BuildScene(&scene, counts[c]);
+
+		// The first sweep sorts from scratch, later ones only touch up the order
+		std::vector<Hit> nestedHits, sweepHits;
+		MoveScene(&scene);
+		SweepAndPrune(&scene, &sweepHits);
+
+		// Enough frames for a steady number, but the nested loops get slow
+		int frames = 100000 / counts[c];
+		int nestedFrames = frames > 2 ? frames / 2 : 1;
+		double nestedMs = 0, sweepMs = 0;
+		long long hitCount = 0;
+		bool same = true;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			MoveScene(&scene);
+
+			BenchTimer timer;
+			SweepAndPrune(&scene, &sweepHits);
+			sweepMs += timer.GetMilliseconds();
+			hitCount += (long long)sweepHits.size();
+
+			if (frame < nestedFrames)
+			{
+				timer.Restart();
+				NestedLoops(&scene, &nestedHits);
+				nestedMs += timer.GetMilliseconds();
+
+				std::sort(nestedHits.begin(), nestedHits.end());
+				std::sort(sweepHits.begin(), sweepHits.end());
+				same = same && nestedHits == sweepHits;
+			}
+		}
+
+		nestedMs /= nestedFrames;
+		sweepMs /= frames;
+		std::printf("%8d %10.1f %14.3f %14.3f %8.0fx  %s\n", counts[c], (double)hitCount / frames,
+			nestedMs, sweepMs, nestedMs / sweepMs, same ? "same hits" : "DIFFERENT HITS");
+
+		for (size_t i = 0; i < scene.Colliders.size(); i++)
+			delete scene.Colliders[i];
+		if (!same)
+			return 1;
+	}
+	return 0;
+}
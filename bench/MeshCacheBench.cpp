@@ -0,0 +1,184 @@
+#include "BenchTimer.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshStreaming.h"
+#include "SyntheticObj.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Loading each model from its OBJ against loading it from its
+// .meshcache, following Mesh::Load's steps.  Pass OBJ paths to
+// measure real models, otherwise it writes grids of a few sizes
+// to the working directory.  Both paths map and hash the OBJ,
+// since Mesh does that to check the cache.  The parse path
+// leaves out tangents and bounds (Mesh members that need the
+// rest of the game).
+// --------------------------------------------------------
+struct LoadedMesh
+{
+	std::vector<Vertex> Vertices;
+	std::vector<unsigned int> Indices;
+	unsigned long long Hash;
+};
+
+static bool ParseObj(const char* path, LoadedMesh* mesh)
+{
+	MappedFile obj;
+	if (!obj.Open(path))
+		return false;
+	mesh->Hash = MeshCache::Hash(obj.GetData(), obj.GetSize());
+	if (!MeshStreaming::LoadObj(obj.GetData(), obj.GetSize(), &mesh->Vertices, &mesh->Indices) || mesh->Indices.empty())
+		return false;
+
+	std::vector<Vertex>& verts = mesh->Vertices;
+	std::vector<unsigned int>& indices = mesh->Indices;
+	MeshOptimizer::OptimizeVertexCache(&indices[0], (int)indices.size(), (int)verts.size());
+	MeshOptimizer::OptimizeOverdraw(&verts[0], (int)verts.size(), &indices[0], (int)indices.size());
+	verts.resize(MeshOptimizer::OptimizeVertexFetch(&verts[0], (int)verts.size(), &indices[0], (int)indices.size()));
+	return true;
+}
+
+// Same choice of index size as Mesh::Init
+static bool WriteCache(const char* path, const LoadedMesh& mesh)
+{
+	std::vector<unsigned short> shortIndices;
+	const void* indexData = &mesh.Indices[0];
+	int indexSize = sizeof(unsigned int);
+	if (mesh.Vertices.size() <= 65536)
+	{
+		shortIndices.assign(mesh.Indices.begin(), mesh.Indices.end());
+		indexData = &shortIndices[0];
+		indexSize = sizeof(unsigned short);
+	}
+
+	MeshBounds bounds = {};
+	VertexCacheStats stats = {};
+	return MeshCache::Write(path, mesh.Hash, &mesh.Vertices[0], (int)mesh.Vertices.size(),
+		indexData, (int)mesh.Indices.size(), indexSize, bounds, stats, stats);
+}
+
+// Everything a cached load does before CreateBuffers, plus reading every
+// byte the way the upload would.  Returns false if the cache is rejected
+// or doesn't match what parsing gave.
+static bool LoadCache(const char* objPath, const char* cachePath, const LoadedMesh* expected, unsigned int* checksum)
+{
+	MappedFile obj;
+	if (!obj.Open(objPath))
+		return false;
+	unsigned long long hash = MeshCache::Hash(obj.GetData(), obj.GetSize());
+
+	MeshCache cache;
+	if (!cache.Open(cachePath, hash))
+		return false;
+
+	const MeshCacheHeader& header = cache.GetHeader();
+	const unsigned int* words = (const unsigned int*)cache.GetVertices();
+	size_t wordCount = header.VertexCount * sizeof(Vertex) / sizeof(unsigned int);
+	unsigned int sum = 0;
+	for (size_t i = 0; i < wordCount; i++)
+		sum += words[i];
+	const unsigned char* indexBytes = (const unsigned char*)cache.GetIndices();
+	for (size_t i = 0; i < (size_t)header.IndexCount * header.IndexSize; i++)
+		sum += indexBytes[i];
+	*checksum = sum;
+
+	if (!expected)
+		return true;
+	if (header.VertexCount != expected->Vertices.size() || header.IndexCount != expected->Indices.size() ||
+		memcmp(cache.GetVertices(), &expected->Vertices[0], sizeof(Vertex) * header.VertexCount) != 0)
+		return false;
+	for (unsigned int i = 0; i < header.IndexCount; i++)
+	{
+		unsigned int index = header.IndexSize == 2 ? ((const unsigned short*)indexBytes)[i] : ((const unsigned int*)indexBytes)[i];
+		if (index != expected->Indices[i])
+			return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; i++)
+		paths.push_back(argv[i]);
+
+	if (paths.empty())
+	{
+		const int sizes[][2] = { { 4, 4 }, { 40, 40 }, { 128, 128 }, { 400, 400 } };
+		for (int s = 0; s < 4; s++)
+		{
+			char name[64];
+			snprintf(name, sizeof(name), "grid_%dx%d.obj", sizes[s][0], sizes[s][1]);
+			std::string obj = MakeGridObj(sizes[s][0], sizes[s][1]);
+			FILE* file = fopen(name, "wb");
+			if (!file || fwrite(obj.data(), 1, obj.size(), file) != obj.size())
+			{
+				std::fprintf(stderr, "Can't write %s\n", name);
+				return 1;
+			}
+			fclose(file);
+			paths.push_back(name);
+		}
+	}
+
+	std::printf("best of 5, warm page cache\n");
+	std::printf("%-24s %10s %10s %12s %12s %8s\n", "model", "OBJ KB", "vertices", "parse ms", "cache ms", "speedup");
+	for (size_t p = 0; p < paths.size(); p++)
+	{
+		const char* objPath = paths[p].c_str();
+		std::string cachePath = paths[p] + ".benchcache";
+
+		LoadedMesh parsed;
+		double parseBest = 1e30;
+		for (int run = 0; run < 5; run++)
+		{
+			LoadedMesh mesh;
+			BenchTimer timer;
+			bool ok = ParseObj(objPath, &mesh);
+			double ms = timer.GetMilliseconds();
+			if (!ok)
+			{
+				std::fprintf(stderr, "Can't load %s\n", objPath);
+				return 1;
+			}
+			if (ms < parseBest)
+				parseBest = ms;
+			if (run == 0)
+				parsed = mesh;
+		}
+
+		if (!WriteCache(cachePath.c_str(), parsed))
+		{
+			std::fprintf(stderr, "Can't write %s\n", cachePath.c_str());
+			return 1;
+		}
+
+		unsigned int checksum = 0;
+		if (!LoadCache(objPath, cachePath.c_str(), &parsed, &checksum))
+		{
+			std::fprintf(stderr, "%s doesn't hold what parsing %s gave\n", cachePath.c_str(), objPath);
+			return 1;
+		}
+
+		double cacheBest = 1e30;
+		for (int run = 0; run < 5; run++)
+		{
+			BenchTimer timer;
+			LoadCache(objPath, cachePath.c_str(), 0, &checksum);
+			double ms = timer.GetMilliseconds();
+			if (ms < cacheBest)
+				cacheBest = ms;
+		}
+
+		MappedFile obj;
+		obj.Open(objPath);
+		std::printf("%-24s %10.0f %10d %12.2f %12.3f %7.0fx\n", objPath, obj.GetSize() / 1024.0,
+			(int)parsed.Vertices.size(), parseBest, cacheBest, parseBest / cacheBest);
+		remove(cachePath.c_str());
+	}
+	return 0;
+}
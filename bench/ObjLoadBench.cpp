@@ -0,0 +1,121 @@
+#include "BenchTimer.h"
+#include "SyntheticObj.h"
+#include "tiny_obj_loader.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <streambuf>
+#include <thread>
+
+// --------------------------------------------------------
+// tinyobj::LoadObjParallel at 1 to 16 threads against the
+// serial LoadObj, on a generated OBJ held in memory (1M
+// triangles unless a count is given).  Every parallel result
+// is checked against the serial one.
+// --------------------------------------------------------
+struct ObjResult
+{
+	tinyobj::attrib_t Attrib;
+	std::vector<tinyobj::shape_t> Shapes;
+	std::vector<tinyobj::material_t> Materials;
+	std::string Warn;
+	std::string Err;
+};
+
+class MemoryBuffer : public std::streambuf
+{
+public:
+	MemoryBuffer(const std::string& text)
+	{
+		char* begin = const_cast<char*>(text.data());
+		setg(begin, begin, begin + text.size());
+	}
+};
+
+template <class T>
+static bool SameArray(const std::vector<T>& a, const std::vector<T>& b)
+{
+	return a.size() == b.size() && (a.empty() || memcmp(&a[0], &b[0], sizeof(T) * a.size()) == 0);
+}
+
+static bool SameResult(const ObjResult& a, const ObjResult& b)
+{
+	if (!SameArray(a.Attrib.vertices, b.Attrib.vertices) || !SameArray(a.Attrib.normals, b.Attrib.normals) ||
+		!SameArray(a.Attrib.texcoords, b.Attrib.texcoords) || !SameArray(a.Attrib.colors, b.Attrib.colors) ||
+		a.Shapes.size() != b.Shapes.size() || a.Warn != b.Warn || a.Err != b.Err)
+		return false;
+
+	for (size_t s = 0; s < a.Shapes.size(); s++)
+	{
+		const tinyobj::mesh_t& meshA = a.Shapes[s].mesh;
+		const tinyobj::mesh_t& meshB = b.Shapes[s].mesh;
+		if (a.Shapes[s].name != b.Shapes[s].name || meshA.indices.size() != meshB.indices.size() ||
+			!SameArray(meshA.num_face_vertices, meshB.num_face_vertices) || !SameArray(meshA.material_ids, meshB.material_ids) ||
+			!SameArray(meshA.smoothing_group_ids, meshB.smoothing_group_ids))
+			return false;
+
+		for (size_t i = 0; i < meshA.indices.size(); i++)
+		{
+			const tinyobj::index_t& ia = meshA.indices[i];
+			const tinyobj::index_t& ib = meshB.indices[i];
+			if (ia.vertex_index != ib.vertex_index || ia.normal_index != ib.normal_index || ia.texcoord_index != ib.texcoord_index)
+				return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	int faces = argc > 1 ? atoi(argv[1]) : 1000000;
+	int columns, rows;
+	GridSizeForFaces(faces, &columns, &rows);
+	std::string obj = MakeGridObj(columns, rows);
+	std::printf("%d triangles, %.1f MB of OBJ, %u hardware threads, best of 3\n",
+		columns * rows * 2, obj.size() / 1048576.0, std::thread::hardware_concurrency());
+
+	ObjResult serial;
+	double serialBest = 1e30;
+	for (int run = 0; run < 3; run++)
+	{
+		ObjResult result;
+		MemoryBuffer buffer(obj);
+		std::istream stream(&buffer);
+		BenchTimer timer;
+		tinyobj::LoadObj(&result.Attrib, &result.Shapes, &result.Materials, &result.Warn, &result.Err, &stream);
+		double ms = timer.GetMilliseconds();
+		if (ms < serialBest)
+			serialBest = ms;
+		if (run == 0)
+			serial = result;
+	}
+	std::printf("serial LoadObj      %8.1f ms\n", serialBest);
+
+	double oneThread = 0;
+	unsigned int threadCounts[] = { 1, 2, 4, 8, 16 };
+	for (int t = 0; t < 5; t++)
+	{
+		double best = 1e30;
+		bool same = true;
+		for (int run = 0; run < 3; run++)
+		{
+			ObjResult result;
+			BenchTimer timer;
+			tinyobj::LoadObjParallel(&result.Attrib, &result.Shapes, &result.Materials, &result.Warn, &result.Err,
+				obj.data(), obj.size(), NULL, true, true, threadCounts[t]);
+			double ms = timer.GetMilliseconds();
+			if (ms < best)
+				best = ms;
+			same = same && SameResult(result, serial);
+		}
+
+		if (t == 0)
+			oneThread = best;
+		std::printf("parallel %2u threads %8.1f ms  %5.2fx vs 1 thread  %5.2fx vs serial  %s\n",
+			threadCounts[t], best, oneThread / best, serialBest / best, same ? "identical" : "DIFFERENT");
+		if (!same)
+			return 1;
+	}
+	return 0;
+}
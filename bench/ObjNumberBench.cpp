@@ -0,0 +1,158 @@
+// Reaches tiny_obj_loader's internal number parsing, so this file is the
+// implementation instead of linking tiny_obj_loader.cc
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+
+#include "BenchTimer.h"
+#include "SyntheticObj.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Number parsing alone, on the v, vt and vn lines of a
+// generated OBJ (1M triangles unless a count is given):
+//  - parseReal, which tries tryParseDecimalFast first
+//  - tryParseDecimalFast by itself
+//  - findRealEnd then tryParseDouble, the path every number
+//    took before the fast one
+// Each walks the same lines and keeps every value, and the
+// values are compared with the old path's afterwards.
+// --------------------------------------------------------
+static const int passes = 5;
+
+// Only the v, vt and vn lines of the OBJ, each ending in a '\0' instead of
+// its newline, the way the loader hands lines to the parser
+static std::string NumberLines(const std::string& obj, size_t* lineCount)
+{
+	std::string lines;
+	lines.reserve(obj.size());
+	*lineCount = 0;
+	size_t start = 0;
+	while (start < obj.size())
+	{
+		size_t end = obj.find('\n', start);
+		end = end == std::string::npos ? obj.size() : end;
+		if (obj[start] == 'v')
+		{
+			lines.append(obj, start, end - start);
+			lines += '\0';
+			(*lineCount)++;
+		}
+		start = end + 1;
+	}
+	return lines;
+}
+
+struct FastFirst
+{
+	static tinyobj::real_t Parse(const char** token)
+	{
+		return tinyobj::parseReal(token);
+	}
+};
+
+struct FastOnly
+{
+	static tinyobj::real_t Parse(const char** token)
+	{
+		while (IS_SPACE(**token))
+			(*token)++;
+		double value = 0.0;
+		if (!tinyobj::tryParseDecimalFast(token, &value))
+			(*token) = tinyobj::findRealEnd(*token);
+		return static_cast<tinyobj::real_t>(value);
+	}
+};
+
+struct OldPath
+{
+	static tinyobj::real_t Parse(const char** token)
+	{
+		while (IS_SPACE(**token))
+			(*token)++;
+		const char* end = tinyobj::findRealEnd(*token);
+		double value = 0.0;
+		tinyobj::tryParseDouble(*token, end, &value);
+		(*token) = end;
+		return static_cast<tinyobj::real_t>(value);
+	}
+};
+
+// Walks every line, parsing two numbers after "vt" and three after "v" or
+// "vn", and returns how many it parsed
+template <class Parser>
+static size_t ParseLines(const std::string& lines, tinyobj::real_t* values)
+{
+	size_t count = 0;
+	const char* token = lines.data();
+	const char* end = token + lines.size();
+	while (token < end)
+	{
+		int numbers = token[1] == 't' ? 2 : 3;
+		token += token[1] == ' ' ? 2 : 3;
+		for (int n = 0; n < numbers; n++)
+			values[count++] = Parser::Parse(&token);
+		while (*token++)
+		{
+		}
+	}
+	return count;
+}
+
+template <class Parser>
+static double BestOf(const std::string& lines, std::vector<tinyobj::real_t>& values, size_t* count)
+{
+	double best = 1e30;
+	for (int p = 0; p < passes; p++)
+	{
+		BenchTimer timer;
+		*count = ParseLines<Parser>(lines, &values[0]);
+		double ms = timer.GetMilliseconds();
+		best = ms < best ? ms : best;
+	}
+	return best;
+}
+
+int main(int argc, char** argv)
+{
+	int faces = argc > 1 ? atoi(argv[1]) : 1000000;
+	int columns, rows;
+	GridSizeForFaces(faces, &columns, &rows);
+	size_t lineCount;
+	std::string lines = NumberLines(MakeGridObj(columns, rows), &lineCount);
+	double megabytes = lines.size() / (1024.0 * 1024.0);
+
+	// Three numbers a line is the most there can be
+	size_t maxValues = lineCount * 3;
+	std::vector<tinyobj::real_t> oldValues(maxValues), fastFirstValues(maxValues), fastOnlyValues(maxValues);
+
+	size_t oldCount, fastFirstCount, fastOnlyCount;
+	double oldMs = BestOf<OldPath>(lines, oldValues, &oldCount);
+	double fastFirstMs = BestOf<FastFirst>(lines, fastFirstValues, &fastFirstCount);
+	double fastOnlyMs = BestOf<FastOnly>(lines, fastOnlyValues, &fastOnlyCount);
+
+	// The fast path is correctly rounded and the old one can be an ulp out
+	// in double, so after the cast to real_t they agree closely, mostly exactly
+	bool allClose = fastFirstCount == oldCount && fastOnlyCount == oldCount;
+	size_t identical = 0;
+	for (size_t i = 0; allClose && i < oldCount; i++)
+	{
+		allClose = fastFirstValues[i] == fastOnlyValues[i] && fabs(fastFirstValues[i] - oldValues[i]) <= 1e-6;
+		identical += fastFirstValues[i] == oldValues[i] ? 1 : 0;
+	}
+
+	std::printf("%.1f MB of v/vt/vn lines, %zu numbers, best of %d passes\n", megabytes, oldCount, passes);
+	std::printf("%-32s %10s %10s %10s\n", "parser", "ms", "MB/s", "vs old");
+	std::printf("%-32s %10.2f %10.0f %9.2fx\n", "findRealEnd + tryParseDouble", oldMs, megabytes / (oldMs / 1000.0), 1.0);
+	std::printf("%-32s %10.2f %10.0f %9.2fx\n", "parseReal", fastFirstMs, megabytes / (fastFirstMs / 1000.0), oldMs / fastFirstMs);
+	std::printf("%-32s %10.2f %10.0f %9.2fx\n", "tryParseDecimalFast only", fastOnlyMs, megabytes / (fastOnlyMs / 1000.0), oldMs / fastOnlyMs);
+	if (allClose)
+		std::printf("values agree, %zu of %zu identical to the old path's\n", identical, oldCount);
+	else
+		std::printf("VALUES DIFFER FROM THE OLD PATH\n");
+	return allClose ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+#include "BenchTimer.h"
+#include "ParticleKernels.h"
+#include "Random.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// The particle kernels over 1M particles, one thread.  Each
+// kernel starts from the same spawned particles and runs the
+// same steps, and its results are compared with the scalar
+// kernel's (living particles should match bit for bit).  The
+// wide kernels run once per specialization, then the four
+// billboard expansions run over the result.
+// --------------------------------------------------------
+static const int particleCount = 1 << 20;
+static const int steps = 30;
+static const int arrayCount = 18;	// Floats per particle in ParticleArrays
+static const unsigned int updateFeatures = particleFeatureRotation | particleFeatureAcceleration | particleFeatureColorOverLife;
+
+// Ages all match, and so do the outputs of every particle still alive - the
+// wide kernels also write outputs for lanes that just died, the scalar one
+// doesn't, and nothing reads them either way.  A kernel without
+// ColorOverLife or Rotation leaves the colors or rotation at their spawn
+// values, so only the outputs its features cover are compared.
+static bool SameLivingParticles(const ParticleArrays& a, const ParticleArrays& b, float lifetime, unsigned int features)
+{
+	if (memcmp(a.Age, b.Age, sizeof(float) * a.Capacity) != 0)
+		return false;
+
+	std::vector<const float*> outputsA = { a.X, a.Y, a.Z, a.Size };
+	std::vector<const float*> outputsB = { b.X, b.Y, b.Z, b.Size };
+	if (features & particleFeatureRotation)
+	{
+		outputsA.push_back(a.Rotation);
+		outputsB.push_back(b.Rotation);
+	}
+	if (features & particleFeatureColorOverLife)
+	{
+		outputsA.insert(outputsA.end(), { a.R, a.G, a.B, a.A });
+		outputsB.insert(outputsB.end(), { b.R, b.G, b.B, b.A });
+	}
+
+	for (int i = 0; i < a.Capacity; i++)
+	{
+		if (a.Age[i] >= lifetime)
+			continue;
+		for (size_t o = 0; o < outputsA.size(); o++)
+		{
+			if (memcmp(outputsA[o] + i, outputsB[o] + i, sizeof(float)) != 0)
+				return false;
+		}
+	}
+	return true;
+}
+
+static std::string FeatureNames(unsigned int features)
+{
+	std::string names;
+	if (features & particleFeatureRotation)
+		names += " rotation";
+	if (features & particleFeatureAcceleration)
+		names += " accel";
+	if (features & particleFeatureColorOverLife)
+		names += " color";
+	if (features & particleFeatureSpriteSheet)
+		names += " sprites";
+	return names.empty() ? " none" : names;
+}
+
+struct KernelRun
+{
+	std::string Name;
+	ParticleKernels::UpdateKernel Kernel;
+	unsigned int Features;
+};
+
+int main()
+{
+	ParticleCurves curves;
+	for (int i = 0; i < particleCurveResolution; i++)
+	{
+		float t = i / (float)(particleCurveResolution - 1);
+		curves.R[i] = 1.0f - t;
+		curves.G[i] = t;
+		curves.B[i] = 0.5f;
+		curves.A[i] = 1.0f - t * t;
+		curves.Size[i] = 0.1f + t;
+		curves.Rotation[i] = t * (2.0f - t);
+	}
+
+	// A 2 second lifetime with staggered ages, so some die every step
+	ParticleUpdateParams params;
+	params.DeltaTime = 1.0f / 60.0f;
+	params.Lifetime = 2.0f;
+	params.Curves = &curves;
+	params.Acceleration = DirectX::XMFLOAT3(0.0f, -9.8f, 0.0f);
+	params.Features = particleFeatureAll;
+
+	ParticleArrays spawned;
+	ParticleKernels::Allocate(&spawned, particleCount, params.Lifetime);
+	Random random(5);
+	std::vector<float> randoms((size_t)particleCount * particleSpawnRandoms);
+	random.FillFloats(&randoms[0], (int)randoms.size());
+	ParticleSpawnParams spawn = {};
+	spawn.PositionRange = DirectX::XMFLOAT3(10, 10, 10);
+	spawn.Velocity = DirectX::XMFLOAT3(0, 3, 0);
+	spawn.VelocityRange = DirectX::XMFLOAT3(1, 1, 1);
+	spawn.RotationRanges = DirectX::XMFLOAT4(0, 3.0f, -6.0f, 6.0f);
+	spawn.Size = 1.0f;
+	spawn.Color = DirectX::XMFLOAT4(1, 1, 1, 1);
+	ParticleKernels::Spawn(spawn, spawned, 0, particleCount, &randoms[0]);
+	for (int i = 0; i < particleCount; i++)
+		spawned.Age[i] = randoms[i] * params.Lifetime;
+	size_t bytes = sizeof(float) * spawned.Capacity * arrayCount;
+
+	bool avx2 = ParticleKernels::HasAVX2();
+	std::vector<KernelRun> runs;
+	KernelRun scalar = { "scalar", ParticleKernels::UpdateScalar, updateFeatures };
+	runs.push_back(scalar);
+	for (unsigned int features = 0; features <= updateFeatures; features++)
+	{
+		KernelRun sse = { "SSE" + FeatureNames(features), ParticleKernels::GetUpdateKernelSSE(features), features };
+		runs.push_back(sse);
+	}
+	for (unsigned int features = 0; avx2 && features <= updateFeatures; features++)
+	{
+		KernelRun wide = { "AVX2" + FeatureNames(features), ParticleKernels::GetUpdateKernelAVX2(features), features };
+		runs.push_back(wide);
+	}
+
+	// The scalar kernel does every feature whatever the params say, so only
+	// acceleration changes its results - one reference with, one without
+	ParticleArrays references[2];
+	for (int accelerated = 0; accelerated < 2; accelerated++)
+	{
+		ParticleUpdateParams referenceParams = params;
+		if (!accelerated)
+			referenceParams.Acceleration = DirectX::XMFLOAT3(0, 0, 0);
+		ParticleKernels::Allocate(&references[accelerated], particleCount, params.Lifetime);
+		memcpy(references[accelerated].Age, spawned.Age, bytes);
+		for (int step = 0; step < steps; step++)
+			ParticleKernels::UpdateScalar(referenceParams, references[accelerated], 0, particleCount);
+	}
+
+	std::printf("%d particles, %d steps, AVX2 %s\n", particleCount, steps, avx2 ? "available" : "not available");
+	std::printf("%-30s %10s %12s %10s\n", "update kernel", "ms/step", "Mparticles/s", "vs scalar");
+
+	ParticleArrays particles;
+	ParticleKernels::Allocate(&particles, particleCount, params.Lifetime);
+	double scalarMs = 0;
+	bool allSame = true;
+	for (size_t r = 0; r < runs.size(); r++)
+	{
+		// Leaving a feature out is only exact for effects that don't use it
+		ParticleUpdateParams runParams = params;
+		runParams.Features = runs[r].Features;
+		bool accelerated = (runs[r].Features & particleFeatureAcceleration) != 0;
+		if (!accelerated)
+			runParams.Acceleration = DirectX::XMFLOAT3(0, 0, 0);
+
+		memcpy(particles.Age, spawned.Age, bytes);
+		BenchTimer timer;
+		for (int step = 0; step < steps; step++)
+			runs[r].Kernel(runParams, particles, 0, particleCount);
+		double perStep = timer.GetMilliseconds() / steps;
+		if (r == 0)
+			scalarMs = perStep;
+
+		bool same = SameLivingParticles(particles, references[accelerated ? 1 : 0], params.Lifetime, runs[r].Features);
+		allSame = allSame && same;
+		std::printf("%-30s %10.2f %12.0f %9.2fx  %s\n", runs[r].Name.c_str(), perStep,
+			particleCount / perStep / 1000.0, scalarMs / perStep, same ? "matches scalar" : "DIFFERS FROM SCALAR");
+	}
+
+	// Each ExpandBillboardQuads specialization over the fully updated particles
+	DirectX::XMFLOAT2 frames[16];
+	for (int f = 0; f < 16; f++)
+		frames[f] = DirectX::XMFLOAT2((f % 4) * 0.25f, (f / 4) * 0.25f);
+	BillboardParams billboard;
+	billboard.CameraRight = DirectX::XMFLOAT3(1, 0, 0);
+	billboard.CameraUp = DirectX::XMFLOAT3(0, 1, 0);
+	billboard.Lifetime = params.Lifetime;
+	billboard.Frames = frames;
+	billboard.FrameCount = 16;
+	billboard.FrameSize = DirectX::XMFLOAT2(0.25f, 0.25f);
+
+	std::vector<ParticleVertex> vertices((size_t)particleCount * 4);
+	const unsigned int expandFeatures[] = { 0, particleFeatureRotation, particleFeatureSpriteSheet, particleFeatureRotation | particleFeatureSpriteSheet };
+	std::printf("\n%-30s %10s %12s %10s\n", "billboard expansion", "ms", "Mparticles/s", "MB/s out");
+	for (int e = 0; e < 4; e++)
+	{
+		billboard.Features = expandFeatures[e];
+		BenchTimer timer;
+		for (int step = 0; step < steps; step++)
+			ParticleKernels::ExpandBillboards(billboard, references[1], 0, particleCount, &vertices[0]);
+		double perStep = timer.GetMilliseconds() / steps;
+		double megabytes = vertices.size() * sizeof(ParticleVertex) / (1024.0 * 1024.0);
+		std::printf("%-30s %10.2f %12.0f %10.0f\n", ("expand" + FeatureNames(expandFeatures[e])).c_str(), perStep,
+			particleCount / perStep / 1000.0, megabytes / (perStep / 1000.0));
+	}
+
+	ParticleKernels::Free(&references[1]);
+	ParticleKernels::Free(&references[0]);
+	ParticleKernels::Free(&particles);
+	ParticleKernels::Free(&spawned);
+	return allSame ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+#include "BenchTimer.h"
+#include "ParticleKernels.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+// --------------------------------------------------------
+// The sorted mode's per-particle work over 100k particles,
+// one thread: ViewDepths, DepthKeys, then RadixSort of the
+// keys carrying particle indices (as ParticleSystem does),
+// with std::stable_sort on the float depths for comparison.
+//
+// The result has to be back to front - a key going up means
+// the depth went down - and stable: particles with the same
+// key stay in index order.  100k particles over 65536 keys
+// gives plenty of ties to check that on.
+// --------------------------------------------------------
+static const int particleCount = 100000;
+static const int repeats = 200;
+
+struct Stage
+{
+	const char* Name;
+	double Total;
+	double Best;
+};
+
+static void Record(Stage& stage, double ms)
+{
+	stage.Total += ms;
+	stage.Best = ms < stage.Best ? ms : stage.Best;
+}
+
+// Checks the sorted keys and order against the depths they came from
+static bool BackToFrontAndStable(const float* depths, const unsigned short* keys, const unsigned int* order, int count, int* ties)
+{
+	std::vector<bool> seen(count, false);
+	*ties = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (order[i] >= (unsigned int)count || seen[order[i]])
+			return false;
+		seen[order[i]] = true;
+		if (i == 0)
+			continue;
+
+		if (keys[i] < keys[i - 1])
+			return false;
+		if (keys[i] == keys[i - 1])
+		{
+			(*ties)++;
+			if (order[i] < order[i - 1])
+				return false;
+		}
+		else if (!(depths[order[i]] < depths[order[i - 1]]))
+			return false;
+	}
+	return true;
+}
+
+static bool FartherFirst(const std::pair<float, unsigned int>& a, const std::pair<float, unsigned int>& b)
+{
+	return a.first > b.first;
+}
+
+int main()
+{
+	ParticleArrays particles;
+	ParticleKernels::Allocate(&particles, particleCount, 1.0f);
+	Random random(13);
+	for (int i = 0; i < particleCount; i++)
+	{
+		particles.X[i] = random.Range(-50.0f, 50.0f);
+		particles.Y[i] = random.Range(-50.0f, 50.0f);
+		particles.Z[i] = random.Range(0.0f, 200.0f);
+	}
+
+	DirectX::XMFLOAT3 forward(0.3f, -0.2f, 1.0f);
+	float length = sqrtf(forward.x * forward.x + forward.y * forward.y + forward.z * forward.z);
+	forward = DirectX::XMFLOAT3(forward.x / length, forward.y / length, forward.z / length);
+
+	std::vector<float> depths(particleCount);
+	std::vector<unsigned short> keys(particleCount), keyScratch(particleCount);
+	std::vector<unsigned int> order(particleCount), orderScratch(particleCount);
+	std::vector<std::pair<float, unsigned int> > byDepth(particleCount);
+
+	Stage depthStage = { "ViewDepths", 0, 1e30 };
+	Stage keyStage = { "DepthKeys", 0, 1e30 };
+	Stage sortStage = { "RadixSort", 0, 1e30 };
+	Stage stableStage = { "std::stable_sort of depths", 0, 1e30 };
+	bool allGood = true;
+	int ties = 0;
+	BenchTimer timer;
+	for (int r = 0; r < repeats; r++)
+	{
+		timer.Restart();
+		ParticleKernels::ViewDepths(forward, particles, 0, particleCount, &depths[0]);
+		Record(depthStage, timer.GetMilliseconds());
+
+		timer.Restart();
+		ParticleKernels::DepthKeys(&depths[0], particleCount, &keys[0]);
+		Record(keyStage, timer.GetMilliseconds());
+
+		for (int i = 0; i < particleCount; i++)
+			order[i] = i;
+		timer.Restart();
+		ParticleKernels::RadixSort(&keys[0], &order[0], &keyScratch[0], &orderScratch[0], particleCount);
+		Record(sortStage, timer.GetMilliseconds());
+
+		allGood = allGood && BackToFrontAndStable(&depths[0], &keys[0], &order[0], particleCount, &ties);
+
+		for (int i = 0; i < particleCount; i++)
+			byDepth[i] = std::make_pair(depths[i], (unsigned int)i);
+		timer.Restart();
+		std::stable_sort(byDepth.begin(), byDepth.end(), FartherFirst);
+		Record(stableStage, timer.GetMilliseconds());
+	}
+
+	std::printf("%d particles, %d repeats, %d equal-key neighbours\n", particleCount, repeats, ties);
+	std::printf("%-30s %10s %10s\n", "stage", "mean us", "best us");
+	Stage* stages[] = { &depthStage, &keyStage, &sortStage, &stableStage };
+	for (int s = 0; s < 4; s++)
+		std::printf("%-30s %10.1f %10.1f\n", stages[s]->Name, stages[s]->Total / repeats * 1000.0, stages[s]->Best * 1000.0);
+	double sorted = (depthStage.Total + keyStage.Total + sortStage.Total) / repeats;
+	std::printf("%-30s %10.1f\n", "depths + keys + radix", sorted * 1000.0);
+	std::printf("%s\n", allGood ? "back to front and stable" : "ORDER IS WRONG");
+
+	ParticleKernels::Free(&particles);
+	return allGood ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+// --------------------------------------------------------
+// OBJ text for the benchmarks, since the game's models aren't
+// checked in.  A wavy grid of columns x rows quads, written as
+// two triangles each, with a position, UV and normal for every
+// grid point - about what an exporter writes for a smooth mesh.
+// --------------------------------------------------------
+inline std::string MakeGridObj(int columns, int rows)
+{
+	std::string obj;
+	obj.reserve((size_t)(columns + 1) * (rows + 1) * 90 + (size_t)columns * rows * 2 * 60);
+
+	char line[128];
+	for (int y = 0; y <= rows; y++)
+	{
+		for (int x = 0; x <= columns; x++)
+		{
+			snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", (float)x / columns, (float)y / rows, sinf(x * 0.1f) * cosf(y * 0.1f));
+			obj += line;
+		}
+	}
+	for (int y = 0; y <= rows; y++)
+	{
+		for (int x = 0; x <= columns; x++)
+		{
+			snprintf(line, sizeof(line), "vt %.6f %.6f\n", (float)x / columns, (float)y / rows);
+			obj += line;
+		}
+	}
+	for (int y = 0; y <= rows; y++)
+	{
+		for (int x = 0; x <= columns; x++)
+		{
+			float nx = -0.1f * cosf(x * 0.1f) * cosf(y * 0.1f);
+			float ny = 0.1f * sinf(x * 0.1f) * sinf(y * 0.1f);
+			float length = sqrtf(nx * nx + ny * ny + 1.0f);
+			snprintf(line, sizeof(line), "vn %.6f %.6f %.6f\n", nx / length, ny / length, 1.0f / length);
+			obj += line;
+		}
+	}
+
+	int stride = columns + 1;
+	for (int y = 0; y < rows; y++)
+	{
+		for (int x = 0; x < columns; x++)
+		{
+			int a = y * stride + x + 1;
+			int b = a + 1;
+			int c = a + stride;
+			int d = c + 1;
+			snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, c, c, c, b, b, b);
+			obj += line;
+			snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d\n", b, b, b, c, c, c, d, d, d);
+			obj += line;
+		}
+	}
+	return obj;
+}
+
+// Columns and rows for a grid with about this many triangles
+inline void GridSizeForFaces(int faces, int* columns, int* rows)
+{
+	*columns = (int)sqrtf(faces / 2.0f) + 1;
+	*rows = (faces / 2 + *columns - 1) / *columns;
+}
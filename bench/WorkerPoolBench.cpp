@@ -0,0 +1,106 @@
+#include "BenchTimer.h"
+#include "ParticleKernels.h"
+#include "Random.h"
+#include "WorkerPool.h"
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------
+// How the particle update and billboard expansion scale with
+// the number of threads in the pool.  Particles are split into
+// fixed size chunks the same way ParticleSystem batches its
+// jobs, and each thread count runs the same number of steps.
+// --------------------------------------------------------
+static const int particleCount = 1 << 20;
+static const int chunkSize = 8192;
+static const int steps = 60;
+
+struct Simulation
+{
+	ParticleArrays Particles;
+	ParticleUpdateParams Params;
+	ParticleCurves Curves;
+	BillboardParams Billboard;
+	DirectX::XMFLOAT2 Frame;
+	std::vector<ParticleVertex> Vertices;
+};
+
+static void StepChunk(void* context, int index)
+{
+	Simulation* sim = (Simulation*)context;
+	int first = index * chunkSize;
+	int count = particleCount - first < chunkSize ? particleCount - first : chunkSize;
+	ParticleKernels::Update(sim->Params, sim->Particles, first, count);
+	ParticleKernels::ExpandBillboards(sim->Billboard, sim->Particles, first, count, &sim->Vertices[first * 4]);
+}
+
+int main()
+{
+	Simulation sim;
+	const float lifetime = 1000.0f;	// Nobody dies, so every step does the same work
+	ParticleKernels::Allocate(&sim.Particles, particleCount, lifetime);
+
+	for (int i = 0; i < particleCurveResolution; i++)
+	{
+		float t = i / (float)(particleCurveResolution - 1);
+		sim.Curves.R[i] = 1.0f - t;
+		sim.Curves.G[i] = t;
+		sim.Curves.B[i] = 0.5f;
+		sim.Curves.A[i] = 1.0f - t * t;
+		sim.Curves.Size[i] = 0.1f + t;
+		sim.Curves.Rotation[i] = t;
+	}
+	sim.Params.DeltaTime = 1.0f / 60.0f;
+	sim.Params.Lifetime = lifetime;
+	sim.Params.Curves = &sim.Curves;
+	sim.Params.Acceleration = DirectX::XMFLOAT3(0.0f, -9.8f, 0.0f);
+	sim.Params.Features = particleFeatureAll;
+
+	sim.Frame = DirectX::XMFLOAT2(0, 0);
+	sim.Billboard = BillboardParams();
+	sim.Billboard.CameraRight = DirectX::XMFLOAT3(1, 0, 0);
+	sim.Billboard.CameraUp = DirectX::XMFLOAT3(0, 1, 0);
+	sim.Billboard.Lifetime = lifetime;
+	sim.Billboard.Frames = &sim.Frame;
+	sim.Billboard.FrameCount = 1;
+	sim.Billboard.FrameSize = DirectX::XMFLOAT2(1, 1);
+	sim.Billboard.Features = particleFeatureRotation;
+
+	Random random(7);
+	std::vector<float> randoms((size_t)particleCount * particleSpawnRandoms);
+	random.FillFloats(&randoms[0], (int)randoms.size());
+	ParticleSpawnParams spawn = {};
+	spawn.PositionRange = DirectX::XMFLOAT3(10, 10, 10);
+	spawn.VelocityRange = DirectX::XMFLOAT3(1, 1, 1);
+	spawn.RotationRanges = DirectX::XMFLOAT4(0, 3.0f, -6.0f, 6.0f);
+	spawn.Size = 1.0f;
+	spawn.Color = DirectX::XMFLOAT4(1, 1, 1, 1);
+	ParticleKernels::Spawn(spawn, sim.Particles, 0, particleCount, &randoms[0]);
+	sim.Vertices.resize((size_t)particleCount * 4);
+
+	int chunks = (particleCount + chunkSize - 1) / chunkSize;
+	std::printf("%d particles, %d chunks, %u hardware threads\n", particleCount, chunks, std::thread::hardware_concurrency());
+	std::printf("threads   ms/step   speedup\n");
+
+	double baseline = 0;
+	int threadCounts[] = { 1, 2, 4, 8, 16 };
+	for (int t = 0; t < 5; t++)
+	{
+		WorkerPool pool(threadCounts[t] - 1);
+		pool.ParallelFor(chunks, StepChunk, &sim);	// Warm up
+
+		BenchTimer timer;
+		for (int step = 0; step < steps; step++)
+			pool.ParallelFor(chunks, StepChunk, &sim);
+		double perStep = timer.GetMilliseconds() / steps;
+
+		if (t == 0)
+			baseline = perStep;
+		std::printf("%7d %9.2f %8.2fx\n", threadCounts[t], perStep, baseline / perStep);
+	}
+
+	ParticleKernels::Free(&sim.Particles);
+	return 0;
+}
@@ -0,0 +1,125 @@
+#include "BenchTimer.h"
+#include "Random.h"
+#include "World.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// --------------------------------------------------------
+// World::UpdateTransforms with the dirty flag against
+// rebuilding every matrix every frame, the way it worked
+// before.  10k entities with a random scale and rotation,
+// some fraction of them moving (so UpdateMovement marks them
+// dirty each frame) and the rest standing still.
+//
+// Two worlds get the same entities and the same frames, one
+// with everything marked dirty before each UpdateTransforms,
+// and their matrices are compared after every frame.
+// --------------------------------------------------------
+static const int entityCount = 10000;
+static const int frames = 200;
+static const float deltaTime = 1.0f / 60.0f;
+
+static void Populate(World* world, float movingFraction)
+{
+	Random random(21);
+	int moving = (int)(entityCount * movingFraction + 0.5f);
+	for (int i = 0; i < entityCount; i++)
+	{
+		bool moves = i < moving;
+		EntityHandle entity = world->Create(moves ? COMPONENT_TRANSFORM | COMPONENT_VELOCITY : COMPONENT_TRANSFORM);
+		TransformComponent* transform = world->GetTransform(entity);
+		transform->Position = DirectX::XMFLOAT3(random.Range(-50.0f, 50.0f), random.Range(-50.0f, 50.0f), random.Range(0.0f, 100.0f));
+		float scale = random.Range(0.5f, 2.0f);
+		transform->Scale = DirectX::XMFLOAT3(scale, scale, scale);
+
+		// A random unit quaternion
+		float x = random.Range(-1.0f, 1.0f), y = random.Range(-1.0f, 1.0f), z = random.Range(-1.0f, 1.0f), w = random.Range(-1.0f, 1.0f);
+		float length = sqrtf(x * x + y * y + z * z + w * w);
+		transform->Rotation = DirectX::XMFLOAT4(x / length, y / length, z / length, w / length);
+
+		if (moves)
+			world->GetVelocity(entity)->Velocity = DirectX::XMFLOAT3(random.Range(-5.0f, 5.0f), random.Range(-5.0f, 5.0f), 0.0f);
+	}
+}
+
+static void MarkAllDirty(World* world)
+{
+	for (int a = 0; a < world->GetArchetypeCount(); a++)
+	{
+		Archetype* archetype = world->GetArchetype(a);
+		for (size_t i = 0; i < archetype->Transforms.size(); i++)
+			archetype->Transforms[i].Dirty = true;
+	}
+}
+
+static bool SameMatrices(World* a, World* b)
+{
+	if (a->GetArchetypeCount() != b->GetArchetypeCount())
+		return false;
+	for (int i = 0; i < a->GetArchetypeCount(); i++)
+	{
+		std::vector<TransformComponent>& left = a->GetArchetype(i)->Transforms;
+		std::vector<TransformComponent>& right = b->GetArchetype(i)->Transforms;
+		if (left.size() != right.size())
+			return false;
+		for (size_t t = 0; t < left.size(); t++)
+		{
+			if (memcmp(&left[t].World, &right[t].World, sizeof(DirectX::XMFLOAT4X4)) != 0)
+				return false;
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	const float movingFractions[] = { 0.0f, 0.1f, 0.5f, 1.0f };
+	bool allSame = true;
+
+	std::printf("%d entities, %d frames\n", entityCount, frames);
+	std::printf("%8s %16s %16s %12s %12s %9s\n", "moving", "rebuilt before", "rebuilt after", "before ms", "after ms", "speedup");
+	for (int f = 0; f < 4; f++)
+	{
+		Broadphase beforePhase, afterPhase;
+		World before(&beforePhase, entityCount);
+		World after(&afterPhase, entityCount);
+		Populate(&before, movingFractions[f]);
+		Populate(&after, movingFractions[f]);
+
+		// Every matrix starts out dirty, so the first frame builds them all
+		before.UpdateTransforms();
+		after.UpdateTransforms();
+
+		double beforeMs = 0, afterMs = 0;
+		long long beforeRebuilt = 0, afterRebuilt = 0;
+		bool same = true;
+		BenchTimer timer;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			before.UpdateMovement(deltaTime);
+			after.UpdateMovement(deltaTime);
+
+			MarkAllDirty(&before);
+			timer.Restart();
+			before.UpdateTransforms();
+			beforeMs += timer.GetMilliseconds();
+			beforeRebuilt += before.GetMatricesRebuilt();
+
+			timer.Restart();
+			after.UpdateTransforms();
+			afterMs += timer.GetMilliseconds();
+			afterRebuilt += after.GetMatricesRebuilt();
+
+			same = same && SameMatrices(&before, &after);
+		}
+		allSame = allSame && same;
+
+		std::printf("%7.0f%% %10lld/%-5d %10lld/%-5d %12.3f %12.3f %8.1fx  %s\n", movingFractions[f] * 100.0f,
+			beforeRebuilt / frames, entityCount, afterRebuilt / frames, entityCount,
+			beforeMs / frames, afterMs / frames, beforeMs / afterMs, same ? "same matrices" : "MATRICES DIFFER");
+	}
+	return allSame ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+#include "AllocationCounter.h"
+#include "MeshStreaming.h"
+#include "MeshWelding.h"
+#include "TestCheck.h"
+
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <streambuf>
+#include <string>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+// --------------------------------------------------------
+// Memory use of loading an OBJ - MeshStreaming against what
+// Mesh did before (tinyobj::LoadObj, then WeldCorners).  Heap
+// numbers come from AllocationCounter, which this target builds
+// with DEBUG defined.
+// --------------------------------------------------------
+
+// Peak resident set size of the whole process so far, in KB
+static long PeakRssKB()
+{
+#if !defined(_WIN32)
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+#else
+	return 0;
+#endif
+}
+
+// Lets tinyobj read the OBJ text without copying it
+class MemoryBuffer : public std::streambuf
+{
+public:
+	MemoryBuffer(const std::string& text)
+	{
+		char* begin = const_cast<char*>(text.data());
+		setg(begin, begin, begin + text.size());
+	}
+};
+
+// --------------------------------------------------------
+// A UV sphere in quads (triangles around the poles), with the
+// seam and poles duplicated in "vt" like an exporter writes them.  Optionally leaves the
+// normals out, and adds a convex pentagon and hexagon cap so
+// the fans get tested beyond quads.
+// --------------------------------------------------------
+static std::string MakeSphereObj(int rings, int segments, bool normals, bool polygonCaps)
+{
+	std::string obj = "# generated\no sphere\n";
+	char line[160];
+	for (int r = 0; r <= rings; r++)
+	{
+		float phi = 3.14159265f * r / rings;
+		for (int s = 0; s <= segments; s++)
+		{
+			float theta = 6.2831853f * s / segments;
+			float x = sinf(phi) * cosf(theta), y = cosf(phi), z = sinf(phi) * sinf(theta);
+			snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", x * 2.0f, y * 2.0f, z * 2.0f);
+			obj += line;
+			snprintf(line, sizeof(line), "vt %.6f %.6f\n", (float)s / segments, (float)r / rings);
+			obj += line;
+			if (normals)
+			{
+				snprintf(line, sizeof(line), "vn %.6f %.6f %.6f\n", x, y, z);
+				obj += line;
+			}
+		}
+	}
+
+	int columns = segments + 1;
+	for (int r = 0; r < rings; r++)
+	{
+		for (int s = 0; s < segments; s++)
+		{
+			// Quads, except the ones touching a pole would have two corners
+			// in the same place, so those are triangles
+			int corners[4] = { r * columns + s + 1, (r + 1) * columns + s + 1, (r + 1) * columns + s + 2, r * columns + s + 2 };
+			int count = 4;
+			if (r == 0)
+			{
+				corners[0] = corners[3];
+				count = 3;
+			}
+			else if (r == rings - 1)
+			{
+				corners[2] = corners[3];
+				count = 3;
+			}
+
+			obj += "f";
+			for (int c = 0; c < count; c++)
+			{
+				int i = corners[c];
+				if (normals)
+					snprintf(line, sizeof(line), " %d/%d/%d", i, i, i);
+				else
+					snprintf(line, sizeof(line), " %d/%d", i, i);
+				obj += line;
+			}
+			obj += "\n";
+		}
+	}
+
+	if (polygonCaps)
+	{
+		int base = (rings + 1) * columns;
+		const int sides[] = { 5, 6 };
+		for (int p = 0; p < 2; p++)
+		{
+			for (int i = 0; i < sides[p]; i++)
+			{
+				float angle = 6.2831853f * i / sides[p];
+				snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", cosf(angle), 3.0f + p, sinf(angle));
+				obj += line;
+			}
+			obj += "f";
+			for (int i = 0; i < sides[p]; i++)
+			{
+				snprintf(line, sizeof(line), " %d", base + i + 1);
+				obj += line;
+			}
+			obj += "\n";
+			base += sides[p];
+		}
+	}
+	return obj;
+}
+
+static bool OldLoad(const std::string& obj, std::vector<Vertex>* vertices, std::vector<unsigned int>* indices)
+{
+	MemoryBuffer buffer(obj);
+	std::istream stream(&buffer);
+	tinyobj::attrib_t attrib;
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+	std::string warn, err;
+	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &stream))
+		return false;
+	MeshWelding::WeldCorners(attrib, shapes, vertices, indices);
+	return true;
+}
+
+// Streaming gives exactly what the old path gave
+static void TestSameResults()
+{
+	std::string objs[] = {
+		MakeSphereObj(8, 12, true, false),
+		MakeSphereObj(20, 33, false, true),
+		MakeSphereObj(3, 4, true, true) };
+
+	for (int i = 0; i < 3; i++)
+	{
+		std::vector<Vertex> oldVertices, newVertices;
+		std::vector<unsigned int> oldIndices, newIndices;
+		CHECK(OldLoad(objs[i], &oldVertices, &oldIndices));
+		CHECK(MeshStreaming::LoadObj(objs[i].data(), objs[i].size(), &newVertices, &newIndices));
+
+		CHECK(!newVertices.empty());
+		CHECK(oldIndices == newIndices);
+		CHECK(oldVertices.size() == newVertices.size());
+		if (oldVertices.size() == newVertices.size() && !newVertices.empty())
+			CHECK(memcmp(&oldVertices[0], &newVertices[0], sizeof(Vertex) * newVertices.size()) == 0);
+	}
+
+	// A face pointing past the attributes is refused, not read out of bounds
+	std::string bad = "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n";
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	CHECK(!MeshStreaming::LoadObj(bad.data(), bad.size(), &vertices, &indices));
+}
+
+// --------------------------------------------------------
+// Peak heap while loading, heap kept afterwards, and whether
+// loading over and over settles back to where it started
+// --------------------------------------------------------
+static void TestMemory()
+{
+	std::string obj = MakeSphereObj(300, 400, true, false);
+
+	// Streaming first, so the old path's bigger peak doesn't hide its RSS
+	long long startHeap = AllocationCounter::GetLiveBytes();
+	long startRss = PeakRssKB();
+	long long streamPeak = 0;
+	size_t outputBytes = 0;
+	for (int pass = 0; pass < 5; pass++)
+	{
+		AllocationCounter::ResetPeakBytes();
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		CHECK(MeshStreaming::LoadObj(obj.data(), obj.size(), &vertices, &indices));
+		streamPeak = AllocationCounter::GetPeakBytes() - startHeap;
+
+		// Nothing but the results is left on the heap
+		outputBytes = vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int);
+		CHECK(AllocationCounter::GetLiveBytes() - startHeap == (long long)outputBytes);
+	}
+	CHECK(AllocationCounter::GetLiveBytes() == startHeap);
+	long streamRss = PeakRssKB();
+
+	long long oldPeak = 0, oldKept = 0;
+	{
+		AllocationCounter::ResetPeakBytes();
+		MemoryBuffer buffer(obj);
+		std::istream stream(&buffer);
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warn, err;
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		CHECK(tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &stream));
+		MeshWelding::WeldCorners(attrib, shapes, &vertices, &indices);
+
+		// Mesh held on to all of this, plus a copy of the vertices
+		std::vector<Vertex> vertsFromMesh(vertices);
+		oldPeak = AllocationCounter::GetPeakBytes() - startHeap;
+		oldKept = AllocationCounter::GetLiveBytes() - startHeap - (long long)(vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int));
+	}
+	long oldRss = PeakRssKB();
+
+	std::printf("%.1f MB OBJ -> %.1f MB of vertices and indices\n", obj.size() / 1048576.0, outputBytes / 1048576.0);
+	std::printf("  streaming: heap peak %.1f MB, kept 0 MB, peak RSS +%.1f MB\n", streamPeak / 1048576.0, (streamRss - startRss) / 1024.0);
+	std::printf("  old:       heap peak %.1f MB, kept %.1f MB, peak RSS +%.1f MB\n", oldPeak / 1048576.0, oldKept / 1048576.0, (oldRss - streamRss) / 1024.0);
+
+	// The results, the welder and the compact attribute arrays
+	CHECK(streamPeak < oldPeak / 2);
+	CHECK(streamPeak < (long long)outputBytes * 3);
+}
+
+int main()
+{
+	TestSameResults();
+	TestMemory();
+
+	if (TestFailures() == 0)
+		std::printf("MeshLoadMemory: all passed\n");
+	return TestFailures();
+}
@@ -0,0 +1,197 @@
+#include "MeshOptimizer.h"
+#include "Random.h"
+#include "TestCheck.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+struct Triangle
+{
+	unsigned int A, B, C;
+
+	bool operator<(const Triangle& other) const
+	{
+		if (A != other.A) return A < other.A;
+		if (B != other.B) return B < other.B;
+		return C < other.C;
+	}
+	bool operator==(const Triangle& other) const
+	{
+		return A == other.A && B == other.B && C == other.C;
+	}
+};
+
+// --------------------------------------------------------
+// A welded UV sphere with its triangles shuffled, so the
+// starting order has next to no cache reuse
+// --------------------------------------------------------
+static void MakeShuffledSphere(int slices, int stacks, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	vertices.clear();
+	indices.clear();
+	for (int stack = 0; stack <= stacks; stack++)
+	{
+		float phi = XM_PI * stack / stacks;
+		for (int slice = 0; slice <= slices; slice++)
+		{
+			float theta = XM_2PI * slice / slices;
+			Vertex v = {};
+			v.Normal = XMFLOAT3(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta));
+			v.Position = v.Normal;
+			v.UV = XMFLOAT2((float)slice / slices, (float)stack / stacks);
+			vertices.push_back(v);
+		}
+	}
+
+	std::vector<Triangle> triangles;
+	int row = slices + 1;
+	for (int stack = 0; stack < stacks; stack++)
+	{
+		for (int slice = 0; slice < slices; slice++)
+		{
+			unsigned int a = stack * row + slice;
+			unsigned int b = a + 1;
+			unsigned int c = a + row;
+			unsigned int d = c + 1;
+			if (stack != 0)
+				triangles.push_back({ a, b, c });
+			if (stack != stacks - 1)
+				triangles.push_back({ b, d, c });
+		}
+	}
+
+	Random random(5);
+	for (size_t i = triangles.size() - 1; i > 0; i--)
+		std::swap(triangles[i], triangles[random.NextUInt() % (i + 1)]);
+	for (size_t i = 0; i < triangles.size(); i++)
+	{
+		indices.push_back(triangles[i].A);
+		indices.push_back(triangles[i].B);
+		indices.push_back(triangles[i].C);
+	}
+}
+
+// Same triangles, same winding, any order
+static bool SameTriangles(const std::vector<unsigned int>& a, const std::vector<unsigned int>& b)
+{
+	if (a.size() != b.size())
+		return false;
+
+	std::vector<Triangle> left(a.size() / 3);
+	std::vector<Triangle> right(b.size() / 3);
+	for (size_t t = 0; t < left.size(); t++)
+	{
+		left[t] = { a[t * 3], a[t * 3 + 1], a[t * 3 + 2] };
+		right[t] = { b[t * 3], b[t * 3 + 1], b[t * 3 + 2] };
+	}
+	std::sort(left.begin(), left.end());
+	std::sort(right.begin(), right.end());
+	return left == right;
+}
+
+static float MeasureACMR(const std::vector<unsigned int>& indices, int vertexCount)
+{
+	return MeshOptimizer::AnalyzeVertexCache(indices.data(), (int)indices.size(), vertexCount).ACMR;
+}
+
+// --------------------------------------------------------
+// Both triangle passes only reorder - and on a shuffled
+// sphere the cache pass brings ACMR well down, with the
+// overdraw pass giving back only part of it
+// --------------------------------------------------------
+static void TestTriangleOrder()
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> original;
+	MakeShuffledSphere(48, 32, vertices, original);
+	int vertexCount = (int)vertices.size();
+
+	std::vector<unsigned int> indices = original;
+	MeshOptimizer::OptimizeVertexCache(indices.data(), (int)indices.size(), vertexCount);
+	CHECK(SameTriangles(original, indices));
+
+	float before = MeasureACMR(original, vertexCount);
+	float afterCache = MeasureACMR(indices, vertexCount);
+	CHECK(before > 2.0f);
+	CHECK(afterCache < 1.0f);
+	CHECK(afterCache < before);
+
+	MeshOptimizer::OptimizeOverdraw(vertices.data(), vertexCount, indices.data(), (int)indices.size());
+	CHECK(SameTriangles(original, indices));
+	CHECK(MeasureACMR(indices, vertexCount) < before);
+
+	// A mesh too small to cluster comes through untouched
+	std::vector<unsigned int> single(original.begin(), original.begin() + 3);
+	std::vector<unsigned int> copy = single;
+	MeshOptimizer::OptimizeVertexCache(copy.data(), 3, vertexCount);
+	MeshOptimizer::OptimizeOverdraw(vertices.data(), vertexCount, copy.data(), 3);
+	CHECK(copy == single);
+}
+
+// --------------------------------------------------------
+// Vertices come out in the order the indices first use
+// them, every triangle still points at the same data, and
+// vertices no triangle uses are gone
+// --------------------------------------------------------
+static void TestVertexFetch()
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	MakeShuffledSphere(16, 12, vertices, indices);
+
+	// Some unused vertices, at the end and in the middle
+	Vertex unused = {};
+	unused.Position = XMFLOAT3(100, 100, 100);
+	unsigned int middle = (unsigned int)vertices.size() / 2;
+	vertices.push_back(unused);
+	vertices.insert(vertices.begin() + middle, unused);
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		if (indices[i] >= middle)
+			indices[i]++;
+	}
+
+	std::vector<bool> referenced(vertices.size(), false);
+	for (size_t i = 0; i < indices.size(); i++)
+		referenced[indices[i]] = true;
+	int usedCount = (int)std::count(referenced.begin(), referenced.end(), true);
+	CHECK(usedCount <= (int)vertices.size() - 2);
+
+	std::vector<Vertex> originalVertices = vertices;
+	std::vector<unsigned int> originalIndices = indices;
+	int count = MeshOptimizer::OptimizeVertexFetch(vertices.data(), (int)vertices.size(), indices.data(), (int)indices.size());
+	CHECK(count == usedCount);
+
+	unsigned int next = 0;
+	bool firstUse = true;
+	bool sameData = true;
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		if (indices[i] > next)
+			firstUse = false;
+		else if (indices[i] == next)
+			next++;
+
+		const XMFLOAT3& now = vertices[indices[i]].Position;
+		const XMFLOAT3& was = originalVertices[originalIndices[i]].Position;
+		sameData &= now.x == was.x && now.y == was.y && now.z == was.z;
+	}
+	CHECK(firstUse);
+	CHECK(sameData);
+	CHECK((int)next == count);
+	for (int v = 0; v < count; v++)
+		CHECK(vertices[v].Position.x != 100.0f);
+}
+
+int main()
+{
+	TestTriangleOrder();
+	TestVertexFetch();
+
+	if (TestFailures() == 0)
+		std::printf("MeshOptimizer: all passed\n");
+	return TestFailures();
+}
@@ -0,0 +1,186 @@
+#include "MeshQuantization.h"
+#include "Random.h"
+#include "TestCheck.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+static XMFLOAT3 RandomDirection(Random& random)
+{
+	// Uniform on the sphere
+	float z = random.Range(-1.0f, 1.0f);
+	float angle = random.Range(0.0f, XM_2PI);
+	float r = sqrtf(1.0f - z * z);
+	return XMFLOAT3(r * cosf(angle), r * sinf(angle), z);
+}
+
+static float AngleDegrees(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	float cosine = a.x * b.x + a.y * b.y + a.z * b.z;
+	cosine = cosine > 1.0f ? 1.0f : (cosine < -1.0f ? -1.0f : cosine);
+	return acosf(cosine) * (180.0f / XM_PI);
+}
+
+// 8 bit octahedral stays within the worst case the shader was written for
+static void TestOctahedral()
+{
+	Random random(3);
+	float worst = 0.0f;
+	for (int i = 0; i < 200000; i++)
+	{
+		XMFLOAT3 direction = RandomDirection(random);
+		signed char code[2];
+		MeshQuantizer::EncodeOctahedral(direction, code);
+		float angle = AngleDegrees(direction, MeshQuantizer::DecodeOctahedral(code));
+		worst = angle > worst ? angle : worst;
+	}
+	CHECK(worst < 0.7f);
+
+	// The axes and the octahedron's edges come back exactly
+	XMFLOAT3 exact[] = {
+		XMFLOAT3(1, 0, 0), XMFLOAT3(-1, 0, 0), XMFLOAT3(0, 1, 0),
+		XMFLOAT3(0, -1, 0), XMFLOAT3(0, 0, 1), XMFLOAT3(0, 0, -1) };
+	for (int i = 0; i < 6; i++)
+	{
+		signed char code[2];
+		MeshQuantizer::EncodeOctahedral(exact[i], code);
+		XMFLOAT3 decoded = MeshQuantizer::DecodeOctahedral(code);
+		CHECK(decoded.x == exact[i].x && decoded.y == exact[i].y && decoded.z == exact[i].z);
+	}
+
+	// A zero length direction still encodes to something valid
+	signed char code[2] = { 99, 99 };
+	MeshQuantizer::EncodeOctahedral(XMFLOAT3(0, 0, 0), code);
+	CHECK(code[0] == 0 && code[1] == 0);
+}
+
+// --------------------------------------------------------
+// Encode then Decode a random mesh - positions land within
+// half a 16 bit step of where they were, UVs within half a
+// half-float step, and MeasureError reports the same worst
+// cases this measures by hand
+// --------------------------------------------------------
+static void TestRoundTrip()
+{
+	const int count = 50000;
+	MeshBounds bounds;
+	bounds.Min = XMFLOAT3(-3.0f, 0.5f, -0.25f);
+	bounds.Max = XMFLOAT3(5.0f, 2.5f, 0.25f);
+
+	Random random(11);
+	std::vector<Vertex> vertices(count);
+	for (int i = 0; i < count; i++)
+	{
+		Vertex& v = vertices[i];
+		v.Position = XMFLOAT3(
+			random.Range(bounds.Min.x, bounds.Max.x),
+			random.Range(bounds.Min.y, bounds.Max.y),
+			random.Range(bounds.Min.z, bounds.Max.z));
+		v.UV = XMFLOAT2(random.Range(-2.0f, 2.0f), random.NextFloat());
+		v.Normal = RandomDirection(random);
+		v.Tangent = RandomDirection(random);
+	}
+
+	// The corners of the bounds are in there too
+	vertices[0].Position = bounds.Min;
+	vertices[1].Position = bounds.Max;
+
+	MeshQuantization quantization = MeshQuantizer::Calculate(bounds);
+	CHECK(quantization.Bias.x == bounds.Min.x);
+	CHECK(quantization.Scale.y == bounds.Max.y - bounds.Min.y);
+
+	std::vector<QuantizedVertex> quantized(count);
+	MeshQuantizer::Encode(quantization, &vertices[0], count, &quantized[0]);
+	std::vector<Vertex> decoded(count);
+	MeshQuantizer::Decode(quantization, &quantized[0], count, &decoded[0]);
+
+	CHECK(quantized[0].Position[0] == 0 && quantized[0].Position[1] == 0 && quantized[0].Position[2] == 0);
+	CHECK(quantized[1].Position[0] == 65535 && quantized[1].Position[1] == 65535 && quantized[1].Position[2] == 65535);
+
+	QuantizationError expected = { 0, 0, 0, 0 };
+	for (int i = 0; i < count; i++)
+	{
+		const Vertex& a = vertices[i];
+		const Vertex& b = decoded[i];
+
+		// Half a step per axis, plus a little for float rounding
+		const float* scale = &quantization.Scale.x;
+		const float* original = &a.Position.x;
+		const float* result = &b.Position.x;
+		for (int axis = 0; axis < 3; axis++)
+			CHECK(fabsf(result[axis] - original[axis]) <= scale[axis] / 65535.0f * 0.5f + 1e-6f);
+
+		// Half floats keep 11 significant bits
+		CHECK(fabsf(b.UV.x - a.UV.x) <= fabsf(a.UV.x) / 2048.0f + 1e-7f);
+		CHECK(fabsf(b.UV.y - a.UV.y) <= fabsf(a.UV.y) / 2048.0f + 1e-7f);
+
+		float dx = b.Position.x - a.Position.x;
+		float dy = b.Position.y - a.Position.y;
+		float dz = b.Position.z - a.Position.z;
+		expected.Position = fmaxf(expected.Position, sqrtf(dx * dx + dy * dy + dz * dz));
+		expected.UV = fmaxf(expected.UV, fmaxf(fabsf(b.UV.x - a.UV.x), fabsf(b.UV.y - a.UV.y)));
+		expected.NormalDegrees = fmaxf(expected.NormalDegrees, AngleDegrees(a.Normal, b.Normal));
+		expected.TangentDegrees = fmaxf(expected.TangentDegrees, AngleDegrees(a.Tangent, b.Tangent));
+	}
+
+	QuantizationError error = MeshQuantizer::MeasureError(quantization, &vertices[0], &quantized[0], count);
+	CHECK(error.Position == expected.Position);
+	CHECK(error.UV == expected.UV);
+	CHECK(fabsf(error.NormalDegrees - expected.NormalDegrees) < 0.01f);
+	CHECK(fabsf(error.TangentDegrees - expected.TangentDegrees) < 0.01f);
+	CHECK(error.NormalDegrees < 0.7f);
+	CHECK(error.TangentDegrees < 0.7f);
+	CHECK(error.Position > 0.0f);
+
+	// Decoding what was decoded changes nothing - everything is on the grid already
+	std::vector<QuantizedVertex> again(count);
+	MeshQuantizer::Encode(quantization, &decoded[0], count, &again[0]);
+	for (int i = 0; i < count; i++)
+	{
+		CHECK(again[i].Position[0] == quantized[i].Position[0]);
+		CHECK(again[i].Position[1] == quantized[i].Position[1]);
+		CHECK(again[i].Position[2] == quantized[i].Position[2]);
+		CHECK(again[i].UV[0] == quantized[i].UV[0] && again[i].UV[1] == quantized[i].UV[1]);
+	}
+}
+
+// A flat mesh still gets a usable scale and keeps its flat axis exactly
+static void TestFlatBounds()
+{
+	MeshBounds bounds;
+	bounds.Min = XMFLOAT3(-1.0f, 2.0f, -1.0f);
+	bounds.Max = XMFLOAT3(1.0f, 2.0f, 1.0f);
+	MeshQuantization quantization = MeshQuantizer::Calculate(bounds);
+	CHECK(quantization.Scale.y == 1.0f);
+
+	Vertex vertex;
+	vertex.Position = XMFLOAT3(0.3f, 2.0f, -0.7f);
+	vertex.UV = XMFLOAT2(0.5f, 0.25f);
+	vertex.Normal = XMFLOAT3(0, 1, 0);
+	vertex.Tangent = XMFLOAT3(1, 0, 0);
+
+	QuantizedVertex quantized;
+	MeshQuantizer::Encode(quantization, &vertex, 1, &quantized);
+	Vertex decoded;
+	MeshQuantizer::Decode(quantization, &quantized, 1, &decoded);
+	CHECK(decoded.Position.y == 2.0f);
+	CHECK(decoded.UV.x == 0.5f && decoded.UV.y == 0.25f);
+	CHECK(decoded.Normal.y == 1.0f && decoded.Tangent.x == 1.0f);
+
+	QuantizationError error = MeshQuantizer::MeasureError(quantization, &vertex, &quantized, 1);
+	CHECK(error.UV == 0.0f && error.NormalDegrees == 0.0f && error.TangentDegrees == 0.0f);
+}
+
+int main()
+{
+	CHECK(sizeof(QuantizedVertex) == 16);
+	TestOctahedral();
+	TestRoundTrip();
+	TestFlatBounds();
+
+	if (TestFailures() == 0)
+		std::printf("MeshQuantization: all passed\n");
+	return TestFailures();
+}
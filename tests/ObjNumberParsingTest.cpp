@@ -0,0 +1,172 @@
+// Reaches tiny_obj_loader's internal number parsing, so this file is the
+// implementation instead of linking tiny_obj_loader.cc
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+#include "TestCheck.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+static bool SameDouble(double a, double b)
+{
+	return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+// Bitwise, so NaNs (the slow path makes one from "0e999") compare equal
+static bool SameReal(tinyobj::real_t a, tinyobj::real_t b)
+{
+	return memcmp(&a, &b, sizeof(tinyobj::real_t)) == 0;
+}
+
+// --------------------------------------------------------
+// Checks one token (with whatever follows it) against strtod
+//  - the fast path, whenever it takes a number, gives exactly
+//    strtod's double and stops where strtod stops
+//  - both parseReal overloads end at the first delimiter, agree
+//    with each other, and stay close to strtod when they parse
+// --------------------------------------------------------
+static long long fastTaken = 0;
+
+static void CheckToken(const char* text)
+{
+	const char* start = text;
+	while (*start == ' ' || *start == '\t')
+		start++;
+	char* strtodEnd;
+	double expected = strtod(start, &strtodEnd);
+
+	const char* fastToken = start;
+	double fast = -12345.0;
+	if (tinyobj::tryParseDecimalFast(&fastToken, &fast))
+	{
+		fastTaken++;
+		CHECK(SameDouble(fast, expected));
+		CHECK(fastToken == strtodEnd);
+		if (!SameDouble(fast, expected) || fastToken != strtodEnd)
+			std::fprintf(stderr, "  token [%s]: %a, strtod %a\n", text, fast, expected);
+	}
+	else
+	{
+		CHECK(fastToken == start);
+		CHECK(fast == -12345.0);
+	}
+
+	const char* end = tinyobj::findRealEnd(start);
+	const char* withDefault = text;
+	tinyobj::real_t value = tinyobj::parseReal(&withDefault, 0.25);
+	const char* withResult = text;
+	tinyobj::real_t result = -7.0f;
+	bool parsed = tinyobj::parseReal(&withResult, &result);
+
+	CHECK(withDefault == end);
+	CHECK(withResult == end);
+	CHECK(parsed ? SameReal(value, result) : (value == 0.25f && result == -7.0f));
+
+	// The whole token was a number, the result has to be near strtod's
+	// (the slow path isn't correctly rounded, the fast path is)
+	if (strtodEnd == end && end != start && std::fabs(expected) > 1e-30 && std::fabs(expected) < 1e30)
+	{
+		CHECK(parsed);
+		CHECK(std::fabs(result - expected) <= std::fabs(expected) * 1e-6);
+	}
+}
+
+static void TestHandPicked()
+{
+	const char* tokens[] = {
+		"0", "-0", "-0.0", "+0.000", "1", "-1.5", "0.1", "-0.123456", "1.5e-3",
+		"2E+10", "1e22", "1e23", "1e-22", "1e-23", "123456789.123456789",
+		"9007199254740992", "9007199254740993", "18446744073709551616",
+		".5", "-.5e1", "5.", "1e", "1e+", "+", "-", ".", "e5", "abc", "",
+		"0.30000000000000004", "1.7976931348623157e308", "4.9e-324",
+		"3.14159 2.71828", "-1.25\t7", "6.5\r\n", "  42", "\t-8e2 x" };
+	for (size_t i = 0; i < sizeof(tokens) / sizeof(tokens[0]); i++)
+		CheckToken(tokens[i]);
+
+	// Zero keeps its sign through the fast path
+	const char* negativeZero = "-0.0";
+	double zero = 1.0;
+	CHECK(tinyobj::tryParseDecimalFast(&negativeZero, &zero));
+	CHECK(zero == 0.0 && std::signbit(zero));
+}
+
+// --------------------------------------------------------
+// Generated tokens - plain fixed point like the exporters write,
+// printf's %e and %g, long digit runs that miss the fast path,
+// and junk made from number characters - followed by each kind
+// of delimiter
+// --------------------------------------------------------
+static void TestFuzz(long long count)
+{
+	std::mt19937_64 rng(777);
+	std::uniform_real_distribution<double> unit(-1.0, 1.0);
+	const char* delimiters[] = { "", " ", "\t", "\r", " 1.5", "\t-2", " abc", "\n" };
+	char buffer[160];
+
+	for (long long n = 0; n < count; n++)
+	{
+		std::string token;
+		if (rng() % 8 == 0)
+			token += rng() % 2 ? "  " : "\t";
+
+		int kind = (int)(rng() % 12);
+		if (kind < 5)
+		{
+			int precision = (int)(rng() % 12);
+			snprintf(buffer, sizeof(buffer), "%.*f", precision, unit(rng) * 1000.0 * std::pow(10.0, (int)(rng() % 7) - 3));
+			token += buffer;
+		}
+		else if (kind < 7)
+		{
+			int precision = (int)(rng() % 20);
+			snprintf(buffer, sizeof(buffer), rng() % 2 ? "%.*e" : "%.*g", precision, unit(rng) * std::pow(10.0, (int)(rng() % 60) - 30));
+			token += buffer;
+		}
+		else if (kind < 9)
+		{
+			std::string digits;
+			int length = 1 + (int)(rng() % 25);
+			for (int i = 0; i < length; i++)
+				digits += "0123456789"[rng() % 10];
+			if (rng() % 4)
+				digits.insert(rng() % (length + 1), ".");
+			if (rng() % 3 == 0)
+			{
+				digits += rng() % 2 ? "e" : "E";
+				if (rng() % 2)
+					digits += rng() % 2 ? "-" : "+";
+				int exponentLength = (int)(rng() % 6);
+				for (int i = 0; i < exponentLength; i++)
+					digits += "0123456789"[rng() % 10];
+			}
+			if (rng() % 2)
+				digits.insert(0, rng() % 3 ? "-" : "+");
+			token += digits;
+		}
+		else
+		{
+			int length = 1 + (int)(rng() % 9);
+			for (int i = 0; i < length; i++)
+				token += "0123456789.-+eE"[rng() % 15];
+		}
+
+		token += delimiters[rng() % 8];
+		CheckToken(token.c_str());
+	}
+}
+
+int main(int argc, char** argv)
+{
+	// Pass a count to fuzz for longer
+	long long count = argc > 1 ? atoll(argv[1]) : 1000000;
+
+	TestHandPicked();
+	TestFuzz(count);
+
+	if (TestFailures() == 0)
+		std::printf("ObjNumberParsing: all passed, %lld of %lld generated tokens took the fast path\n", fastTaken, count);
+	return TestFailures() ? 1 : 0;
+}
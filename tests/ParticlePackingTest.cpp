@@ -0,0 +1,135 @@
+#include "ParticlePacking.h"
+#include "Random.h"
+#include "TestCheck.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+// Rounds to the nearest step, clamps to [0, 1] first, red in the low byte
+static void TestPackColor()
+{
+	CHECK(ParticlePacking::PackColor(0, 0, 0, 0) == 0u);
+	CHECK(ParticlePacking::PackColor(1, 1, 1, 1) == 0xFFFFFFFFu);
+	CHECK(ParticlePacking::PackColor(1, 0, 0, 0) == 0x000000FFu);
+	CHECK(ParticlePacking::PackColor(0, 1, 0, 0) == 0x0000FF00u);
+	CHECK(ParticlePacking::PackColor(0, 0, 1, 0) == 0x00FF0000u);
+	CHECK(ParticlePacking::PackColor(0, 0, 0, 1) == 0xFF000000u);
+
+	// Nearest, not truncated
+	CHECK(ParticlePacking::PackColor(0.4f / 255.0f, 0, 0, 0) == 0u);
+	CHECK(ParticlePacking::PackColor(0.6f / 255.0f, 0, 0, 0) == 1u);
+	CHECK(ParticlePacking::PackColor(0.5f, 0, 0, 0) == 128u);
+	CHECK(ParticlePacking::PackColor(254.4f / 255.0f, 0, 0, 0) == 254u);
+
+	// Out of range channels saturate, and don't spill into their neighbours
+	CHECK(ParticlePacking::PackColor(-1.0f, 2.0f, -0.001f, 1.001f) == 0xFF00FF00u);
+	CHECK(ParticlePacking::PackColor(100.0f, -100.0f, 100.0f, -100.0f) == 0x00FF00FFu);
+}
+
+// Lands in [-pi, pi] and still points the same way
+static void TestWrapRotation()
+{
+	CHECK(ParticlePacking::WrapRotation(0.0f) == 0.0f);
+	CHECK(fabsf(ParticlePacking::WrapRotation(XM_PI + 0.5f) - (0.5f - XM_PI)) < 1e-5f);
+	CHECK(fabsf(ParticlePacking::WrapRotation(-XM_PI - 0.5f) - (XM_PI - 0.5f)) < 1e-5f);
+
+	Random random(17);
+	bool inRange = true;
+	bool sameAngle = true;
+	for (int i = 0; i < 100000; i++)
+	{
+		float rotation = random.Range(-200.0f, 200.0f);
+		float wrapped = ParticlePacking::WrapRotation(rotation);
+		inRange &= wrapped >= -XM_PI - 1e-5f && wrapped <= XM_PI + 1e-5f;
+		sameAngle &= fabsf(cosf(wrapped) - cosf(rotation)) < 1e-3f && fabsf(sinf(wrapped) - sinf(rotation)) < 1e-3f;
+	}
+	CHECK(inRange);
+	CHECK(sameAngle);
+}
+
+// --------------------------------------------------------
+// Packing a span all at once (mostly the 4 wide loop) and
+// one particle at a time (only the scalar tail) gives the
+// same bytes, colors and frames included
+// --------------------------------------------------------
+static void TestWideMatchesScalar(unsigned int features)
+{
+	const int count = 103;
+	ParticleArrays arrays;
+	ParticleKernels::Allocate(&arrays, count, 0.0f);
+
+	BillboardParams params = {};
+	params.Lifetime = 2.0f;
+	params.FrameCount = 8;
+	params.Features = features;
+
+	Random random(23);
+	for (int p = 0; p < count; p++)
+	{
+		arrays.X[p] = random.Range(-50.0f, 50.0f);
+		arrays.Y[p] = random.Range(-50.0f, 50.0f);
+		arrays.Z[p] = random.Range(-50.0f, 50.0f);
+		arrays.Size[p] = random.Range(0.0f, 4.0f);
+		arrays.Rotation[p] = random.Range(-20.0f, 20.0f);
+		arrays.R[p] = random.Range(-0.2f, 1.2f);
+		arrays.G[p] = random.Range(-0.2f, 1.2f);
+		arrays.B[p] = random.Range(-0.2f, 1.2f);
+		arrays.A[p] = random.Range(-0.2f, 1.2f);
+
+		// Every so often exactly on a frame boundary, or past the end
+		int kind = p % 5;
+		arrays.Age[p] = kind == 0 ? 0.25f * (p % 9) : (kind == 1 ? 2.5f : random.Range(0.0f, 2.0f));
+	}
+
+	// Starting one in, so the wide loop reads unaligned
+	const int first = 1;
+	const int packedCount = count - first;
+	std::vector<PackedParticle> wide(packedCount);
+	std::vector<PackedParticle> scalar(packedCount);
+	ParticlePacking::Pack(params, arrays, first, packedCount, wide.data());
+	for (int i = 0; i < packedCount; i++)
+		ParticlePacking::Pack(params, arrays, first + i, 1, &scalar[i]);
+
+	bool sameColor = true;
+	bool sameFrame = true;
+	bool sameRest = true;
+	unsigned int lastFrame = 0;
+	for (int i = 0; i < packedCount; i++)
+	{
+		const PackedParticle& a = wide[i];
+		const PackedParticle& b = scalar[i];
+		sameColor &= a.Color == b.Color;
+		sameFrame &= a.Frame == b.Frame;
+		sameRest &= a.Position.x == b.Position.x && a.Position.y == b.Position.y && a.Position.z == b.Position.z &&
+			a.Size == b.Size && a.Rotation == b.Rotation;
+		lastFrame = a.Frame > lastFrame ? a.Frame : lastFrame;
+	}
+	CHECK(sameColor);
+	CHECK(sameFrame);
+	CHECK(sameRest);
+
+	// Frames stop at the last one, and stay at 0 without a sprite sheet
+	bool spriteSheet = (features & particleFeatureSpriteSheet) != 0;
+	CHECK(lastFrame == (spriteSheet ? 7u : 0u));
+
+	ParticleKernels::Free(&arrays);
+}
+
+int main()
+{
+	CHECK(sizeof(PackedParticle) == 24);
+	CHECK(ParticlePacking::GetUploadSize(0) == 0);
+	CHECK(ParticlePacking::GetUploadSize(1) == 24);
+	CHECK(ParticlePacking::GetUploadSize(10000) == 24 * 10000);
+
+	TestPackColor();
+	TestWrapRotation();
+	TestWideMatchesScalar(particleFeatureAll);
+	TestWideMatchesScalar(particleFeatureAll & ~particleFeatureSpriteSheet);
+
+	if (TestFailures() == 0)
+		std::printf("ParticlePacking: all passed\n");
+	return TestFailures();
+}
@@ -0,0 +1,171 @@
+#include "ParticleSpanAllocator.h"
+#include "TestCheck.h"
+
+#include <cstdlib>
+#include <vector>
+
+// Small spans come off the front, a bigger one skips ahead to its
+// own alignment and the gap is there for the next small requests
+static void TestSplitFreeReuse()
+{
+	ParticleSpanAllocator allocator(1024, 16);
+
+	CHECK(allocator.GetSpanSize(1) == 16);
+	CHECK(allocator.GetSpanSize(17) == 32);
+	CHECK(allocator.GetSpanSize(100) == 128);
+
+	int a = allocator.Allocate(16);
+	int b = allocator.Allocate(100);
+	CHECK(a == 0);
+	CHECK(b == 128);
+	CHECK(allocator.GetUsedParticles() == 16 + 128);
+
+	// 16..128 was skipped for alignment and gets handed out before fresh space
+	int c = allocator.Allocate(16);
+	int d = allocator.Allocate(64);
+	CHECK(c == 16);
+	CHECK(d == 64);
+
+	// A freed span is reused as is
+	allocator.Free(c, 16);
+	CHECK(allocator.Allocate(10) == 16);
+
+	// The last piece of the gap
+	CHECK(allocator.Allocate(32) == 32);
+	CHECK(allocator.GetUsedParticles() == 16 + 128 + 16 + 64 + 32);
+}
+
+// With no fresh space left a bigger free span is split, keeping the
+// front half and leaving the rest for the smaller classes
+static void TestSplit()
+{
+	ParticleSpanAllocator allocator(256, 16);
+
+	int a = allocator.Allocate(128);
+	int b = allocator.Allocate(128);
+	CHECK(a == 0);
+	CHECK(b == 128);
+
+	allocator.Free(a, 128);
+	CHECK(allocator.Allocate(32) == 0);
+	CHECK(allocator.Allocate(32) == 32);
+	CHECK(allocator.Allocate(64) == 64);
+	CHECK(allocator.Allocate(16) == -1);
+	CHECK(allocator.GetUsedParticles() == 256);
+}
+
+// Freeing a run of small spans has to give the big class back
+static void TestFragmentation()
+{
+	ParticleSpanAllocator allocator(1024, 16);
+
+	// Fill the store with the smallest spans
+	std::vector<int> spans;
+	for (int i = 0; i < 1024 / 16; i++)
+		spans.push_back(allocator.Allocate(16));
+	CHECK(allocator.Allocate(16) == -1);
+
+	// Free everything but the last one, out of order
+	for (int i = 0; i < (int)spans.size() - 1; i += 2)
+		allocator.Free(spans[i], 16);
+	for (int i = 1; i < (int)spans.size() - 1; i += 2)
+		allocator.Free(spans[i], 16);
+	CHECK(allocator.GetUsedParticles() == 16);
+
+	// Without merging this only finds 16 particle spans
+	CHECK(allocator.Allocate(512) == 0);
+	CHECK(allocator.Allocate(256) == 512);
+	CHECK(allocator.Allocate(128) == 768);
+	CHECK(allocator.Allocate(64) == 896);
+	CHECK(allocator.Allocate(32) == 960);
+	CHECK(allocator.Allocate(16) == 992);
+	CHECK(allocator.Allocate(16) == -1);
+}
+
+// Once nothing is live the whole store is one span again
+static void TestResetWhenEmpty()
+{
+	ParticleSpanAllocator allocator(1024, 16);
+
+	int a = allocator.Allocate(16);
+	int b = allocator.Allocate(300);
+	int c = allocator.Allocate(40);
+	CHECK(allocator.Allocate(1024) == -1);
+
+	allocator.Free(b, 300);
+	allocator.Free(a, 16);
+	allocator.Free(c, 40);
+	CHECK(allocator.GetUsedParticles() == 0);
+	CHECK(allocator.Allocate(1024) == 0);
+	CHECK(allocator.Allocate(1) == -1);
+}
+
+// Random churn - spans never overlap, never run off the end, and
+// the used count matches what's actually live
+static void TestChurn()
+{
+	const int capacity = 1 << 14;
+	ParticleSpanAllocator allocator(capacity, 16);
+
+	struct Span { int offset; int count; };
+	std::vector<Span> live;
+	std::vector<int> owner(capacity, -1);
+	srand(1234);
+
+	for (int step = 0; step < 20000; step++)
+	{
+		if (live.empty() || rand() % 3 != 0)
+		{
+			int count = 1 + rand() % 700;
+			int offset = allocator.Allocate(count);
+			if (offset < 0)
+				continue;
+
+			int size = allocator.GetSpanSize(count);
+			CHECK(offset % size == 0);
+			CHECK(offset + size <= capacity);
+			for (int i = offset; i < offset + size && i < capacity; i++)
+			{
+				CHECK(owner[i] == -1);
+				owner[i] = step;
+			}
+			Span span = { offset, count };
+			live.push_back(span);
+		}
+		else
+		{
+			int pick = rand() % (int)live.size();
+			Span span = live[pick];
+			live[pick] = live.back();
+			live.pop_back();
+
+			int size = allocator.GetSpanSize(span.count);
+			for (int i = span.offset; i < span.offset + size; i++)
+				owner[i] = -1;
+			allocator.Free(span.offset, span.count);
+		}
+
+		int used = 0;
+		for (int i = 0; i < (int)live.size(); i++)
+			used += allocator.GetSpanSize(live[i].count);
+		CHECK(allocator.GetUsedParticles() == used);
+	}
+
+	// Whatever was left, freeing it all gives back the whole store
+	for (int i = 0; i < (int)live.size(); i++)
+		allocator.Free(live[i].offset, live[i].count);
+	CHECK(allocator.Allocate(capacity) == 0);
+}
+
+int main()
+{
+	TestSplitFreeReuse();
+	TestSplit();
+	TestFragmentation();
+	TestResetWhenEmpty();
+	TestChurn();
+
+	if (TestFailures() == 0)
+		std::printf("ParticleSpanAllocator: all passed\n");
+	return TestFailures();
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdio>
+
+// --------------------------------------------------------
+// Bare bones checks for the standalone tests
+//
+// A failed CHECK prints where it was and counts the failure,
+// and each test's main returns TestFailures() so ctest sees it.
+// --------------------------------------------------------
+inline int& TestFailures()
+{
+	static int failures = 0;
+	return failures;
+}
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) \
+		{ \
+			std::fprintf(stderr, "%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			TestFailures()++; \
+		} \
+	} while (0)
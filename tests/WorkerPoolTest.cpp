@@ -0,0 +1,157 @@
+#include "ParticleKernels.h"
+#include "Random.h"
+#include "WorkerPool.h"
+#include "TestCheck.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------
+// Every index runs exactly once, for loops of every size and
+// however the workers happen to be scheduled - including
+// workers that wake up late, after the caller has finished a
+// loop on its own and started the next one
+// --------------------------------------------------------
+static std::atomic<int> hits[64];
+
+static void CountHit(void*, int index)
+{
+	hits[index]++;
+}
+
+static void TestEveryIndexOnce(int workerCount)
+{
+	WorkerPool pool(workerCount);
+	CHECK(pool.GetThreadCount() == workerCount + 1);
+
+	for (int loop = 0; loop < 3000; loop++)
+	{
+		int count = loop % 9;
+		for (int i = 0; i < 64; i++)
+			hits[i] = 0;
+
+		pool.ParallelFor(count, CountHit, 0);
+		for (int i = 0; i < 64; i++)
+			CHECK(hits[i] == (i < count ? 1 : 0));
+
+		// Gives sleeping workers a chance to wake up between loops
+		if (loop % 4 == 0)
+			std::this_thread::sleep_for(std::chrono::microseconds(20));
+	}
+}
+
+// --------------------------------------------------------
+// A simulation step split across the pool gives exactly the
+// same particles with one thread as with many.  Each chunk
+// owns its own range, like ParticleSystem's batches.
+// --------------------------------------------------------
+static const int particleCount = 100003;	// Not a multiple of anything useful
+static const int chunkSize = 4096;
+
+struct Simulation
+{
+	ParticleArrays Particles;
+	ParticleUpdateParams Params;
+	ParticleCurves Curves;
+	std::vector<ParticleVertex> Vertices;
+	std::vector<int> Deaths;
+};
+
+static void UpdateChunk(void* context, int index)
+{
+	Simulation* sim = (Simulation*)context;
+	int first = index * chunkSize;
+	int count = particleCount - first < chunkSize ? particleCount - first : chunkSize;
+	sim->Deaths[index] += ParticleKernels::Update(sim->Params, sim->Particles, first, count);
+
+	DirectX::XMFLOAT2 frame(0, 0);
+	BillboardParams billboard = {};
+	billboard.CameraRight = DirectX::XMFLOAT3(1, 0, 0);
+	billboard.CameraUp = DirectX::XMFLOAT3(0, 1, 0);
+	billboard.Lifetime = sim->Params.Lifetime;
+	billboard.Frames = &frame;
+	billboard.FrameCount = 1;
+	billboard.FrameSize = DirectX::XMFLOAT2(1, 1);
+	billboard.Features = particleFeatureRotation;
+	ParticleKernels::ExpandBillboards(billboard, sim->Particles, first, count, &sim->Vertices[first * 4]);
+}
+
+static void Simulate(Simulation* sim, int workerCount)
+{
+	const float lifetime = 2.0f;
+	ParticleKernels::Allocate(&sim->Particles, particleCount, lifetime);
+	for (int i = 0; i < particleCurveResolution; i++)
+	{
+		float t = i / (float)(particleCurveResolution - 1);
+		sim->Curves.R[i] = 1.0f - t;
+		sim->Curves.G[i] = t * t;
+		sim->Curves.B[i] = 0.5f;
+		sim->Curves.A[i] = 1.0f - t * t;
+		sim->Curves.Size[i] = 0.1f + t;
+		sim->Curves.Rotation[i] = t * (2.0f - t);
+	}
+
+	sim->Params.DeltaTime = 1.0f / 60.0f;
+	sim->Params.Lifetime = lifetime;
+	sim->Params.Curves = &sim->Curves;
+	sim->Params.Acceleration = DirectX::XMFLOAT3(0.0f, -9.8f, 0.5f);
+	sim->Params.Features = particleFeatureAll;
+
+	// Staggered ages so particles die all through the run
+	Random random(42);
+	std::vector<float> randoms(particleCount * particleSpawnRandoms);
+	random.FillFloats(&randoms[0], (int)randoms.size());
+	ParticleSpawnParams spawn = {};
+	spawn.PositionRange = DirectX::XMFLOAT3(5, 5, 5);
+	spawn.Velocity = DirectX::XMFLOAT3(0, 2, 0);
+	spawn.VelocityRange = DirectX::XMFLOAT3(1, 1, 1);
+	spawn.RotationRanges = DirectX::XMFLOAT4(0, 3.0f, -6.0f, 6.0f);
+	spawn.Size = 1.0f;
+	spawn.Color = DirectX::XMFLOAT4(1, 1, 1, 1);
+	ParticleKernels::Spawn(spawn, sim->Particles, 0, particleCount, &randoms[0]);
+	for (int i = 0; i < particleCount; i++)
+		sim->Particles.Age[i] = randoms[i] * lifetime;
+
+	int chunks = (particleCount + chunkSize - 1) / chunkSize;
+	sim->Vertices.assign(particleCount * 4, ParticleVertex());
+	sim->Deaths.assign(chunks, 0);
+
+	WorkerPool pool(workerCount);
+	for (int step = 0; step < 90; step++)
+		pool.ParallelFor(chunks, UpdateChunk, sim);
+}
+
+static void TestDeterministic()
+{
+	Simulation reference;
+	Simulate(&reference, 0);
+
+	int workerCounts[] = { 1, 3, 7 };
+	for (int w = 0; w < 3; w++)
+	{
+		Simulation sim;
+		Simulate(&sim, workerCounts[w]);
+
+		CHECK(sim.Deaths == reference.Deaths);
+		CHECK(memcmp(sim.Particles.Age, reference.Particles.Age, sizeof(float) * sim.Particles.Capacity * 18) == 0);
+		CHECK(memcmp(&sim.Vertices[0], &reference.Vertices[0], sizeof(ParticleVertex) * sim.Vertices.size()) == 0);
+		ParticleKernels::Free(&sim.Particles);
+	}
+
+	ParticleKernels::Free(&reference.Particles);
+}
+
+int main()
+{
+	TestEveryIndexOnce(0);
+	TestEveryIndexOnce(1);
+	TestEveryIndexOnce(3);
+	TestDeterministic();
+
+	if (TestFailures() == 0)
+		std::printf("WorkerPool: all passed\n");
+	return TestFailures();
+}
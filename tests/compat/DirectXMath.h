@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cmath>
+#include <xmmintrin.h>
+
+// --------------------------------------------------------
+// Just enough of DirectXMath to build the CPU-side game code
+// for the standalone tests on platforms without the real one
+//
+// XMVECTOR is a plain __m128, so the vector operators come from
+// the compiler's vector extensions.  Only what the tested files
+// use is here, and nothing is tuned - the tests compare the code
+// against itself, never against numbers from the Windows build.
+// --------------------------------------------------------
+namespace DirectX
+{
+	const float XM_PI = 3.141592654f;
+	const float XM_2PI = 6.283185307f;
+
+	typedef __m128 XMVECTOR;
+	typedef const XMVECTOR FXMVECTOR;
+
+	struct XMFLOAT2
+	{
+		float x, y;
+		XMFLOAT2() = default;
+		XMFLOAT2(float x, float y) : x(x), y(y) {}
+	};
+
+	struct XMFLOAT3
+	{
+		float x, y, z;
+		XMFLOAT3() = default;
+		XMFLOAT3(float x, float y, float z) : x(x), y(y), z(z) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x, y, z, w;
+		XMFLOAT4() = default;
+		XMFLOAT4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+	};
+
+	struct XMFLOAT4X4
+	{
+		union
+		{
+			struct
+			{
+				float _11, _12, _13, _14;
+				float _21, _22, _23, _24;
+				float _31, _32, _33, _34;
+				float _41, _42, _43, _44;
+			};
+			float m[4][4];
+		};
+
+		XMFLOAT4X4() = default;
+		XMFLOAT4X4(float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33)
+			: _11(m00), _12(m01), _13(m02), _14(m03),
+			_21(m10), _22(m11), _23(m12), _24(m13),
+			_31(m20), _32(m21), _33(m22), _34(m23),
+			_41(m30), _42(m31), _43(m32), _44(m33) {}
+	};
+
+	// Row vectors, like the real one - a point times the matrix
+	struct XMMATRIX
+	{
+		XMVECTOR r[4];
+	};
+
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+	inline XMVECTOR XMVectorReplicate(float value) { return _mm_set1_ps(value); }
+	inline XMVECTOR XMVectorZero() { return _mm_setzero_ps(); }
+	inline float XMVectorGetX(FXMVECTOR v) { return _mm_cvtss_f32(v); }
+	inline XMVECTOR XMVectorMin(FXMVECTOR a, FXMVECTOR b) { return _mm_min_ps(a, b); }
+	inline XMVECTOR XMVectorMax(FXMVECTOR a, FXMVECTOR b) { return _mm_max_ps(a, b); }
+	inline XMVECTOR XMVectorMultiply(FXMVECTOR a, FXMVECTOR b) { return _mm_mul_ps(a, b); }
+
+	inline XMVECTOR XMLoadFloat3(const XMFLOAT3* source) { return _mm_setr_ps(source->x, source->y, source->z, 0.0f); }
+	inline XMVECTOR XMLoadFloat4(const XMFLOAT4* source) { return _mm_loadu_ps(&source->x); }
+
+	inline void XMStoreFloat3(XMFLOAT3* destination, FXMVECTOR v)
+	{
+		float lanes[4];
+		_mm_storeu_ps(lanes, v);
+		destination->x = lanes[0];
+		destination->y = lanes[1];
+		destination->z = lanes[2];
+	}
+
+	inline void XMStoreFloat4(XMFLOAT4* destination, FXMVECTOR v) { _mm_storeu_ps(&destination->x, v); }
+
+	inline void XMVectorSinCos(XMVECTOR* sines, XMVECTOR* cosines, FXMVECTOR v)
+	{
+		float lanes[4], s[4], c[4];
+		_mm_storeu_ps(lanes, v);
+		for (int i = 0; i < 4; i++)
+		{
+			s[i] = std::sin(lanes[i]);
+			c[i] = std::cos(lanes[i]);
+		}
+		*sines = _mm_loadu_ps(s);
+		*cosines = _mm_loadu_ps(c);
+	}
+
+	// Dot products come back replicated into every lane, like the real thing
+	inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b)
+	{
+		float l[4], r[4];
+		_mm_storeu_ps(l, a);
+		_mm_storeu_ps(r, b);
+		return _mm_set1_ps(l[0] * r[0] + l[1] * r[1] + l[2] * r[2]);
+	}
+
+	inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b)
+	{
+		float l[4], r[4];
+		_mm_storeu_ps(l, a);
+		_mm_storeu_ps(r, b);
+		return _mm_setr_ps(l[1] * r[2] - l[2] * r[1], l[2] * r[0] - l[0] * r[2], l[0] * r[1] - l[1] * r[0], 0.0f);
+	}
+
+	inline XMVECTOR XMVector3Length(FXMVECTOR v) { return _mm_sqrt_ps(XMVector3Dot(v, v)); }
+
+	inline XMVECTOR XMVector3Normalize(FXMVECTOR v)
+	{
+		float length = XMVectorGetX(XMVector3Length(v));
+		return length > 0.0f ? v / _mm_set1_ps(length) : v;
+	}
+
+	inline XMMATRIX XMMatrixSet(float m00, float m01, float m02, float m03,
+		float m10, float m11, float m12, float m13,
+		float m20, float m21, float m22, float m23,
+		float m30, float m31, float m32, float m33)
+	{
+		XMMATRIX result;
+		result.r[0] = _mm_setr_ps(m00, m01, m02, m03);
+		result.r[1] = _mm_setr_ps(m10, m11, m12, m13);
+		result.r[2] = _mm_setr_ps(m20, m21, m22, m23);
+		result.r[3] = _mm_setr_ps(m30, m31, m32, m33);
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixScalingFromVector(FXMVECTOR scale)
+	{
+		float s[4];
+		_mm_storeu_ps(s, scale);
+		return XMMatrixSet(
+			s[0], 0, 0, 0,
+			0, s[1], 0, 0,
+			0, 0, s[2], 0,
+			0, 0, 0, 1);
+	}
+
+	inline XMMATRIX XMMatrixTranslationFromVector(FXMVECTOR offset)
+	{
+		float t[4];
+		_mm_storeu_ps(t, offset);
+		return XMMatrixSet(
+			1, 0, 0, 0,
+			0, 1, 0, 0,
+			0, 0, 1, 0,
+			t[0], t[1], t[2], 1);
+	}
+
+	// Expects a unit quaternion (x, y, z, w)
+	inline XMMATRIX XMMatrixRotationQuaternion(FXMVECTOR quaternion)
+	{
+		float q[4];
+		_mm_storeu_ps(q, quaternion);
+		float x = q[0], y = q[1], z = q[2], w = q[3];
+		return XMMatrixSet(
+			1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w), 0,
+			2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w), 0,
+			2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y), 0,
+			0, 0, 0, 1);
+	}
+
+	inline XMMATRIX XMMatrixTranspose(const XMMATRIX& m)
+	{
+		XMMATRIX result = m;
+		_MM_TRANSPOSE4_PS(result.r[0], result.r[1], result.r[2], result.r[3]);
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixMultiply(const XMMATRIX& a, const XMMATRIX& b)
+	{
+		XMMATRIX result;
+		for (int i = 0; i < 4; i++)
+		{
+			float row[4];
+			_mm_storeu_ps(row, a.r[i]);
+			result.r[i] = _mm_set1_ps(row[0]) * b.r[0] + _mm_set1_ps(row[1]) * b.r[1] +
+				_mm_set1_ps(row[2]) * b.r[2] + _mm_set1_ps(row[3]) * b.r[3];
+		}
+		return result;
+	}
+
+	inline XMMATRIX operator*(const XMMATRIX& a, const XMMATRIX& b) { return XMMatrixMultiply(a, b); }
+
+	inline void XMStoreFloat4x4(XMFLOAT4X4* destination, const XMMATRIX& m)
+	{
+		for (int i = 0; i < 4; i++)
+			_mm_storeu_ps(destination->m[i], m.r[i]);
+	}
+}
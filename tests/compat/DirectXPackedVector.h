@@ -0,0 +1,79 @@
+#pragma once
+
+#include "DirectXMath.h"
+
+#include <cstring>
+
+// --------------------------------------------------------
+// Half float conversions for the standalone tests (see
+// DirectXMath.h next to this).  Rounds to nearest even.
+// --------------------------------------------------------
+namespace DirectX
+{
+	namespace PackedVector
+	{
+		typedef unsigned short HALF;
+
+		inline HALF XMConvertFloatToHalf(float value)
+		{
+			unsigned int bits;
+			memcpy(&bits, &value, sizeof(bits));
+			unsigned int sign = (bits >> 16) & 0x8000;
+			unsigned int magnitude = bits & 0x7FFFFFFF;
+
+			// NaN stays NaN, anything too big for a half becomes infinity
+			if (magnitude > 0x7F800000)
+				return (HALF)(sign | 0x7E00);
+			if (magnitude >= 0x477FF000)
+				return (HALF)(sign | 0x7C00);
+
+			// Too small even for a denormal half
+			if (magnitude < 0x33000001)
+				return (HALF)sign;
+
+			int exponent = (int)(magnitude >> 23) - 127 + 15;
+			unsigned int mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+			int shift = exponent > 0 ? 13 : 14 - exponent;
+			unsigned int half = mantissa >> shift;
+			unsigned int rest = mantissa & ((1u << shift) - 1);
+			unsigned int halfway = 1u << (shift - 1);
+			if (rest > halfway || (rest == halfway && (half & 1)))
+				half++;
+
+			// Normal numbers keep their exponent; a rounding carry moves it up by itself
+			if (exponent > 0)
+				half = ((unsigned int)exponent << 10) + (half - 0x400);
+			return (HALF)(sign | half);
+		}
+
+		inline float XMConvertHalfToFloat(HALF value)
+		{
+			unsigned int sign = (unsigned int)(value & 0x8000) << 16;
+			unsigned int exponent = (value >> 10) & 0x1F;
+			unsigned int mantissa = value & 0x3FF;
+
+			unsigned int bits;
+			if (exponent == 0x1F)
+				bits = sign | 0x7F800000 | (mantissa << 13);
+			else if (exponent != 0)
+				bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+			else if (mantissa == 0)
+				bits = sign;
+			else
+			{
+				// Denormal - shift it up into a normal float
+				exponent = 113;
+				while (!(mantissa & 0x400))
+				{
+					mantissa <<= 1;
+					exponent--;
+				}
+				bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+			}
+
+			float result;
+			memcpy(&result, &bits, sizeof(result));
+			return result;
+		}
+	}
+}
@@ -587,6 +587,18 @@ bool LoadObj(attrib_t *attrib, std::vector<shape_t> *shapes,
              MaterialReader *readMatFn = NULL, bool triangulate = true,
              bool default_vcols_fallback = true);
 
+/// Loads .obj from memory, splitting it into line-aligned chunks parsed on
+/// `num_threads` threads (0 = one per hardware thread). Same results as
+/// LoadObj, files with faces that use later vertices and files that fail to
+/// parse go through LoadObj itself.
+/// 'data' doesn't need to be NUL terminated.
+bool LoadObjParallel(attrib_t *attrib, std::vector<shape_t> *shapes,
+                     std::vector<material_t> *materials, std::string *warn,
+                     std::string *err, const char *data, size_t size,
+                     MaterialReader *readMatFn = NULL, bool triangulate = true,
+                     bool default_vcols_fallback = true,
+                     unsigned int num_threads = 0);
+
 /// Loads materials into std::map
 void LoadMtl(std::map<std::string, int> *material_map,
              std::vector<material_t> *materials, std::istream *inStream,
@@ -621,6 +633,7 @@ bool ParseTextureNameAndOption(std::string *texname, texture_option_t *texopt,
 
 #include <fstream>
 #include <sstream>
+#include <thread>
 
 namespace tinyobj {
 
@@ -802,6 +815,127 @@ static inline int parseInt(const char **token) {
 //  - s >= s_end.
 //  - parse failure.
 //
+// Value of 8 digit characters, the first one in the lowest byte. Combines
+// neighbouring digits, then pairs, then quads within the one 64 bit integer.
+static inline unsigned long long parseEightDigits(unsigned long long chunk) {
+  chunk -= 0x3030303030303030ULL;
+  chunk = (chunk * 10) + (chunk >> 8);
+  chunk = (((chunk & 0x000000FF000000FFULL) * 0x000F424000000064ULL) +
+           (((chunk >> 16) & 0x000000FF000000FFULL) *
+            0x0000271000000001ULL)) >>
+          32;
+  return chunk;
+}
+
+// 8 characters, the first one in the lowest byte whatever the endianness.
+static inline unsigned long long loadEightChars(const char *s) {
+  const unsigned char *u = reinterpret_cast<const unsigned char *>(s);
+  return static_cast<unsigned long long>(u[0]) |
+         (static_cast<unsigned long long>(u[1]) << 8) |
+         (static_cast<unsigned long long>(u[2]) << 16) |
+         (static_cast<unsigned long long>(u[3]) << 24) |
+         (static_cast<unsigned long long>(u[4]) << 32) |
+         (static_cast<unsigned long long>(u[5]) << 40) |
+         (static_cast<unsigned long long>(u[6]) << 48) |
+         (static_cast<unsigned long long>(u[7]) << 56);
+}
+
+// Fast path for the plain decimals that make up almost all .obj data, like
+// `-0.123456` or `1.5e-3`, ending at ' ', '\t', '\r' or the end of the
+// string.
+// The digits go into an integer, the fraction's 8 at a time. When that
+// integer fits in a double's 53 bit mantissa and the power of ten is at most
+// 22, one multiply or divide by an exact power of ten gives the correctly
+// rounded result (Clinger's fast path).
+// Returns false without moving `token` for anything else, which then goes
+// through tryParseDouble as before.
+static inline bool tryParseDecimalFast(const char **token, double *result) {
+  static const double exact_pow10[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  static const unsigned long long int_pow10[] = {
+      1ULL,      10ULL,      100ULL,      1000ULL,     10000ULL,
+      100000ULL, 1000000ULL, 10000000ULL, 100000000ULL};
+  static const double sign_value[] = {1.0, -1.0};
+  const int max_exact_pow10 = 22;
+
+  // Vertex data is about half negative, so the sign is handled without
+  // branching on it
+  const char *s = (*token);
+  const char *curr = s;
+  bool negative = (*curr == '-');
+  curr += (negative || *curr == '+') ? 1 : 0;
+
+  // Up to 19 digits always fit in 64 bits
+  unsigned long long mantissa = 0;
+  const char *digits_begin = curr;
+  while (IS_DIGIT(*curr)) {
+    mantissa = mantissa * 10 + static_cast<unsigned int>(*curr - '0');
+    curr++;
+  }
+  size_t digits = static_cast<size_t>(curr - digits_begin);
+
+  int exponent = 0;
+  if (*curr == '.') {
+    curr++;
+    const char *fraction = curr;
+    while (IS_DIGIT(*curr)) curr++;
+    size_t fraction_digits = static_cast<size_t>(curr - fraction);
+    if (digits + fraction_digits > 19) return false;
+
+    while (curr - fraction >= 8) {
+      mantissa = mantissa * 100000000ULL +
+                 parseEightDigits(loadEightChars(fraction));
+      fraction += 8;
+    }
+    size_t rest = static_cast<size_t>(curr - fraction);
+    if (rest > 0 && curr - s >= 8) {
+      // The 8 characters ending at the last digit, with the ones before the
+      // remaining digits read as leading '0's
+      unsigned int shift = 8 * (8 - static_cast<unsigned int>(rest));
+      unsigned long long chunk = loadEightChars(curr - 8);
+      chunk = ((chunk >> shift) << shift) |
+              (0x3030303030303030ULL >> (64 - shift));
+      mantissa = mantissa * int_pow10[rest] + parseEightDigits(chunk);
+    } else {
+      for (; fraction < curr; fraction++) {
+        mantissa = mantissa * 10 + static_cast<unsigned int>(*fraction - '0');
+      }
+    }
+
+    digits += fraction_digits;
+    exponent = -static_cast<int>(fraction_digits);
+  }
+
+  if (digits == 0 || digits > 19) return false;
+
+  if (*curr == 'e' || *curr == 'E') {
+    curr++;
+    bool exp_negative = (*curr == '-');
+    curr += (exp_negative || *curr == '+') ? 1 : 0;
+    // A longer exponent is never exact anyway
+    const char *exp_begin = curr;
+    int exp_value = 0;
+    while (IS_DIGIT(*curr) && curr - exp_begin < 4) {
+      exp_value = exp_value * 10 + (*curr - '0');
+      curr++;
+    }
+    if (curr == exp_begin) return false;
+    exponent += exp_negative ? -exp_value : exp_value;
+  }
+
+  if (!IS_SPACE(*curr) && *curr != '\r' && *curr != '\0') return false;
+  if (mantissa > (1ULL << 53)) return false;
+  if (exponent < -max_exact_pow10 || exponent > max_exact_pow10) return false;
+
+  double value = static_cast<double>(mantissa);
+  value = exponent < 0 ? value / exact_pow10[-exponent]
+                       : value * exact_pow10[exponent];
+  *result = value * sign_value[negative];
+  (*token) = curr;
+  return true;
+}
+
 static bool tryParseDouble(const char *s, const char *s_end, double *result) {
   if (s >= s_end) {
     return false;
@@ -928,10 +1062,22 @@ fail:
   return false;
 }
 
+// Same as `(*token) + strcspn((*token), " \t\r")`, without the per-call
+// setup of the library version. Numbers are short, this is called for each.
+static inline const char *findRealEnd(const char *token) {
+  while (!IS_SPACE(*token) && *token != '\r' && *token != '\0') token++;
+  return token;
+}
+
 static inline real_t parseReal(const char **token, double default_value = 0.0) {
-  (*token) += strspn((*token), " \t");
-  const char *end = (*token) + strcspn((*token), " \t\r");
-  double val = default_value;
+  while (IS_SPACE(**token)) (*token)++;
+  double val;
+  if (tryParseDecimalFast(token, &val)) {
+    return static_cast<real_t>(val);
+  }
+
+  const char *end = findRealEnd(*token);
+  val = default_value;
   tryParseDouble((*token), end, &val);
   real_t f = static_cast<real_t>(val);
   (*token) = end;
@@ -939,9 +1085,14 @@ static inline real_t parseReal(const char **token, double default_value = 0.0) {
 }
 
 static inline bool parseReal(const char **token, real_t *out) {
-  (*token) += strspn((*token), " \t");
-  const char *end = (*token) + strcspn((*token), " \t\r");
+  while (IS_SPACE(**token)) (*token)++;
   double val;
+  if (tryParseDecimalFast(token, &val)) {
+    (*out) = static_cast<real_t>(val);
+    return true;
+  }
+
+  const char *end = findRealEnd(*token);
   bool ret = tryParseDouble((*token), end, &val);
   if (ret) {
     real_t f = static_cast<real_t>(val);
@@ -2094,6 +2245,402 @@ bool LoadObj(attrib_t *attrib, std::vector<shape_t> *shapes,
                  trianglulate, default_vcols_fallback);
 }
 
+// Parser state that lives across lines, shared by the serial and the
+// chunked parallel loader.
+struct ObjParseState {
+  PrimGroup prim_group;
+  std::vector<tag_t> tags;
+  std::string name;
+
+  // material
+  std::map<std::string, int> material_map;
+  int material;
+
+  // smoothing group id
+  unsigned int current_smoothing_id;  // 0 means no smoothing.
+
+  int greatest_v_idx;
+  int greatest_vn_idx;
+  int greatest_vt_idx;
+
+  shape_t shape;
+
+  ObjParseState()
+      : material(-1),
+        current_smoothing_id(0),
+        greatest_v_idx(-1),
+        greatest_vn_idx(-1),
+        greatest_vt_idx(-1) {}
+};
+
+// Handles every line other than `v`, `vn`, `vt` and `f`. `v_count`,
+// `vn_count` and `vt_count` are the number of attributes defined before this
+// line (for relative indices), and `v` holds at least those vertices.
+// Returns false on a parse error.
+static bool parseObjCommand(const char *token, size_t line_num, int v_count,
+                            int vn_count, int vt_count,
+                            const std::vector<real_t> &v, ObjParseState *state,
+                            std::vector<shape_t> *shapes,
+                            std::vector<material_t> *materials,
+                            MaterialReader *readMatFn, bool triangulate,
+                            std::string *warn, std::string *err) {
+  // line
+  if (token[0] == 'l' && IS_SPACE((token[1]))) {
+    token += 2;
+
+    __line_t line;
+
+    while (!IS_NEW_LINE(token[0])) {
+      vertex_index_t vi;
+      if (!parseTriple(&token, v_count, vn_count, vt_count, &vi)) {
+        if (err) {
+          std::stringstream ss;
+          ss << "Failed parse `l' line(e.g. zero value for vertex index. "
+                "line "
+             << line_num << ".)\n";
+          (*err) += ss.str();
+        }
+        return false;
+      }
+
+      line.vertex_indices.push_back(vi);
+
+      size_t n = strspn(token, " \t\r");
+      token += n;
+    }
+
+    state->prim_group.lineGroup.push_back(line);
+
+    return true;
+  }
+
+  // points
+  if (token[0] == 'p' && IS_SPACE((token[1]))) {
+    token += 2;
+
+    __points_t pts;
+
+    while (!IS_NEW_LINE(token[0])) {
+      vertex_index_t vi;
+      if (!parseTriple(&token, v_count, vn_count, vt_count, &vi)) {
+        if (err) {
+          std::stringstream ss;
+          ss << "Failed parse `p' line(e.g. zero value for vertex index. "
+                "line "
+             << line_num << ".)\n";
+          (*err) += ss.str();
+        }
+        return false;
+      }
+
+      pts.vertex_indices.push_back(vi);
+
+      size_t n = strspn(token, " \t\r");
+      token += n;
+    }
+
+    state->prim_group.pointsGroup.push_back(pts);
+
+    return true;
+  }
+
+  // use mtl
+  if ((0 == strncmp(token, "usemtl", 6)) && IS_SPACE((token[6]))) {
+    token += 7;
+    std::stringstream ss;
+    ss << token;
+    std::string namebuf = ss.str();
+
+    int newMaterialId = -1;
+    if (state->material_map.find(namebuf) != state->material_map.end()) {
+      newMaterialId = state->material_map[namebuf];
+    } else {
+      // { error!! material not found }
+    }
+
+    if (newMaterialId != state->material) {
+      // Create per-face material. Thus we don't add `shape` to `shapes` at
+      // this time.
+      // just clear `faceGroup` after `exportGroupsToShape()` call.
+      exportGroupsToShape(&state->shape, state->prim_group, state->tags,
+                          state->material, state->name, triangulate, v);
+      state->prim_group.faceGroup.clear();
+      state->material = newMaterialId;
+    }
+
+    return true;
+  }
+
+  // load mtl
+  if ((0 == strncmp(token, "mtllib", 6)) && IS_SPACE((token[6]))) {
+    if (readMatFn) {
+      token += 7;
+
+      std::vector<std::string> filenames;
+      SplitString(std::string(token), ' ', filenames);
+
+      if (filenames.empty()) {
+        if (warn) {
+          std::stringstream ss;
+          ss << "Looks like empty filename for mtllib. Use default "
+                "material (line "
+             << line_num << ".)\n";
+
+          (*warn) += ss.str();
+        }
+      } else {
+        bool found = false;
+        for (size_t s = 0; s < filenames.size(); s++) {
+          std::string warn_mtl;
+          std::string err_mtl;
+          bool ok = (*readMatFn)(filenames[s].c_str(), materials,
+                                 &state->material_map, &warn_mtl, &err_mtl);
+          if (warn && (!warn_mtl.empty())) {
+            (*warn) += warn_mtl;
+          }
+
+          if (err && (!err_mtl.empty())) {
+            (*err) += err_mtl;
+          }
+
+          if (ok) {
+            found = true;
+            break;
+          }
+        }
+
+        if (!found) {
+          if (warn) {
+            (*warn) +=
+                "Failed to load material file(s). Use default "
+                "material.\n";
+          }
+        }
+      }
+    }
+
+    return true;
+  }
+
+  // group name
+  if (token[0] == 'g' && IS_SPACE((token[1]))) {
+    // flush previous face group.
+    bool ret = exportGroupsToShape(&state->shape, state->prim_group,
+                                   state->tags, state->material, state->name,
+                                   triangulate, v);
+    (void)ret;  // return value not used.
+
+    if (state->shape.mesh.indices.size() > 0) {
+      shapes->push_back(state->shape);
+    }
+
+    state->shape = shape_t();
+
+    // material = -1;
+    state->prim_group.clear();
+
+    std::vector<std::string> names;
+
+    while (!IS_NEW_LINE(token[0])) {
+      std::string str = parseString(&token);
+      names.push_back(str);
+      token += strspn(token, " \t\r");  // skip tag
+    }
+
+    // names[0] must be 'g'
+
+    if (names.size() < 2) {
+      // 'g' with empty names
+      if (warn) {
+        std::stringstream ss;
+        ss << "Empty group name. line: " << line_num << "\n";
+        (*warn) += ss.str();
+        state->name = "";
+      }
+    } else {
+      std::stringstream ss;
+      ss << names[1];
+
+      // tinyobjloader does not support multiple groups for a primitive.
+      // Currently we concatinate multiple group names with a space to get
+      // single group name.
+
+      for (size_t i = 2; i < names.size(); i++) {
+        ss << " " << names[i];
+      }
+
+      state->name = ss.str();
+    }
+
+    return true;
+  }
+
+  // object name
+  if (token[0] == 'o' && IS_SPACE((token[1]))) {
+    // flush previous face group.
+    bool ret = exportGroupsToShape(&state->shape, state->prim_group,
+                                   state->tags, state->material, state->name,
+                                   triangulate, v);
+    if (ret) {
+      shapes->push_back(state->shape);
+    }
+
+    // material = -1;
+    state->prim_group.clear();
+    state->shape = shape_t();
+
+    // @todo { multiple object name? }
+    token += 2;
+    std::stringstream ss;
+    ss << token;
+    state->name = ss.str();
+
+    return true;
+  }
+
+  if (token[0] == 't' && IS_SPACE(token[1])) {
+    const int max_tag_nums = 8192;  // FIXME(syoyo): Parameterize.
+    tag_t tag;
+
+    token += 2;
+
+    tag.name = parseString(&token);
+
+    tag_sizes ts = parseTagTriple(&token);
+
+    if (ts.num_ints < 0) {
+      ts.num_ints = 0;
+    }
+    if (ts.num_ints > max_tag_nums) {
+      ts.num_ints = max_tag_nums;
+    }
+
+    if (ts.num_reals < 0) {
+      ts.num_reals = 0;
+    }
+    if (ts.num_reals > max_tag_nums) {
+      ts.num_reals = max_tag_nums;
+    }
+
+    if (ts.num_strings < 0) {
+      ts.num_strings = 0;
+    }
+    if (ts.num_strings > max_tag_nums) {
+      ts.num_strings = max_tag_nums;
+    }
+
+    tag.intValues.resize(static_cast<size_t>(ts.num_ints));
+
+    for (size_t i = 0; i < static_cast<size_t>(ts.num_ints); ++i) {
+      tag.intValues[i] = parseInt(&token);
+    }
+
+    tag.floatValues.resize(static_cast<size_t>(ts.num_reals));
+    for (size_t i = 0; i < static_cast<size_t>(ts.num_reals); ++i) {
+      tag.floatValues[i] = parseReal(&token);
+    }
+
+    tag.stringValues.resize(static_cast<size_t>(ts.num_strings));
+    for (size_t i = 0; i < static_cast<size_t>(ts.num_strings); ++i) {
+      tag.stringValues[i] = parseString(&token);
+    }
+
+    state->tags.push_back(tag);
+
+    return true;
+  }
+
+  if (token[0] == 's' && IS_SPACE(token[1])) {
+    // smoothing group id
+    token += 2;
+
+    // skip space.
+    token += strspn(token, " \t");  // skip space
+
+    if (token[0] == '\0') {
+      return true;
+    }
+
+    if (token[0] == '\r' || token[1] == '\n') {
+      return true;
+    }
+
+    if (strlen(token) >= 3) {
+      if (token[0] == 'o' && token[1] == 'f' && token[2] == 'f') {
+        state->current_smoothing_id = 0;
+      }
+    } else {
+      // assume number
+      int smGroupId = parseInt(&token);
+      if (smGroupId < 0) {
+        // parse error. force set to 0.
+        // FIXME(syoyo): Report warning.
+        state->current_smoothing_id = 0;
+      } else {
+        state->current_smoothing_id = static_cast<unsigned int>(smGroupId);
+      }
+    }
+
+    return true;
+  }  // smoothing group id
+
+  // Ignore unknown command.
+  return true;
+}
+
+// The end of both LoadObj and LoadObjParallel: warns about out of range
+// indices, exports the last group and moves the attributes into `attrib`.
+static void finishObjParse(ObjParseState *state, size_t line_num,
+                           bool triangulate, std::vector<real_t> *v,
+                           std::vector<real_t> *vn, std::vector<real_t> *vt,
+                           std::vector<real_t> *vc, attrib_t *attrib,
+                           std::vector<shape_t> *shapes, std::string *warn) {
+  if (state->greatest_v_idx >= static_cast<int>(v->size() / 3)) {
+    if (warn) {
+      std::stringstream ss;
+      ss << "Vertex indices out of bounds (line " << line_num << ".)\n"
+         << std::endl;
+      (*warn) += ss.str();
+    }
+  }
+  if (state->greatest_vn_idx >= static_cast<int>(vn->size() / 3)) {
+    if (warn) {
+      std::stringstream ss;
+      ss << "Vertex normal indices out of bounds (line " << line_num << ".)\n"
+         << std::endl;
+      (*warn) += ss.str();
+    }
+  }
+  if (state->greatest_vt_idx >= static_cast<int>(vt->size() / 2)) {
+    if (warn) {
+      std::stringstream ss;
+      ss << "Vertex texcoord indices out of bounds (line " << line_num << ".)\n"
+         << std::endl;
+      (*warn) += ss.str();
+    }
+  }
+
+  bool ret =
+      exportGroupsToShape(&state->shape, state->prim_group, state->tags,
+                          state->material, state->name, triangulate, *v);
+  // exportGroupsToShape return false when `usemtl` is called in the last
+  // line.
+  // we also add `shape` to `shapes` when `shape.mesh` has already some
+  // faces(indices)
+  // FIXME(syoyo): Support other prims(e.g. lines)
+  if (ret || state->shape.mesh.indices.size()) {
+    shapes->push_back(state->shape);
+  }
+  state->prim_group.clear();  // for safety
+
+  attrib->vertices.swap(*v);
+  attrib->vertex_weights.swap(*v);
+  attrib->normals.swap(*vn);
+  attrib->texcoords.swap(*vt);
+  attrib->texcoord_ws.swap(*vt);
+  attrib->colors.swap(*vc);
+}
+
 bool LoadObj(attrib_t *attrib, std::vector<shape_t> *shapes,
              std::vector<material_t> *materials, std::string *warn,
              std::string *err, std::istream *inStream,
@@ -2105,23 +2652,7 @@ bool LoadObj(attrib_t *attrib, std::vector<shape_t> *shapes,
   std::vector<real_t> vn;
   std::vector<real_t> vt;
   std::vector<real_t> vc;
-  std::vector<tag_t> tags;
-  PrimGroup prim_group;
-  std::string name;
-
-  // material
-  std::map<std::string, int> material_map;
-  int material = -1;
-
-  // smoothing group id
-  unsigned int current_smoothing_id =
-      0;  // Initial value. 0 means no smoothing.
-
-  int greatest_v_idx = -1;
-  int greatest_vn_idx = -1;
-  int greatest_vt_idx = -1;
-
-  shape_t shape;
+  ObjParseState state;
 
   bool found_all_colors = true;
 
@@ -2198,11 +2729,15 @@ bool LoadObj(attrib_t *attrib, std::vector<shape_t> *shapes,
       continue;
     }
 
-    // line
-    if (token[0] == 'l' && IS_SPACE((token[1]))) {
+    // face
+    if (token[0] == 'f' && IS_SPACE((token[1]))) {
       token += 2;
+      token += strspn(token, " \t");
+
+      face_t face;
 
-      __line_t line;
+      face.smoothing_group_id = state.current_smoothing_id;
+      face.vertex_indices.reserve(3);
 
       while (!IS_NEW_LINE(token[0])) {
         vertex_index_t vi;
@@ -2211,391 +2746,453 @@ bool LoadObj(attrib_t *attrib, std::vector<shape_t> *shapes,
                          static_cast<int>(vt.size() / 2), &vi)) {
           if (err) {
             std::stringstream ss;
-            ss << "Failed parse `l' line(e.g. zero value for vertex index. "
-                  "line "
+            ss << "Failed parse `f' line(e.g. zero value for face index. line "
                << line_num << ".)\n";
             (*err) += ss.str();
           }
           return false;
         }
 
-        line.vertex_indices.push_back(vi);
+        state.greatest_v_idx = state.greatest_v_idx > vi.v_idx
+                                   ? state.greatest_v_idx
+                                   : vi.v_idx;
+        state.greatest_vn_idx = state.greatest_vn_idx > vi.vn_idx
+                                    ? state.greatest_vn_idx
+                                    : vi.vn_idx;
+        state.greatest_vt_idx = state.greatest_vt_idx > vi.vt_idx
+                                    ? state.greatest_vt_idx
+                                    : vi.vt_idx;
 
+        face.vertex_indices.push_back(vi);
         size_t n = strspn(token, " \t\r");
         token += n;
       }
 
-      prim_group.lineGroup.push_back(line);
+      // replace with emplace_back + std::move on C++11
+      state.prim_group.faceGroup.push_back(face);
 
       continue;
     }
 
-    // points
-    if (token[0] == 'p' && IS_SPACE((token[1]))) {
-      token += 2;
-
-      __points_t pts;
-
-      while (!IS_NEW_LINE(token[0])) {
-        vertex_index_t vi;
-        if (!parseTriple(&token, static_cast<int>(v.size() / 3),
+    // everything else (lines, points, groups, materials, ...)
+    if (!parseObjCommand(token, line_num, static_cast<int>(v.size() / 3),
                          static_cast<int>(vn.size() / 3),
-                         static_cast<int>(vt.size() / 2), &vi)) {
-          if (err) {
-            std::stringstream ss;
-            ss << "Failed parse `p' line(e.g. zero value for vertex index. "
-                  "line "
-               << line_num << ".)\n";
-            (*err) += ss.str();
-          }
-          return false;
-        }
+                         static_cast<int>(vt.size() / 2), v, &state, shapes,
+                         materials, readMatFn, triangulate, warn, err)) {
+      return false;
+    }
+  }
 
-        pts.vertex_indices.push_back(vi);
-
-        size_t n = strspn(token, " \t\r");
-        token += n;
-      }
-
-      prim_group.pointsGroup.push_back(pts);
+  // not all vertices have colors, no default colors desired? -> clear colors
+  if (!found_all_colors && !default_vcols_fallback) {
+    vc.clear();
+  }
 
-      continue;
-    }
+  if (err) {
+    (*err) += errss.str();
+  }
 
-    // face
-    if (token[0] == 'f' && IS_SPACE((token[1]))) {
-      token += 2;
-      token += strspn(token, " \t");
+  finishObjParse(&state, line_num, triangulate, &v, &vn, &vt, &vc, attrib,
+                 shapes, warn);
 
-      face_t face;
+  return true;
+}
 
-      face.smoothing_group_id = current_smoothing_id;
-      face.vertex_indices.reserve(3);
+// Reads an in-memory .obj in place, for handing it to the serial loader.
+class MemoryStreamBuf : public std::streambuf {
+ public:
+  MemoryStreamBuf(const char *data, size_t size) {
+    char *begin = const_cast<char *>(data);
+    setg(begin, begin, begin + size);
+  }
+};
 
-      while (!IS_NEW_LINE(token[0])) {
-        vertex_index_t vi;
-        if (!parseTriple(&token, static_cast<int>(v.size() / 3),
-                         static_cast<int>(vn.size() / 3),
-                         static_cast<int>(vt.size() / 2), &vi)) {
-          if (err) {
-            std::stringstream ss;
-            ss << "Failed parse `f' line(e.g. zero value for face index. line "
-               << line_num << ".)\n";
-            (*err) += ss.str();
-          }
-          return false;
-        }
+// A line other than `v`, `vn`, `vt` and `f`, kept for replaying in file order
+// once every chunk is parsed.
+struct ObjChunkCommand {
+  size_t face_count;  // faces of the chunk before this line
+  size_t line_num;    // line number within the chunk
+  int v_count;        // attributes of the chunk before this line
+  int vn_count;
+  int vt_count;
+  std::string text;
+};
 
-        greatest_v_idx = greatest_v_idx > vi.v_idx ? greatest_v_idx : vi.v_idx;
-        greatest_vn_idx =
-            greatest_vn_idx > vi.vn_idx ? greatest_vn_idx : vi.vn_idx;
-        greatest_vt_idx =
-            greatest_vt_idx > vi.vt_idx ? greatest_vt_idx : vi.vt_idx;
+// A face corner with relative (negative) indices. They are resolved against
+// the chunk's own attributes, the replay adds the earlier chunks' counts.
+struct ObjChunkRelativeIndex {
+  size_t face;
+  size_t corner;
+  bool v_relative;
+  bool vn_relative;
+  bool vt_relative;
+};
 
-        face.vertex_indices.push_back(vi);
-        size_t n = strspn(token, " \t\r");
-        token += n;
-      }
+// One line-aligned piece of the file, parsed by one thread.
+struct ObjChunk {
+  const char *begin;
+  const char *end;
 
-      // replace with emplace_back + std::move on C++11
-      prim_group.faceGroup.push_back(face);
+  std::vector<real_t> v;
+  std::vector<real_t> vn;
+  std::vector<real_t> vt;
+  std::vector<real_t> vc;  // always filled, LoadObjParallel drops it if needed
+  bool found_all_colors;
+
+  std::vector<face_t> faces;
+  std::vector<ObjChunkRelativeIndex> relative_indices;
+  std::vector<ObjChunkCommand> commands;
+
+  // Greatest absolute indices used by the faces
+  int greatest_v_idx;
+  int greatest_vn_idx;
+  int greatest_vt_idx;
+
+  // Greatest absolute vertex index minus the chunk's vertex count at that
+  // face. Anything >= the earlier chunks' vertex count means a face uses a
+  // vertex defined after it.
+  int greatest_v_ahead;
+
+  size_t line_count;
+  bool failed;
+
+  // Attributes of the earlier chunks, set while concatenating
+  int v_base;
+  int vn_base;
+  int vt_base;
+
+  ObjChunk()
+      : begin(NULL),
+        end(NULL),
+        found_all_colors(true),
+        greatest_v_idx(-1),
+        greatest_vn_idx(-1),
+        greatest_vt_idx(-1),
+        greatest_v_ahead((std::numeric_limits<int>::min)()),
+        line_count(0),
+        failed(false),
+        v_base(0),
+        vn_base(0),
+        vt_base(0) {}
+};
 
-      continue;
+// Parses `v`, `vn`, `vt` and `f` lines the same way LoadObj does, and keeps
+// every other line for the replay.
+static void parseObjChunk(ObjChunk *chunk) {
+  std::string linebuf;
+  const char *p = chunk->begin;
+  while (p < chunk->end) {
+    // Same line endings as safeGetline: "\n", "\r\n" or a lone "\r"
+    const char *line_end = p;
+    while (line_end < chunk->end && *line_end != '\n' && *line_end != '\r') {
+      line_end++;
+    }
+    linebuf.assign(p, line_end);
+    p = line_end;
+    if (p < chunk->end) {
+      if (p[0] == '\r' && p + 1 < chunk->end && p[1] == '\n') p++;
+      p++;
     }
 
-    // use mtl
-    if ((0 == strncmp(token, "usemtl", 6)) && IS_SPACE((token[6]))) {
-      token += 7;
-      std::stringstream ss;
-      ss << token;
-      std::string namebuf = ss.str();
-
-      int newMaterialId = -1;
-      if (material_map.find(namebuf) != material_map.end()) {
-        newMaterialId = material_map[namebuf];
-      } else {
-        // { error!! material not found }
-      }
-
-      if (newMaterialId != material) {
-        // Create per-face material. Thus we don't add `shape` to `shapes` at
-        // this time.
-        // just clear `faceGroup` after `exportGroupsToShape()` call.
-        exportGroupsToShape(&shape, prim_group, tags, material, name,
-                            triangulate, v);
-        prim_group.faceGroup.clear();
-        material = newMaterialId;
-      }
+    chunk->line_count++;
 
+    // Skip if empty line.
+    if (linebuf.empty()) {
       continue;
     }
 
-    // load mtl
-    if ((0 == strncmp(token, "mtllib", 6)) && IS_SPACE((token[6]))) {
-      if (readMatFn) {
-        token += 7;
+    // Skip leading space.
+    const char *token = linebuf.c_str();
+    token += strspn(token, " \t");
 
-        std::vector<std::string> filenames;
-        SplitString(std::string(token), ' ', filenames);
+    assert(token);
+    if (token[0] == '\0') continue;  // empty line
 
-        if (filenames.empty()) {
-          if (warn) {
-            std::stringstream ss;
-            ss << "Looks like empty filename for mtllib. Use default "
-                  "material (line "
-               << line_num << ".)\n";
+    if (token[0] == '#') continue;  // comment line
 
-            (*warn) += ss.str();
-          }
-        } else {
-          bool found = false;
-          for (size_t s = 0; s < filenames.size(); s++) {
-            std::string warn_mtl;
-            std::string err_mtl;
-            bool ok = (*readMatFn)(filenames[s].c_str(), materials,
-                                   &material_map, &warn_mtl, &err_mtl);
-            if (warn && (!warn_mtl.empty())) {
-              (*warn) += warn_mtl;
-            }
+    // vertex
+    if (token[0] == 'v' && IS_SPACE((token[1]))) {
+      token += 2;
+      real_t x, y, z;
+      real_t r, g, b;
 
-            if (err && (!err_mtl.empty())) {
-              (*err) += err_mtl;
-            }
+      chunk->found_all_colors &=
+          parseVertexWithColor(&x, &y, &z, &r, &g, &b, &token);
 
-            if (ok) {
-              found = true;
-              break;
-            }
-          }
+      chunk->v.push_back(x);
+      chunk->v.push_back(y);
+      chunk->v.push_back(z);
 
-          if (!found) {
-            if (warn) {
-              (*warn) +=
-                  "Failed to load material file(s). Use default "
-                  "material.\n";
-            }
-          }
-        }
-      }
+      chunk->vc.push_back(r);
+      chunk->vc.push_back(g);
+      chunk->vc.push_back(b);
 
       continue;
     }
 
-    // group name
-    if (token[0] == 'g' && IS_SPACE((token[1]))) {
-      // flush previous face group.
-      bool ret = exportGroupsToShape(&shape, prim_group, tags, material, name,
-                                     triangulate, v);
-      (void)ret;  // return value not used.
-
-      if (shape.mesh.indices.size() > 0) {
-        shapes->push_back(shape);
-      }
-
-      shape = shape_t();
-
-      // material = -1;
-      prim_group.clear();
-
-      std::vector<std::string> names;
-
-      while (!IS_NEW_LINE(token[0])) {
-        std::string str = parseString(&token);
-        names.push_back(str);
-        token += strspn(token, " \t\r");  // skip tag
-      }
-
-      // names[0] must be 'g'
-
-      if (names.size() < 2) {
-        // 'g' with empty names
-        if (warn) {
-          std::stringstream ss;
-          ss << "Empty group name. line: " << line_num << "\n";
-          (*warn) += ss.str();
-          name = "";
-        }
-      } else {
-        std::stringstream ss;
-        ss << names[1];
-
-        // tinyobjloader does not support multiple groups for a primitive.
-        // Currently we concatinate multiple group names with a space to get
-        // single group name.
-
-        for (size_t i = 2; i < names.size(); i++) {
-          ss << " " << names[i];
-        }
-
-        name = ss.str();
-      }
-
+    // normal
+    if (token[0] == 'v' && token[1] == 'n' && IS_SPACE((token[2]))) {
+      token += 3;
+      real_t x, y, z;
+      parseReal3(&x, &y, &z, &token);
+      chunk->vn.push_back(x);
+      chunk->vn.push_back(y);
+      chunk->vn.push_back(z);
       continue;
     }
 
-    // object name
-    if (token[0] == 'o' && IS_SPACE((token[1]))) {
-      // flush previous face group.
-      bool ret = exportGroupsToShape(&shape, prim_group, tags, material, name,
-                                     triangulate, v);
-      if (ret) {
-        shapes->push_back(shape);
-      }
-
-      // material = -1;
-      prim_group.clear();
-      shape = shape_t();
-
-      // @todo { multiple object name? }
-      token += 2;
-      std::stringstream ss;
-      ss << token;
-      name = ss.str();
-
+    // texcoord
+    if (token[0] == 'v' && token[1] == 't' && IS_SPACE((token[2]))) {
+      token += 3;
+      real_t x, y;
+      parseReal2(&x, &y, &token);
+      chunk->vt.push_back(x);
+      chunk->vt.push_back(y);
       continue;
     }
 
-    if (token[0] == 't' && IS_SPACE(token[1])) {
-      const int max_tag_nums = 8192;  // FIXME(syoyo): Parameterize.
-      tag_t tag;
+    int v_count = static_cast<int>(chunk->v.size() / 3);
+    int vn_count = static_cast<int>(chunk->vn.size() / 3);
+    int vt_count = static_cast<int>(chunk->vt.size() / 2);
 
+    // face
+    if (token[0] == 'f' && IS_SPACE((token[1]))) {
       token += 2;
+      token += strspn(token, " \t");
 
-      tag.name = parseString(&token);
-
-      tag_sizes ts = parseTagTriple(&token);
-
-      if (ts.num_ints < 0) {
-        ts.num_ints = 0;
-      }
-      if (ts.num_ints > max_tag_nums) {
-        ts.num_ints = max_tag_nums;
-      }
-
-      if (ts.num_reals < 0) {
-        ts.num_reals = 0;
-      }
-      if (ts.num_reals > max_tag_nums) {
-        ts.num_reals = max_tag_nums;
-      }
-
-      if (ts.num_strings < 0) {
-        ts.num_strings = 0;
-      }
-      if (ts.num_strings > max_tag_nums) {
-        ts.num_strings = max_tag_nums;
-      }
+      chunk->faces.push_back(face_t());
+      face_t &face = chunk->faces.back();
+      face.vertex_indices.reserve(3);
 
-      tag.intValues.resize(static_cast<size_t>(ts.num_ints));
+      while (!IS_NEW_LINE(token[0])) {
+        const char *corner = token;
+        vertex_index_t vi;
+        if (!parseTriple(&token, v_count, vn_count, vt_count, &vi)) {
+          // LoadObj reports the error
+          chunk->failed = true;
+          return;
+        }
 
-      for (size_t i = 0; i < static_cast<size_t>(ts.num_ints); ++i) {
-        tag.intValues[i] = parseInt(&token);
-      }
+        // A relative index changes with the attribute count, an absolute one
+        // doesn't
+        ObjChunkRelativeIndex relative;
+        relative.v_relative = false;
+        relative.vn_relative = false;
+        relative.vt_relative = false;
+        if (memchr(corner, '-', static_cast<size_t>(token - corner))) {
+          vertex_index_t shifted;
+          parseTriple(&corner, v_count + 1, vn_count + 1, vt_count + 1,
+                      &shifted);
+          relative.face = chunk->faces.size() - 1;
+          relative.corner = face.vertex_indices.size();
+          relative.v_relative = shifted.v_idx != vi.v_idx;
+          relative.vn_relative = shifted.vn_idx != vi.vn_idx;
+          relative.vt_relative = shifted.vt_idx != vi.vt_idx;
+          chunk->relative_indices.push_back(relative);
+        }
 
-      tag.floatValues.resize(static_cast<size_t>(ts.num_reals));
-      for (size_t i = 0; i < static_cast<size_t>(ts.num_reals); ++i) {
-        tag.floatValues[i] = parseReal(&token);
-      }
+        if (!relative.v_relative) {
+          if (vi.v_idx > chunk->greatest_v_idx) chunk->greatest_v_idx = vi.v_idx;
+          if (vi.v_idx - v_count > chunk->greatest_v_ahead)
+            chunk->greatest_v_ahead = vi.v_idx - v_count;
+        }
+        if (!relative.vn_relative && vi.vn_idx > chunk->greatest_vn_idx)
+          chunk->greatest_vn_idx = vi.vn_idx;
+        if (!relative.vt_relative && vi.vt_idx > chunk->greatest_vt_idx)
+          chunk->greatest_vt_idx = vi.vt_idx;
 
-      tag.stringValues.resize(static_cast<size_t>(ts.num_strings));
-      for (size_t i = 0; i < static_cast<size_t>(ts.num_strings); ++i) {
-        tag.stringValues[i] = parseString(&token);
+        face.vertex_indices.push_back(vi);
+        size_t n = strspn(token, " \t\r");
+        token += n;
       }
 
-      tags.push_back(tag);
-
       continue;
     }
 
-    if (token[0] == 's' && IS_SPACE(token[1])) {
-      // smoothing group id
-      token += 2;
-
-      // skip space.
-      token += strspn(token, " \t");  // skip space
-
-      if (token[0] == '\0') {
-        continue;
-      }
+    ObjChunkCommand command;
+    command.face_count = chunk->faces.size();
+    command.line_num = chunk->line_count;
+    command.v_count = v_count;
+    command.vn_count = vn_count;
+    command.vt_count = vt_count;
+    command.text = token;
+    chunk->commands.push_back(command);
+  }
+}
 
-      if (token[0] == '\r' || token[1] == '\n') {
-        continue;
-      }
+static bool loadObjSerial(attrib_t *attrib, std::vector<shape_t> *shapes,
+                          std::vector<material_t> *materials,
+                          std::string *warn, std::string *err,
+                          const char *data, size_t size,
+                          MaterialReader *readMatFn, bool triangulate,
+                          bool default_vcols_fallback) {
+  MemoryStreamBuf buf(data, size);
+  std::istream stream(&buf);
+  return LoadObj(attrib, shapes, materials, warn, err, &stream, readMatFn,
+                 triangulate, default_vcols_fallback);
+}
 
-      if (strlen(token) >= 3) {
-        if (token[0] == 'o' && token[1] == 'f' && token[2] == 'f') {
-          current_smoothing_id = 0;
-        }
-      } else {
-        // assume number
-        int smGroupId = parseInt(&token);
-        if (smGroupId < 0) {
-          // parse error. force set to 0.
-          // FIXME(syoyo): Report warning.
-          current_smoothing_id = 0;
-        } else {
-          current_smoothing_id = static_cast<unsigned int>(smGroupId);
-        }
-      }
+bool LoadObjParallel(attrib_t *attrib, std::vector<shape_t> *shapes,
+                     std::vector<material_t> *materials, std::string *warn,
+                     std::string *err, const char *data, size_t size,
+                     MaterialReader *readMatFn /*= NULL*/, bool triangulate,
+                     bool default_vcols_fallback, unsigned int num_threads) {
+  attrib->vertices.clear();
+  attrib->normals.clear();
+  attrib->texcoords.clear();
+  attrib->colors.clear();
+  shapes->clear();
 
-      continue;
-    }  // smoothing group id
+  // Small files aren't worth starting threads for
+  const size_t min_chunk_size = 1024 * 1024;
 
-    // Ignore unknown command.
+  if (num_threads == 0) {
+    num_threads = std::thread::hardware_concurrency();
   }
+  size_t num_chunks = size / min_chunk_size;
+  if (num_chunks > num_threads) num_chunks = num_threads;
+  if (num_chunks < 1) num_chunks = 1;
 
-  // not all vertices have colors, no default colors desired? -> clear colors
-  if (!found_all_colors && !default_vcols_fallback) {
-    vc.clear();
+  // Chunks end just after a '\n', so no line is split
+  std::vector<ObjChunk> chunks(num_chunks);
+  const char *end = data + size;
+  const char *chunk_begin = data;
+  for (size_t i = 0; i < num_chunks; i++) {
+    const char *chunk_end = end;
+    if (i + 1 < num_chunks) {
+      chunk_end = data + size / num_chunks * (i + 1);
+      if (chunk_end < chunk_begin) chunk_end = chunk_begin;
+      const char *newline = static_cast<const char *>(
+          memchr(chunk_end, '\n', static_cast<size_t>(end - chunk_end)));
+      chunk_end = newline ? newline + 1 : end;
+    }
+    chunks[i].begin = chunk_begin;
+    chunks[i].end = chunk_end;
+    chunk_begin = chunk_end;
   }
 
-  if (greatest_v_idx >= static_cast<int>(v.size() / 3)) {
-    if (warn) {
-      std::stringstream ss;
-      ss << "Vertex indices out of bounds (line " << line_num << ".)\n"
-         << std::endl;
-      (*warn) += ss.str();
-    }
+  // This thread takes the first chunk
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < num_chunks; i++) {
+    workers.push_back(std::thread(parseObjChunk, &chunks[i]));
   }
-  if (greatest_vn_idx >= static_cast<int>(vn.size() / 3)) {
-    if (warn) {
-      std::stringstream ss;
-      ss << "Vertex normal indices out of bounds (line " << line_num << ".)\n"
-         << std::endl;
-      (*warn) += ss.str();
-    }
+  parseObjChunk(&chunks[0]);
+  for (size_t i = 0; i < workers.size(); i++) {
+    workers[i].join();
   }
-  if (greatest_vt_idx >= static_cast<int>(vt.size() / 2)) {
-    if (warn) {
-      std::stringstream ss;
-      ss << "Vertex texcoord indices out of bounds (line " << line_num << ".)\n"
-         << std::endl;
-      (*warn) += ss.str();
+
+  // Errors and faces using later vertices both depend on what came before,
+  // LoadObj handles those files line by line
+  long long v_total = 0;
+  for (size_t i = 0; i < num_chunks; i++) {
+    if (chunks[i].failed || chunks[i].greatest_v_ahead >= v_total) {
+      return loadObjSerial(attrib, shapes, materials, warn, err, data, size,
+                           readMatFn, triangulate, default_vcols_fallback);
     }
+    v_total += static_cast<long long>(chunks[i].v.size() / 3);
   }
 
-  bool ret = exportGroupsToShape(&shape, prim_group, tags, material, name,
-                                 triangulate, v);
-  // exportGroupsToShape return false when `usemtl` is called in the last
-  // line.
-  // we also add `shape` to `shapes` when `shape.mesh` has already some
-  // faces(indices)
-  if (ret || shape.mesh.indices
-                 .size()) {  // FIXME(syoyo): Support other prims(e.g. lines)
-    shapes->push_back(shape);
+  // Concatenate the attributes
+  size_t v_size = 0, vn_size = 0, vt_size = 0;
+  bool found_all_colors = true;
+  for (size_t i = 0; i < num_chunks; i++) {
+    v_size += chunks[i].v.size();
+    vn_size += chunks[i].vn.size();
+    vt_size += chunks[i].vt.size();
+    found_all_colors &= chunks[i].found_all_colors;
   }
-  prim_group.clear();  // for safety
 
-  if (err) {
-    (*err) += errss.str();
+  std::vector<real_t> v;
+  std::vector<real_t> vn;
+  std::vector<real_t> vt;
+  std::vector<real_t> vc;
+  v.reserve(v_size);
+  vn.reserve(vn_size);
+  vt.reserve(vt_size);
+  // not all vertices have colors, no default colors desired? -> no colors
+  bool keep_colors = found_all_colors || default_vcols_fallback;
+  if (keep_colors) vc.reserve(v_size);
+  for (size_t i = 0; i < num_chunks; i++) {
+    ObjChunk &chunk = chunks[i];
+    chunk.v_base = static_cast<int>(v.size() / 3);
+    chunk.vn_base = static_cast<int>(vn.size() / 3);
+    chunk.vt_base = static_cast<int>(vt.size() / 2);
+    v.insert(v.end(), chunk.v.begin(), chunk.v.end());
+    vn.insert(vn.end(), chunk.vn.begin(), chunk.vn.end());
+    vt.insert(vt.end(), chunk.vt.begin(), chunk.vt.end());
+    if (keep_colors) vc.insert(vc.end(), chunk.vc.begin(), chunk.vc.end());
+    std::vector<real_t>().swap(chunk.v);
+    std::vector<real_t>().swap(chunk.vn);
+    std::vector<real_t>().swap(chunk.vt);
+    std::vector<real_t>().swap(chunk.vc);
+  }
+
+  // Replay the faces and the other lines in file order, with the indices and
+  // line numbers they'd have had in LoadObj
+  ObjParseState state;
+  size_t line_num = 0;
+  for (size_t i = 0; i < num_chunks; i++) {
+    ObjChunk &chunk = chunks[i];
+    if (chunk.greatest_v_idx > state.greatest_v_idx)
+      state.greatest_v_idx = chunk.greatest_v_idx;
+    if (chunk.greatest_vn_idx > state.greatest_vn_idx)
+      state.greatest_vn_idx = chunk.greatest_vn_idx;
+    if (chunk.greatest_vt_idx > state.greatest_vt_idx)
+      state.greatest_vt_idx = chunk.greatest_vt_idx;
+
+    size_t face = 0;
+    size_t relative = 0;
+    for (size_t c = 0; c <= chunk.commands.size(); c++) {
+      size_t face_end = c < chunk.commands.size()
+                            ? chunk.commands[c].face_count
+                            : chunk.faces.size();
+      for (; face < face_end; face++) {
+        std::vector<vertex_index_t> &indices = chunk.faces[face].vertex_indices;
+        for (; relative < chunk.relative_indices.size() &&
+               chunk.relative_indices[relative].face == face;
+             relative++) {
+          const ObjChunkRelativeIndex &r = chunk.relative_indices[relative];
+          vertex_index_t &vi = indices[r.corner];
+          if (r.v_relative) {
+            vi.v_idx += chunk.v_base;
+            if (vi.v_idx > state.greatest_v_idx)
+              state.greatest_v_idx = vi.v_idx;
+          }
+          if (r.vn_relative) {
+            vi.vn_idx += chunk.vn_base;
+            if (vi.vn_idx > state.greatest_vn_idx)
+              state.greatest_vn_idx = vi.vn_idx;
+          }
+          if (r.vt_relative) {
+            vi.vt_idx += chunk.vt_base;
+            if (vi.vt_idx > state.greatest_vt_idx)
+              state.greatest_vt_idx = vi.vt_idx;
+          }
+        }
+
+        state.prim_group.faceGroup.push_back(face_t());
+        face_t &added = state.prim_group.faceGroup.back();
+        added.smoothing_group_id = state.current_smoothing_id;
+        added.vertex_indices.swap(indices);
+      }
+
+      if (c == chunk.commands.size()) break;
+
+      const ObjChunkCommand &command = chunk.commands[c];
+      if (!parseObjCommand(command.text.c_str(), line_num + command.line_num,
+                           chunk.v_base + command.v_count,
+                           chunk.vn_base + command.vn_count,
+                           chunk.vt_base + command.vt_count, v, &state, shapes,
+                           materials, readMatFn, triangulate, warn, err)) {
+        return false;
+      }
+    }
+
+    line_num += chunk.line_count;
   }
 
-  attrib->vertices.swap(v);
-  attrib->vertex_weights.swap(v);
-  attrib->normals.swap(vn);
-  attrib->texcoords.swap(vt);
-  attrib->texcoord_ws.swap(vt);
-  attrib->colors.swap(vc);
+  finishObjParse(&state, line_num, triangulate, &v, &vn, &vt, &vc, attrib,
+                 shapes, warn);
 
   return true;
 }